@@ -1,15 +1,35 @@
 // Program to test sending accelerometer data off a Photon in real time
 // Uses an Analog Devices ADXL362 SPI accelerometer (the one in the Electron Sensor Kit)
+//
+// With BINARY_OUTPUT set to 1, samples are sent at 400 Hz over USB serial as binary packets using
+// ADXL362SerialStream, instead of as text. Use host/serialreader to save them as CSV or binary:
+// ./serialreader /dev/ttyACM0 --output=capture.csv
 
 #include "Particle.h"
 
 // Accelerometer sensor file. I only implemented the parts that I needed so the library is not complete.
 #include "ADXL362DMA.h"
+#include "ADXL362SerialStream.h"
+#include "ADXL362TextFormatter.h"
+
+// 0 = print each sample as text, 1 = binary packets at 400 Hz
+#define BINARY_OUTPUT 0
 
 //
 SYSTEM_THREAD(ENABLED);
+
+#if BINARY_OUTPUT
+// Log messages would be mixed with the binary packets, so only log errors
+SerialLogHandler logHandler(LOG_LEVEL_ERROR);
+
+ADXL362SerialStream<> serialStream;
+#else
 SerialLogHandler logHandler;
 
+// Formats a whole buffer of samples as "%5d %5d %5d" lines and writes them to Serial at once
+ADXL362TextFormatter<> textFormatter;
+#endif
+
 // Number of 256 byte buffers to allocate. The more buffers, the longer network hiccup can be accommodated for.
 const size_t NUM_BUFFERS = 64;
 
@@ -47,7 +67,12 @@ void setup() {
 	// internal FIFO.
 	accel.writeFifoControlAndSamples(511, false, accel.FIFO_STREAM);
 
+#if BINARY_OUTPUT
+	accel.writeFilterControl(accel.RANGE_2G, false, false, accel.ODR_400);
+	serialStream.begin(Serial, accel);
+#else
     accel.setSampleRate(ADXL362DMA::SampleRate::RATE_3_125_HZ);
+#endif
 	accel.setMeasureMode(true);
 }
 
@@ -67,9 +92,11 @@ void loop() {
     case ADXL362DMA::STATE_READ_COMPLETE:
         // Print output
         //Log.info("bytesRead=%d numSamples=%d startOffset=%d", (int)dataBuffer.bytesRead, dataBuffer.numSamplesRead, dataBuffer.startOffset);
-        for(size_t ii = 0; ii < dataBuffer.numSamplesRead; ii++) {
-            Serial.printlnf("%5d %5d %5d", (int)dataBuffer.readX(ii), (int)dataBuffer.readY(ii), (int)dataBuffer.readZ(ii) );
-        }
+#if BINARY_OUTPUT
+        serialStream.write(dataBuffer);
+#else
+        textFormatter.write(Serial, dataBuffer);
+#endif
 
         // Fill buffer again
         dataBuffer.state = ADXL362DMA::STATE_FREE;
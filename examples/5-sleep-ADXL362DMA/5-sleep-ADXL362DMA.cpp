@@ -0,0 +1,99 @@
+// Program to test gathering accelerometer data into the FIFO while the MCU is asleep
+// Uses an Analog Devices ADXL362 SPI accelerometer (the one in the Electron Sensor Kit)
+//
+// With USE_HIBERNATE set to 0, the MCU uses ULTRA_LOW_POWER sleep, which keeps RAM and continues
+// in loop(), so the driver state in RAM is still valid and restoreState() is only used after a
+// reset. With USE_HIBERNATE set to 1, the MCU uses HIBERNATE sleep, which resets it on wake, and
+// setup() restores the driver state from retained memory instead of reconfiguring the chip.
+
+#include "Particle.h"
+
+#include "ADXL362DMA.h"
+#include "ADXL362SleepScheduler.h"
+
+//
+SYSTEM_THREAD(ENABLED);
+SYSTEM_MODE(SEMI_AUTOMATIC);
+SerialLogHandler logHandler;
+
+#define USE_HIBERNATE 0
+
+// Connect the ADXL362 breakout:
+// VIN: 3V3
+// GND: GND
+// SCL: A3 (SCK)
+// SDA: A5 (MOSI)
+// SDO: A4 (MISO)
+// CS: A2 (SS)
+// INT1: D2
+// INT2: no connection
+ADXL362DMA accel(SPI, A2);
+ADXL362SleepScheduler scheduler(accel);
+
+const pin_t INT1_PIN = D2;
+
+// The FIFO holds at most 170 XYZ samples, 1024 bytes is plenty
+ADXL362DataEx<1024> dataBuffer;
+
+// Driver state is preserved across HIBERNATE sleep and resets so the chip does not need to be reconfigured
+retained ADXL362DMA::RetainedState accelState;
+
+void setup() {
+	pinMode(INT1_PIN, INPUT);
+
+	if (!accel.restoreState(accelState)) {
+		// Cold boot
+		accel.softReset();
+		while(accel.readStatus() == 0) {
+			Log.info("no status yet, waiting for accelerometer");
+			delay(1000);
+		}
+
+		// 12.5 Hz output data rate
+		accel.writeFilterControl(accel.RANGE_2G, false, false, accel.ODR_12_5);
+
+		// Sets FIFO_STREAM mode, the watermark, and maps the watermark interrupt to INT1
+		uint32_t sleepMs = scheduler.configure(dataBuffer.bufSize, 1);
+		accel.setMeasureMode(true);
+
+		Log.info("watermark=%u samples, sleep=%lu ms, estimated duty cycle=%.4f%%", 
+			scheduler.getWatermarkSamples(), sleepMs, scheduler.getEstimatedDutyCycle() * 100.0);
+	}
+	else {
+		scheduler.calculate(dataBuffer.bufSize, accel.getStoreTemp());
+	}
+}
+
+
+void loop() {
+	scheduler.wakeStart();
+
+	// A single read drains the FIFO up to the watermark. If the FIFO has not reached the watermark,
+	// as on the first pass after a cold boot, nothing is read and we go back to sleep until INT1.
+	if (scheduler.drain(&dataBuffer)) {
+		while(dataBuffer.state == ADXL362DMA::STATE_READING_FIFO) {
+		}
+
+		if (dataBuffer.state == ADXL362DMA::STATE_READ_COMPLETE) {
+			// Process samples here
+			Log.info("read %u samples, total %lu, measured duty cycle=%.4f%%", 
+				dataBuffer.numSamplesRead, accel.getSamplesRead(), scheduler.getMeasuredDutyCycle() * 100.0);
+			dataBuffer.state = ADXL362DMA::STATE_FREE;
+		}
+	}
+
+	accel.saveState(accelState);
+	scheduler.sleepStart();
+
+	// The duration is a fallback in case the interrupt is missed; it's longer than the fill time
+	SystemSleepConfiguration config;
+#if USE_HIBERNATE
+	// Wakes by resetting, so setup() runs again and uses restoreState()
+	config.mode(SystemSleepMode::HIBERNATE)
+#else
+	config.mode(SystemSleepMode::ULTRA_LOW_POWER)
+#endif
+		.gpio(INT1_PIN, RISING)
+		.duration(scheduler.getSleepIntervalMs());
+	System.sleep(config);
+}
@@ -0,0 +1,214 @@
+// Program to test sending accelerometer data off a Photon only when something interesting happens
+// Uses an Analog Devices ADXL362 SPI accelerometer (the one in the Electron Sensor Kit)
+//
+// This is like 3-tcp-ADXL362DMA, except that each buffer goes through an ADXL362AnomalyGate.
+// Buffers that are anomalous (plus a few before and after) are sent raw, and the rest are sent
+// as 16-byte summaries. Each record starts with an ADXL362AnomalyGateBase::RecordHeader.
+
+#include "Particle.h"
+
+#include "ADXL362DMA.h"
+#include "ADXL362AnomalyGate.h"
+
+//
+SYSTEM_THREAD(ENABLED);
+SerialLogHandler logHandler;
+
+// Number of buffers to allocate. The more buffers, the longer network hiccup can be accommodated for.
+const size_t NUM_BUFFERS = 24;
+
+// Each buffer is one window for the anomaly gate: 100 samples, 0.5 seconds at 200 Hz
+const size_t BUFFER_SIZE = 600;
+
+// Finite state machine states
+enum State { STATE_CONNECT, STATE_SEND, STATE_RETRY_WAIT };
+
+// Various timeout values.
+const unsigned long retryWaitTimeMs = 2000;
+
+
+// Connect the ADXL362 breakout:
+// VIN: 3V3
+// GND: GND
+// SCL: A3 (SCK)
+// SDA: A5 (MOSI)
+// SDO: A4 (MISO)
+// CS: A2 (SS)
+// INT1: no connection
+// INT2: no connection
+ADXL362DMA accel(SPI, A2);
+
+// Send 2 windows before and 4 windows after each anomalous window
+ADXL362AnomalyGate<2> gate;
+
+size_t fillBuffer = 0;
+size_t scoreBuffer = 0;
+size_t sendBuffer = 0;
+ADXL362DataEx<BUFFER_SIZE> dataBuffers[NUM_BUFFERS];
+
+// Record being sent
+uint8_t record[sizeof(ADXL362AnomalyGateBase::RecordHeader) + sizeof(ADXL362AnomalyGateBase::Summary) + BUFFER_SIZE];
+size_t recordSize = 0;
+size_t recordSent = 0;
+
+// Set to the IP address of the server to connect to
+IPAddress serverAddr(192,168,2,6);
+const int serverPort = 7123;
+
+// Global variables
+State state = STATE_CONNECT;
+TCPClient client;
+unsigned long stateTime = 0;
+size_t totalSent;
+
+bool prepareRecord();
+
+void setup() {
+
+	accel.softReset();
+
+	while(accel.readStatus() == 0) {
+		Log.info("no status yet, waiting for device");
+		delay(1000);
+	}
+
+	// Program the accelerometer to gather samples automatically and store them in its
+	// internal FIFO.
+	accel.writeFifoControlAndSamples(511, false, accel.FIFO_STREAM);
+	accel.writeFilterControl(accel.RANGE_2G, false, false, accel.ODR_200);
+	accel.setMeasureMode(true);
+
+	gate.begin(accel.getRangeG(), 2, 4);
+	gate.setThreshold(4.0);
+}
+
+
+void loop() {
+	// Handle emptying the FIFO
+	ADXL362DataBase *data = &dataBuffers[fillBuffer % NUM_BUFFERS];
+	bool reading = (fillBuffer > 0) && (dataBuffers[(fillBuffer - 1) % NUM_BUFFERS].state == ADXL362DMA::STATE_READING_FIFO);
+	if (!reading && data->state == ADXL362DMA::STATE_FREE) {
+		// Can't query the number of entries in the FIFO if we're currently reading entries from the FIFO
+
+		// numEntries is the number of 16-byte values, not the number of bytes!
+		uint16_t numEntries = accel.readNumFifoEntries();
+		if (numEntries >= (data->bufSize / 2)) {
+			accel.readFifoAsync(data);
+			fillBuffer++;
+		}
+	}
+
+	// Score completed buffers in order. They stay in the ring until the gate decides.
+	while(scoreBuffer < fillBuffer && dataBuffers[scoreBuffer % NUM_BUFFERS].state == ADXL362DMA::STATE_READ_COMPLETE) {
+		if (!gate.add(dataBuffers[scoreBuffer % NUM_BUFFERS])) {
+			break;
+		}
+		scoreBuffer++;
+	}
+
+	// Networking state machine
+	switch(state) {
+	case STATE_CONNECT:
+		Log.info("** trying connection millis=%lu", millis());
+
+		if (!client.connect(serverAddr, serverPort)) {
+			// Connection failed
+			stateTime = millis();
+			state = STATE_RETRY_WAIT;
+			break;
+		}
+		totalSent = 0;
+		// The server reads records from the start of the connection, so resend a partially sent record in full
+		recordSent = 0;
+		state = STATE_SEND;
+		// Fall through
+
+	case STATE_SEND:
+		if (client.connected()) {
+			if (recordSize == 0 && !prepareRecord()) {
+				// No data to send yet
+				break;
+			}
+
+			int count = client.write(&record[recordSent], recordSize - recordSent);
+			if (count == -16) {
+				// Special case: Internal buffer is full, just retry at the same offset next time
+			}
+			else
+			if (count > 0) {
+				// Records are framed by their header length, so a short write sends the rest of the
+				// record next time instead of dropping it
+				totalSent += count;
+				recordSent += count;
+				if (recordSent >= recordSize) {
+					recordSize = 0;
+				}
+			}
+			else {
+				// Error
+				Log.info("** error sending error=%d totalSent=%lu millis=%lu", count, totalSent, millis());
+				client.stop();
+				stateTime = millis();
+				state = STATE_RETRY_WAIT;
+			}
+		}
+		else {
+			Log.info("** connection closed totalSent=%lu millis=%lu", totalSent, millis());
+			client.stop();
+			stateTime = millis();
+			state = STATE_RETRY_WAIT;
+		}
+		break;
+
+	case STATE_RETRY_WAIT:
+		if (millis() - stateTime > retryWaitTimeMs) {
+			// Wait a few seconds before retrying
+			state = STATE_CONNECT;
+			break;
+		}
+		break;
+	}
+
+	// While disconnected, keep the ring moving by dropping the oldest decided windows
+	if (state != STATE_SEND && (fillBuffer - sendBuffer) == NUM_BUFFERS) {
+		if (prepareRecord()) {
+			Log.info("send buffer full, discarding oldest window");
+			recordSize = 0;
+		}
+	}
+}
+
+// Builds the next record from the gate decision and frees its buffer. Returns false if there is
+// no decision yet.
+bool prepareRecord() {
+	ADXL362AnomalyGateBase::Decision decision;
+
+	if (!gate.nextDecision(decision)) {
+		return false;
+	}
+
+	ADXL362DataBase *data = &dataBuffers[sendBuffer % NUM_BUFFERS];
+
+	ADXL362AnomalyGateBase::RecordHeader header;
+	header.type = decision.forward ? ADXL362AnomalyGateBase::RECORD_RAW : ADXL362AnomalyGateBase::RECORD_SUMMARY;
+	header.reserved = 0;
+	header.length = sizeof(decision.summary) + (decision.forward ? data->bytesRead : 0);
+
+	recordSize = 0;
+	recordSent = 0;
+	memcpy(&record[recordSize], &header, sizeof(header));
+	recordSize += sizeof(header);
+	memcpy(&record[recordSize], &decision.summary, sizeof(decision.summary));
+	recordSize += sizeof(decision.summary);
+	if (decision.forward) {
+		memcpy(&record[recordSize], data->buf, data->bytesRead);
+		recordSize += data->bytesRead;
+
+		Log.info("window %lu rms=%u mg baseline=%u mg score=%.1f flags=%02x", decision.summary.sequence,
+			decision.summary.rmsMg, decision.summary.baselineMg, (float)decision.summary.score / 256.0, decision.summary.flags);
+	}
+
+	data->state = ADXL362DMA::STATE_FREE;
+	sendBuffer++;
+	return true;
+}
@@ -0,0 +1,126 @@
+#include "ADXL362Replay.h"
+
+// Replay of recorded ADXL362 FIFO data for host builds of the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+ADXL362Replay::ADXL362Replay(ADXL362Sim &sim) : sim(sim) {
+}
+
+ADXL362Replay::~ADXL362Replay() {
+	close();
+}
+
+bool ADXL362Replay::open(const char *path) {
+	close();
+
+	fp = fopen(path, "rb");
+	if (!fp) {
+		Log.error("could not open capture %s", path);
+		return false;
+	}
+
+	blockCount = blockIndex = 0;
+	bytesRead = entriesAdded = samplesAdded = 0;
+	done = false;
+	timeStarted = false;
+
+	if (!loadBlock()) {
+		Log.error("capture %s is empty", path);
+		close();
+		return false;
+	}
+
+	// Look for temperature entries in the first few samples
+	temperature = false;
+	for(size_t ii = 0; ii < blockCount && ii < 64; ii++) {
+		if ((block[ii] >> 14) == 3) {
+			temperature = true;
+			break;
+		}
+	}
+	return true;
+}
+
+void ADXL362Replay::close() {
+	if (fp) {
+		fclose(fp);
+		fp = nullptr;
+	}
+}
+
+size_t ADXL362Replay::fill() {
+	size_t added = 0;
+
+	// Leave room for one sample. In stream mode the driver treats a full FIFO as overflowed and
+	// discards its partial sample.
+	size_t maxEntries = ADXL362Sim::FIFO_SIZE - 4;
+
+	while(sim.getNumFifoEntries() < maxEntries && loadBlock()) {
+		size_t count = maxEntries - sim.getNumFifoEntries();
+		if (count > blockCount - blockIndex) {
+			count = blockCount - blockIndex;
+		}
+		for(size_t ii = 0; ii < count; ii++) {
+			if ((block[blockIndex + ii] >> 14) == 0) {
+				samplesAdded++;
+			}
+		}
+		sim.pushFifoEntries(&block[blockIndex], count);
+		blockIndex += count;
+		entriesAdded += count;
+		added += count;
+	}
+	return added;
+}
+
+void ADXL362Replay::updateTime(uint64_t nowMicros, float rateHz) {
+	if (!timeStarted) {
+		timeStarted = true;
+		startMicros = nowMicros;
+		return;
+	}
+	uint64_t due = (uint64_t)((double)(nowMicros - startMicros) * (double)rateHz / 1000000.0);
+
+	while(loadBlock()) {
+		uint16_t entry = block[blockIndex];
+		if ((entry >> 14) == 0) {
+			// An X entry starts the next sample
+			if (samplesAdded >= due) {
+				break;
+			}
+			samplesAdded++;
+		}
+		sim.pushFifoEntries(&entry, 1);
+		blockIndex++;
+		entriesAdded++;
+	}
+}
+
+bool ADXL362Replay::loadBlock() {
+	if (blockIndex < blockCount) {
+		return true;
+	}
+	if (!fp) {
+		done = true;
+		return false;
+	}
+
+	// The file is read as bytes so the byte order does not depend on the host
+	uint8_t bytes[BLOCK_ENTRIES * 2];
+	size_t count = fread(bytes, 1, sizeof(bytes), fp);
+	bytesRead += count;
+
+	blockCount = count / 2;
+	blockIndex = 0;
+	for(size_t ii = 0; ii < blockCount; ii++) {
+		block[ii] = (uint16_t)(bytes[ii * 2] | (bytes[ii * 2 + 1] << 8));
+	}
+
+	if (blockCount == 0) {
+		// End of file; an odd byte at the end is not a complete entry and is ignored
+		close();
+		done = true;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,125 @@
+#ifndef __ADXL362REPLAY_H
+#define __ADXL362REPLAY_H
+
+// Replay of recorded ADXL362 FIFO data for host builds of the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362Sim.h"
+
+/**
+ * @brief Replays a recorded raw FIFO byte stream through a simulated ADXL362
+ *
+ * A capture is the bytes read from the FIFO, exactly as returned by the device: 16-bit entries,
+ * least significant byte first, with the axis in bits 15:14. This is what is in the buffer after
+ * readFifoAsync(), from the start of the buffer (not startOffset) for bytesRead bytes, or what a
+ * logic analyzer sees on MISO after the 0x0D command. Captures with and without temperature
+ * entries both work; the driver must be configured to match (see hasTemperature()).
+ *
+ * The entries are added to the FIFO of an ADXL362Sim, so the driver reads them over the host SPI
+ * bus with the same code it uses on the device. There are two ways to feed the FIFO:
+ *
+ * - fill() adds entries until the FIFO is nearly full, without overflowing it. This fast-forwards
+ * through the capture as fast as the driver and the analysis code can read it.
+ * - updateTime() adds entries at the output data rate, counting one sample per X entry, like
+ * the device would. Use this with HostClock (real or simulated) to keep the original timing.
+ *
+ * The capture file is read in blocks, so captures can be larger than memory.
+ */
+class ADXL362Replay {
+public:
+	/**
+	 * @brief Constructor
+	 *
+	 * @param sim The simulated device to add the FIFO entries to
+	 */
+	ADXL362Replay(ADXL362Sim &sim);
+
+	/**
+	 * @brief Destructor. Closes the capture.
+	 */
+	virtual ~ADXL362Replay();
+
+	/**
+	 * @brief Open a capture file
+	 *
+	 * @return true on success. On failure, an error is logged.
+	 */
+	bool open(const char *path);
+
+	/**
+	 * @brief Close the capture file
+	 */
+	void close();
+
+	/**
+	 * @brief Returns true if the capture has temperature entries, from the first entries in the file
+	 *
+	 * Only valid after open().
+	 */
+	bool hasTemperature() const { return temperature; };
+
+	/**
+	 * @brief Add entries to the FIFO until it is within one sample of full
+	 *
+	 * @return The number of entries added. 0 means the end of the capture was reached.
+	 */
+	size_t fill();
+
+	/**
+	 * @brief Add the entries for the samples that are due at a time
+	 *
+	 * The first call sets the start time. After that, samples are added at rateHz, so if the FIFO
+	 * is not read often enough it overflows as it would on the device.
+	 *
+	 * @param nowMicros The time in microseconds, typically from HostClock
+	 *
+	 * @param rateHz The output data rate the capture was recorded at
+	 */
+	void updateTime(uint64_t nowMicros, float rateHz);
+
+	/**
+	 * @brief Returns true when all of the entries in the capture have been added to the FIFO
+	 */
+	bool isDone() const { return done; };
+
+	/**
+	 * @brief Returns the number of bytes read from the capture file
+	 */
+	uint64_t getBytesRead() const { return bytesRead; };
+
+	/**
+	 * @brief Returns the number of entries added to the FIFO
+	 */
+	uint64_t getEntriesAdded() const { return entriesAdded; };
+
+	/**
+	 * @brief Returns the number of samples (X entries) added to the FIFO
+	 */
+	uint64_t getSamplesAdded() const { return samplesAdded; };
+
+	static const size_t BLOCK_ENTRIES = 16384; //!< Entries read from the file at a time
+
+protected:
+	/**
+	 * @brief Make sure there is at least one entry in block, reading the next block if necessary
+	 *
+	 * @return false at the end of the capture
+	 */
+	bool loadBlock();
+
+	ADXL362Sim &sim; //!< Device to add entries to
+	FILE *fp = nullptr; //!< Capture file
+	uint16_t block[BLOCK_ENTRIES]; //!< Entries read from the file
+	size_t blockCount = 0; //!< Number of entries in block
+	size_t blockIndex = 0; //!< Next entry in block
+	bool temperature = false; //!< Capture has temperature entries
+	bool done = false; //!< End of capture reached
+	bool timeStarted = false; //!< updateTime() has been called
+	uint64_t startMicros = 0; //!< Time of the first updateTime() call
+	uint64_t bytesRead = 0; //!< Bytes read from the file
+	uint64_t entriesAdded = 0; //!< Entries added to the FIFO
+	uint64_t samplesAdded = 0; //!< X entries added to the FIFO
+};
+
+#endif /* __ADXL362REPLAY_H */
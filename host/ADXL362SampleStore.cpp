@@ -0,0 +1,602 @@
+#include "ADXL362SampleStore.h"
+#include "ADXL362SerialStream.h"
+
+// Per-device time-series storage for host builds of the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+static_assert(sizeof(ADXL362SampleStore::ChunkHeader) == 32, "ChunkHeader must be 32 bytes");
+
+// Columns in a compressed chunk, in order
+static int16_t ADXL362Sample::*const sampleColumns[4] = { &ADXL362Sample::x, &ADXL362Sample::y, &ADXL362Sample::z, &ADXL362Sample::t };
+
+// Time of sample index in a chunk or packet that starts at firstTimeUs
+static uint64_t sampleTimeUs(uint64_t firstTimeUs, size_t index, uint16_t rateTenthsHz) {
+	return firstTimeUs + (uint64_t)index * 10000000 / rateTenthsHz;
+}
+
+ADXL362SampleStore::ADXL362SampleStore() {
+}
+
+ADXL362SampleStore::~ADXL362SampleStore() {
+	close();
+}
+
+void ADXL362SampleStore::setChunkSamples(size_t samples) {
+	if (samples < 1) {
+		samples = 1;
+	}
+	if (samples > MAX_CHUNK_SAMPLES) {
+		samples = MAX_CHUNK_SAMPLES;
+	}
+	chunkSamples = samples;
+}
+
+void ADXL362SampleStore::setWriteBufferSize(size_t size) {
+	if (size < MIN_WRITE_BUFFER_SIZE) {
+		size = MIN_WRITE_BUFFER_SIZE;
+	}
+	writeBufferSize = (size + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+}
+
+bool ADXL362SampleStore::open(const char *dir) {
+	close();
+
+	this->dir = dir;
+	if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+		Log.error("could not create store directory %s: %s", dir, strerror(errno));
+		return false;
+	}
+
+	DIR *dp = opendir(dir);
+	if (!dp) {
+		Log.error("could not open store directory %s: %s", dir, strerror(errno));
+		return false;
+	}
+
+	std::vector<uint64_t> partitions;
+	struct dirent *ent;
+	while((ent = readdir(dp)) != nullptr) {
+		char *end;
+		unsigned long long partition = strtoull(ent->d_name, &end, 10);
+		if (end != ent->d_name && strcmp(end, ".a362") == 0) {
+			partitions.push_back(partition);
+		}
+	}
+	closedir(dp);
+
+	stats = Stats();
+	for(uint64_t partition : partitions) {
+		segmentEnds[partition] = scanSegment(partition);
+	}
+
+	isOpen = true;
+	return true;
+}
+
+void ADXL362SampleStore::close() {
+	if (!isOpen) {
+		return;
+	}
+	flush();
+
+	for(auto &it : segments) {
+		closeSegment(it.first, it.second);
+	}
+	segments.clear();
+	openChunks.clear();
+	segmentEnds.clear();
+	index.clear();
+	maxChunkSpanUs.clear();
+	isOpen = false;
+}
+
+bool ADXL362SampleStore::append(const char *deviceId, uint64_t firstTimeUs, uint32_t firstSample, uint16_t rateTenthsHz, uint8_t rangeG, bool hasTemp, const ADXL362Sample *samples, size_t numSamples) {
+	size_t idLen = deviceId ? strlen(deviceId) : 0;
+	if (!isOpen || idLen == 0 || idLen > MAX_DEVICE_ID_LEN || rateTenthsHz == 0) {
+		return false;
+	}
+
+	OpenChunk &chunk = openChunks[deviceId];
+
+	size_t done = 0;
+	while(done < numSamples) {
+		uint64_t timeUs = sampleTimeUs(firstTimeUs, done, rateTenthsHz);
+		uint32_t sampleNum = firstSample + (uint32_t)done;
+		uint64_t partition = partitionForTime(timeUs);
+
+		if (!chunk.samples.empty()) {
+			bool follows = chunk.firstSample + (uint32_t)chunk.samples.size() == sampleNum &&
+				chunk.rateTenthsHz == rateTenthsHz && chunk.rangeG == rangeG && chunk.hasTemp == hasTemp &&
+				chunk.partition == partition && chunk.samples.size() < chunkSamples;
+			if (!follows) {
+				seal(deviceId, chunk);
+			}
+		}
+		if (chunk.samples.empty()) {
+			chunk.firstTimeUs = timeUs;
+			chunk.openedUs = lastTickUs;
+			chunk.partition = partition;
+			chunk.firstSample = sampleNum;
+			chunk.rateTenthsHz = rateTenthsHz;
+			chunk.rangeG = rangeG;
+			chunk.hasTemp = hasTemp;
+		}
+
+		// The chunk ends at chunkSamples or at the first sample in the next partition
+		uint64_t partitionEndUs = (chunk.partition + partitionSeconds) * 1000000;
+		uint64_t untilEnd = ((partitionEndUs - chunk.firstTimeUs) * rateTenthsHz + 9999999) / 10000000;
+		size_t limit = (untilEnd < chunkSamples) ? (size_t)untilEnd : chunkSamples;
+
+		size_t count = (limit > chunk.samples.size()) ? limit - chunk.samples.size() : 0;
+		if (count == 0) {
+			seal(deviceId, chunk);
+			continue;
+		}
+		if (count > numSamples - done) {
+			count = numSamples - done;
+		}
+		chunk.samples.insert(chunk.samples.end(), &samples[done], &samples[done + count]);
+		done += count;
+	}
+	stats.samples += numSamples;
+
+	return true;
+}
+
+void ADXL362SampleStore::tick(uint64_t nowUs) {
+	lastTickUs = nowUs;
+
+	for(auto &it : openChunks) {
+		if (!it.second.samples.empty() && nowUs - it.second.openedUs >= maxChunkAgeUs) {
+			seal(it.first, it.second);
+		}
+	}
+
+	for(auto it = segments.begin(); it != segments.end(); ) {
+		Segment &segment = it->second;
+		if (segment.bufLen > segment.writtenLen && nowUs - segment.lastWriteUs >= flushIntervalUs) {
+			writeSegment(it->first, segment);
+		}
+
+		// Close segments for past partitions once no open chunk can be sealed into them
+		uint64_t partitionEndUs = (it->first + partitionSeconds) * 1000000;
+		bool inUse = nowUs < partitionEndUs + maxChunkAgeUs + flushIntervalUs;
+		for(auto &chunkIt : openChunks) {
+			if (!chunkIt.second.samples.empty() && chunkIt.second.partition == it->first) {
+				inUse = true;
+			}
+		}
+		if (!inUse) {
+			closeSegment(it->first, segment);
+			it = segments.erase(it);
+		}
+		else {
+			it++;
+		}
+	}
+}
+
+bool ADXL362SampleStore::flush() {
+	bool result = true;
+
+	for(auto &it : openChunks) {
+		seal(it.first, it.second);
+	}
+	for(auto &it : segments) {
+		if (!writeSegment(it.first, it.second)) {
+			result = false;
+		}
+	}
+	return result;
+}
+
+size_t ADXL362SampleStore::query(const char *deviceId, uint64_t fromUs, uint64_t toUs, SampleCallback callback) const {
+	auto indexIt = index.find(deviceId);
+	if (indexIt == index.end()) {
+		return 0;
+	}
+	const std::vector<IndexEntry> &entries = indexIt->second;
+
+	// Chunks that start up to the longest chunk before fromUs can contain samples in the range
+	uint64_t span = maxChunkSpanUs.at(deviceId);
+	uint64_t startUs = (fromUs > span) ? fromUs - span : 0;
+	auto entryIt = std::lower_bound(entries.begin(), entries.end(), startUs, [](const IndexEntry &e, uint64_t t) {
+		return e.firstTimeUs < t;
+	});
+
+	size_t count = 0;
+	int fd = -1;
+	uint64_t fdPartition = 0;
+	std::vector<uint8_t> chunkBuf;
+	std::vector<ADXL362Sample> samples;
+
+	for(; entryIt != entries.end() && entryIt->firstTimeUs <= toUs; entryIt++) {
+		const IndexEntry &entry = *entryIt;
+		if (entry.lastTimeUs < fromUs) {
+			continue;
+		}
+
+		if (fd < 0 || fdPartition != entry.partition) {
+			if (fd >= 0) {
+				::close(fd);
+			}
+			fdPartition = entry.partition;
+			fd = ::open(segmentPath(entry.partition).c_str(), O_RDONLY);
+			if (fd < 0) {
+				Log.error("could not open segment %s: %s", segmentPath(entry.partition).c_str(), strerror(errno));
+				continue;
+			}
+		}
+
+		chunkBuf.resize(entry.size);
+		if (pread(fd, chunkBuf.data(), entry.size, (off_t)entry.offset) != (ssize_t)entry.size) {
+			Log.error("could not read chunk at %llu in segment %llu", (unsigned long long)entry.offset, (unsigned long long)entry.partition);
+			continue;
+		}
+
+		ChunkHeader header;
+		memcpy(&header, chunkBuf.data(), sizeof(header));
+		const uint8_t *payload = chunkBuf.data() + header.headerSize;
+		if (header.magic != CHUNK_MAGIC || (size_t)header.headerSize + header.payloadSize != entry.size ||
+			ADXL362SerialStreamBase::crc16(payload, header.payloadSize) != header.payloadCrc) {
+			Log.error("corrupt chunk at %llu in segment %llu", (unsigned long long)entry.offset, (unsigned long long)entry.partition);
+			continue;
+		}
+
+		samples.resize(header.numSamples);
+		if (!decodeSamples(payload, header.payloadSize, header.numSamples, (header.flags & FLAG_TEMP) != 0, samples.data())) {
+			Log.error("could not decompress chunk at %llu in segment %llu", (unsigned long long)entry.offset, (unsigned long long)entry.partition);
+			continue;
+		}
+
+		for(size_t ii = 0; ii < header.numSamples; ii++) {
+			uint64_t timeUs = sampleTimeUs(header.firstTimeUs, ii, header.rateTenthsHz);
+			if (timeUs >= fromUs && timeUs <= toUs) {
+				callback(timeUs, header.firstSample + (uint32_t)ii, samples[ii]);
+				count++;
+			}
+		}
+	}
+	if (fd >= 0) {
+		::close(fd);
+	}
+
+	return count;
+}
+
+std::vector<std::string> ADXL362SampleStore::getDeviceIds() const {
+	std::vector<std::string> result;
+	for(const auto &it : index) {
+		result.push_back(it.first);
+	}
+	return result;
+}
+
+const std::vector<ADXL362SampleStore::IndexEntry> *ADXL362SampleStore::getIndex(const char *deviceId) const {
+	auto it = index.find(deviceId);
+	return (it != index.end()) ? &it->second : nullptr;
+}
+
+// [static]
+size_t ADXL362SampleStore::encodeSamples(const ADXL362Sample *samples, size_t numSamples, bool hasTemp, uint8_t *out) {
+	uint8_t *p = out;
+
+	for(size_t col = 0; col < (hasTemp ? 4 : 3); col++) {
+		int16_t ADXL362Sample::*column = sampleColumns[col];
+		int32_t prev = 0;
+
+		for(size_t ii = 0; ii < numSamples; ii++) {
+			int32_t value = samples[ii].*column;
+			int32_t delta = value - prev;
+			prev = value;
+
+			// Zigzag puts small negative and positive differences in the low bits
+			uint32_t zz = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+			while(zz >= 0x80) {
+				*p++ = (uint8_t)(zz | 0x80);
+				zz >>= 7;
+			}
+			*p++ = (uint8_t)zz;
+		}
+	}
+	return p - out;
+}
+
+// [static]
+bool ADXL362SampleStore::decodeSamples(const uint8_t *in, size_t len, size_t numSamples, bool hasTemp, ADXL362Sample *samples) {
+	const uint8_t *p = in;
+	const uint8_t *end = in + len;
+
+	for(size_t col = 0; col < 4; col++) {
+		int16_t ADXL362Sample::*column = sampleColumns[col];
+		if (col == 3 && !hasTemp) {
+			for(size_t ii = 0; ii < numSamples; ii++) {
+				samples[ii].*column = 0;
+			}
+			break;
+		}
+
+		int32_t prev = 0;
+		for(size_t ii = 0; ii < numSamples; ii++) {
+			uint32_t zz = 0;
+			for(int shift = 0; ; shift += 7) {
+				if (p >= end || shift > 14) {
+					return false;
+				}
+				uint8_t b = *p++;
+				zz |= (uint32_t)(b & 0x7f) << shift;
+				if ((b & 0x80) == 0) {
+					break;
+				}
+			}
+			int32_t value = prev + ((int32_t)(zz >> 1) ^ -(int32_t)(zz & 1));
+			if (value < -32768 || value > 32767) {
+				return false;
+			}
+			samples[ii].*column = (int16_t)value;
+			prev = value;
+		}
+	}
+	return p == end;
+}
+
+std::string ADXL362SampleStore::segmentPath(uint64_t partition) const {
+	char name[32];
+	snprintf(name, sizeof(name), "/%llu.a362", (unsigned long long)partition);
+	return dir + name;
+}
+
+void ADXL362SampleStore::seal(const std::string &deviceId, OpenChunk &chunk) {
+	if (chunk.samples.empty()) {
+		return;
+	}
+	size_t numSamples = chunk.samples.size();
+
+	encodeBuf.resize(maxEncodedSize(numSamples));
+	size_t payloadSize = encodeSamples(chunk.samples.data(), numSamples, chunk.hasTemp, encodeBuf.data());
+
+	ChunkHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = CHUNK_MAGIC;
+	header.headerSize = (uint16_t)(sizeof(header) + deviceId.size());
+	header.numSamples = (uint16_t)numSamples;
+	header.payloadSize = (uint32_t)payloadSize;
+	header.firstTimeUs = chunk.firstTimeUs;
+	header.firstSample = chunk.firstSample;
+	header.rateTenthsHz = chunk.rateTenthsHz;
+	header.rangeG = chunk.rangeG;
+	header.flags = chunk.hasTemp ? FLAG_TEMP : 0;
+	header.payloadCrc = ADXL362SerialStreamBase::crc16(encodeBuf.data(), payloadSize);
+	header.deviceIdLen = (uint8_t)deviceId.size();
+
+	size_t chunkSize = header.headerSize + payloadSize;
+
+	Segment *segment = getSegment(chunk.partition);
+	if (segment && writeBufferSize - segment->bufLen < chunkSize) {
+		writeSegment(chunk.partition, *segment);
+	}
+	if (!segment || writeBufferSize - segment->bufLen < chunkSize) {
+		// Can't open the segment, or writes are failing so the buffer didn't empty
+		Log.error("dropped %u samples from %s", (unsigned)numSamples, deviceId.c_str());
+		chunk.samples.clear();
+		return;
+	}
+
+	IndexEntry entry;
+	entry.firstTimeUs = chunk.firstTimeUs;
+	entry.lastTimeUs = sampleTimeUs(chunk.firstTimeUs, numSamples - 1, chunk.rateTenthsHz);
+	entry.partition = chunk.partition;
+	entry.offset = segment->fileOffset + segment->bufLen;
+	entry.size = (uint32_t)chunkSize;
+	entry.firstSample = chunk.firstSample;
+	entry.numSamples = (uint16_t)numSamples;
+	entry.rateTenthsHz = chunk.rateTenthsHz;
+
+	uint8_t *p = &segment->buf[segment->bufLen];
+	memcpy(p, &header, sizeof(header));
+	memcpy(p + sizeof(header), deviceId.data(), deviceId.size());
+	memcpy(p + header.headerSize, encodeBuf.data(), payloadSize);
+	segment->bufLen += chunkSize;
+
+	addToIndex(deviceId, entry);
+
+	stats.chunks++;
+	stats.sealedSamples += numSamples;
+	stats.rawBytes += numSamples * (chunk.hasTemp ? 8 : 6);
+	stats.chunkBytes += chunkSize;
+
+	chunk.samples.clear();
+}
+
+ADXL362SampleStore::Segment *ADXL362SampleStore::getSegment(uint64_t partition) {
+	auto it = segments.find(partition);
+	if (it != segments.end()) {
+		return &it->second;
+	}
+
+	std::string path = segmentPath(partition);
+	Segment segment;
+
+	if (directIO) {
+		segment.fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+		segment.directIO = (segment.fd >= 0);
+	}
+	if (segment.fd < 0) {
+		// Not requested, or not supported by the file system
+		segment.fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	}
+	if (segment.fd < 0) {
+		Log.error("could not open segment %s: %s", path.c_str(), strerror(errno));
+		return nullptr;
+	}
+	usingDirectIO = segment.directIO;
+
+	void *buf;
+	if (posix_memalign(&buf, BLOCK_SIZE, writeBufferSize) != 0) {
+		::close(segment.fd);
+		return nullptr;
+	}
+	segment.buf = (uint8_t *)buf;
+
+	// Continue after the last chunk of an existing segment, starting with its partial block
+	uint64_t end = 0;
+	auto endIt = segmentEnds.find(partition);
+	if (endIt != segmentEnds.end()) {
+		end = endIt->second;
+	}
+	segment.fileOffset = end / BLOCK_SIZE * BLOCK_SIZE;
+	segment.bufLen = segment.writtenLen = (size_t)(end - segment.fileOffset);
+	if (segment.bufLen) {
+		if (pread(segment.fd, segment.buf, BLOCK_SIZE, (off_t)segment.fileOffset) < (ssize_t)segment.bufLen) {
+			Log.error("could not read segment %s: %s", path.c_str(), strerror(errno));
+			::close(segment.fd);
+			free(segment.buf);
+			return nullptr;
+		}
+	}
+	segment.lastWriteUs = lastTickUs;
+
+	return &(segments[partition] = segment);
+}
+
+bool ADXL362SampleStore::writeSegment(uint64_t partition, Segment &segment) {
+	segment.lastWriteUs = lastTickUs;
+	if (segment.bufLen == segment.writtenLen) {
+		return true;
+	}
+
+	// Whole blocks, with the partial block at the end padded with zeros
+	size_t len = (segment.bufLen + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+	memset(&segment.buf[segment.bufLen], 0, len - segment.bufLen);
+
+	ssize_t result = pwrite(segment.fd, segment.buf, len, (off_t)segment.fileOffset);
+	if (result < 0 && errno == EINVAL && segment.directIO) {
+		// Some file systems allow opening with O_DIRECT but not writing with it
+		int fd = ::open(segmentPath(partition).c_str(), O_RDWR);
+		if (fd >= 0) {
+			::close(segment.fd);
+			segment.fd = fd;
+			segment.directIO = usingDirectIO = false;
+			result = pwrite(segment.fd, segment.buf, len, (off_t)segment.fileOffset);
+		}
+	}
+	if (result != (ssize_t)len) {
+		Log.error("could not write segment %s: %s", segmentPath(partition).c_str(), (result < 0) ? strerror(errno) : "short write");
+		stats.writeErrors++;
+		return false;
+	}
+	stats.writes++;
+	stats.bytesWritten += len;
+
+	size_t fullLen = segment.bufLen / BLOCK_SIZE * BLOCK_SIZE;
+	memmove(segment.buf, &segment.buf[fullLen], segment.bufLen - fullLen);
+	segment.fileOffset += fullLen;
+	segment.bufLen -= fullLen;
+	segment.writtenLen = segment.bufLen;
+
+	return true;
+}
+
+void ADXL362SampleStore::closeSegment(uint64_t partition, Segment &segment) {
+	writeSegment(partition, segment);
+
+	uint64_t end = segment.fileOffset + segment.bufLen;
+	segmentEnds[partition] = end;
+	if (ftruncate(segment.fd, (off_t)end) != 0 || fdatasync(segment.fd) != 0) {
+		Log.error("could not sync segment %s: %s", segmentPath(partition).c_str(), strerror(errno));
+	}
+	::close(segment.fd);
+	free(segment.buf);
+	segment.fd = -1;
+	segment.buf = nullptr;
+}
+
+uint64_t ADXL362SampleStore::scanSegment(uint64_t partition) {
+	std::string path = segmentPath(partition);
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		Log.error("could not open segment %s: %s", path.c_str(), strerror(errno));
+		return 0;
+	}
+
+	struct stat sb;
+	uint64_t fileSize = (fstat(fd, &sb) == 0) ? (uint64_t)sb.st_size : 0;
+
+	// Read in large blocks; only the headers are needed, but chunks are small
+	std::vector<uint8_t> buf(1024 * 1024);
+	uint64_t bufOffset = 0;
+	size_t bufLen = 0;
+
+	uint64_t offset = 0;
+	while(true) {
+		size_t need = sizeof(ChunkHeader) + MAX_DEVICE_ID_LEN;
+		if (offset < bufOffset || offset + need > bufOffset + bufLen) {
+			ssize_t count = pread(fd, buf.data(), buf.size(), (off_t)offset);
+			if (count < (ssize_t)sizeof(ChunkHeader)) {
+				break;
+			}
+			bufOffset = offset;
+			bufLen = (size_t)count;
+		}
+
+		ChunkHeader header;
+		const uint8_t *p = &buf[offset - bufOffset];
+		memcpy(&header, p, sizeof(header));
+
+		// Zeros after the last chunk, or a chunk that was not completely written
+		if (header.magic != CHUNK_MAGIC || header.deviceIdLen == 0 || header.deviceIdLen > MAX_DEVICE_ID_LEN ||
+			header.headerSize != sizeof(header) + header.deviceIdLen || header.numSamples == 0 ||
+			header.numSamples > MAX_CHUNK_SAMPLES || header.payloadSize > maxEncodedSize(header.numSamples) ||
+			header.rateTenthsHz == 0 || offset + header.headerSize > bufOffset + bufLen) {
+			break;
+		}
+
+		uint64_t chunkSize = header.headerSize + header.payloadSize;
+		if (offset + chunkSize > fileSize) {
+			break;
+		}
+
+		IndexEntry entry;
+		entry.firstTimeUs = header.firstTimeUs;
+		entry.lastTimeUs = sampleTimeUs(header.firstTimeUs, header.numSamples - 1, header.rateTenthsHz);
+		entry.partition = partition;
+		entry.offset = offset;
+		entry.size = (uint32_t)chunkSize;
+		entry.firstSample = header.firstSample;
+		entry.numSamples = header.numSamples;
+		entry.rateTenthsHz = header.rateTenthsHz;
+		addToIndex(std::string((const char *)p + sizeof(header), header.deviceIdLen), entry);
+
+		offset += chunkSize;
+	}
+	::close(fd);
+
+	return offset;
+}
+
+void ADXL362SampleStore::addToIndex(const std::string &deviceId, const IndexEntry &entry) {
+	std::vector<IndexEntry> &entries = index[deviceId];
+
+	if (entries.empty() || entry.firstTimeUs >= entries.back().firstTimeUs) {
+		entries.push_back(entry);
+	}
+	else {
+		auto it = std::upper_bound(entries.begin(), entries.end(), entry.firstTimeUs, [](uint64_t t, const IndexEntry &e) {
+			return t < e.firstTimeUs;
+		});
+		entries.insert(it, entry);
+	}
+
+	uint64_t &span = maxChunkSpanUs[deviceId];
+	if (entry.lastTimeUs - entry.firstTimeUs > span) {
+		span = entry.lastTimeUs - entry.firstTimeUs;
+	}
+}
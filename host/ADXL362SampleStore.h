@@ -0,0 +1,357 @@
+#ifndef __ADXL362SAMPLESTORE_H
+#define __ADXL362SAMPLESTORE_H
+
+// Per-device time-series storage for host builds of the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "Particle.h"
+#include "ADXL362DMA.h"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Stores samples from many devices in time-partitioned, compressed chunks
+ *
+ * Samples are appended per device into an open chunk of consecutive samples (same sample
+ * numbering, rate, and range). A chunk is sealed when it has setChunkSamples() samples, when there
+ * is a gap in the sample numbers, when it reaches the end of a time partition, or when it is older
+ * than setMaxChunkAgeMs(). Sealing compresses the chunk and adds it to the write buffer of the
+ * segment file for its time partition, and adds it to the in-memory index.
+ *
+ * Chunks are compressed by column: all of the X values, then Y, Z, and temperature (if stored),
+ * each as the zigzag-encoded difference from the previous value in LEB128 varints. Accelerometer
+ * data changes little between samples, so most values take one byte instead of two.
+ *
+ * The segment for a partition is `<dir>/<partition start, in seconds since 1970>.a362`. It's a
+ * sequence of chunks, each a ChunkHeader, the device ID, and the compressed samples; chunks from
+ * all of the devices are mixed. The write buffer is written when it fills up and at
+ * setFlushIntervalMs(), in whole 4096 byte blocks at block-aligned offsets, so the file can be
+ * opened with O_DIRECT. A partial block at the end is written padded with zeros, and written again
+ * with more data on the next write. If O_DIRECT is not supported (tmpfs, for example) or is turned
+ * off with setDirectIO(), the same writes are made through the page cache.
+ *
+ * The index is rebuilt when the store is opened by reading the chunk headers of the segments.
+ *
+ * Times are in microseconds since 1970. The time of sample i in a chunk is the time of its first
+ * sample plus i sample periods at the output data rate.
+ */
+class ADXL362SampleStore {
+public:
+	/**
+	 * @brief Header of a chunk in a segment file, little endian, followed by the device ID and the payload
+	 */
+	struct ChunkHeader {
+		uint32_t magic;			//!< CHUNK_MAGIC
+		uint16_t headerSize;	//!< sizeof(ChunkHeader) plus the device ID
+		uint16_t numSamples;	//!< Samples in the chunk
+		uint32_t payloadSize;	//!< Bytes of compressed samples after the device ID
+		uint64_t firstTimeUs;	//!< Time of the first sample
+		uint32_t firstSample;	//!< Sample number of the first sample, from the device
+		uint16_t rateTenthsHz;	//!< Output data rate in 0.1 Hz units
+		uint8_t rangeG;			//!< Range in g (2, 4, or 8)
+		uint8_t flags;			//!< FLAG_TEMP if the samples include temperature
+		uint16_t payloadCrc;	//!< CRC-16/CCITT of the payload
+		uint8_t deviceIdLen;	//!< Bytes of device ID after the header
+		uint8_t reserved;		//!< Always 0
+	} __attribute__((packed));
+
+	/**
+	 * @brief Index entry for one chunk
+	 */
+	struct IndexEntry {
+		uint64_t firstTimeUs;	//!< Time of the first sample
+		uint64_t lastTimeUs;	//!< Time of the last sample
+		uint64_t partition;		//!< Partition (segment) start time in seconds
+		uint64_t offset;		//!< Offset of the ChunkHeader in the segment
+		uint32_t size;			//!< Bytes in the chunk, including the header and device ID
+		uint32_t firstSample;	//!< Sample number of the first sample
+		uint16_t numSamples;	//!< Samples in the chunk
+		uint16_t rateTenthsHz;	//!< Output data rate in 0.1 Hz units
+	};
+
+	/**
+	 * @brief Counters since open()
+	 */
+	struct Stats {
+		uint64_t samples = 0;		//!< Samples appended
+		uint64_t chunks = 0;		//!< Chunks sealed
+		uint64_t sealedSamples = 0;	//!< Samples in the sealed chunks
+		uint64_t rawBytes = 0;		//!< Size of the sealed samples as int16_t values (6 or 8 bytes each)
+		uint64_t chunkBytes = 0;	//!< Size of the sealed chunks, including headers
+		uint64_t writes = 0;		//!< Write calls to segment files
+		uint64_t bytesWritten = 0;	//!< Bytes written to segment files, including rewritten partial blocks
+		uint64_t writeErrors = 0;	//!< Failed writes
+	};
+
+	/**
+	 * @brief Called by query() for each sample
+	 */
+	typedef std::function<void(uint64_t timeUs, uint32_t sampleNum, const ADXL362Sample &sample)> SampleCallback;
+
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362SampleStore();
+
+	/**
+	 * @brief Destructor. Closes the store.
+	 */
+	virtual ~ADXL362SampleStore();
+
+	/**
+	 * @brief Set the length of a time partition (default: 3600 seconds)
+	 *
+	 * Must be set before open(). Opening existing segments with a different setting works, but
+	 * chunks are then added to segments by the new partition length.
+	 */
+	void setPartitionSeconds(uint32_t seconds) { partitionSeconds = seconds ? seconds : 1; };
+
+	/**
+	 * @brief Set the maximum samples in a chunk (default: 4096, maximum: MAX_CHUNK_SAMPLES)
+	 */
+	void setChunkSamples(size_t samples);
+
+	/**
+	 * @brief Set how long a chunk can stay open before it is sealed (default: 30000 ms)
+	 *
+	 * Samples in open chunks are only in memory, so this limits what is lost if the process stops.
+	 */
+	void setMaxChunkAgeMs(uint32_t ms) { maxChunkAgeUs = (uint64_t)ms * 1000; };
+
+	/**
+	 * @brief Set how often a segment's write buffer is written when it's not full (default: 1000 ms)
+	 */
+	void setFlushIntervalMs(uint32_t ms) { flushIntervalUs = (uint64_t)ms * 1000; };
+
+	/**
+	 * @brief Set the size of each segment's write buffer (default: 1 MB, minimum: MIN_WRITE_BUFFER_SIZE)
+	 *
+	 * Must be set before open().
+	 */
+	void setWriteBufferSize(size_t size);
+
+	/**
+	 * @brief Set whether to open segments with O_DIRECT (default: true)
+	 *
+	 * Must be set before open().
+	 */
+	void setDirectIO(bool directIO) { this->directIO = directIO; };
+
+	/**
+	 * @brief Open a store, creating the directory if necessary, and build the index
+	 *
+	 * @return true on success. On failure, an error is logged.
+	 */
+	bool open(const char *dir);
+
+	/**
+	 * @brief Seal the open chunks, write all buffers, and close the segments
+	 */
+	void close();
+
+	/**
+	 * @brief Append consecutive samples from a device
+	 *
+	 * @param deviceId Device ID, up to MAX_DEVICE_ID_LEN characters
+	 *
+	 * @param firstTimeUs Time of samples[0], in microseconds since 1970
+	 *
+	 * @param firstSample Sample number of samples[0]. If it does not follow the last sample appended
+	 * for this device, a new chunk is started.
+	 *
+	 * @param rateTenthsHz Output data rate in 0.1 Hz units (4000 = 400 Hz)
+	 *
+	 * @param rangeG Range in g (2, 4, or 8)
+	 *
+	 * @param hasTemp true if the samples include temperature
+	 *
+	 * @param samples The samples
+	 *
+	 * @param numSamples Number of samples
+	 *
+	 * @return false if the parameters are not valid
+	 */
+	bool append(const char *deviceId, uint64_t firstTimeUs, uint32_t firstSample, uint16_t rateTenthsHz, uint8_t rangeG, bool hasTemp, const ADXL362Sample *samples, size_t numSamples);
+
+	/**
+	 * @brief Seal old chunks and write buffers that are due. Call this often, such as every 100 ms.
+	 *
+	 * @param nowUs The current time in microseconds since 1970
+	 */
+	void tick(uint64_t nowUs);
+
+	/**
+	 * @brief Seal all open chunks and write all buffers
+	 *
+	 * @return false if a write failed
+	 */
+	bool flush();
+
+	/**
+	 * @brief Read the samples for a device in a time range
+	 *
+	 * Only samples that have been written to the segment files are returned; call flush() first to
+	 * include the most recent samples.
+	 *
+	 * @param deviceId The device ID
+	 *
+	 * @param fromUs Start of the time range, inclusive
+	 *
+	 * @param toUs End of the time range, inclusive
+	 *
+	 * @param callback Called for each sample, in time order within each chunk, and chunks in order of
+	 * their first sample
+	 *
+	 * @return The number of samples
+	 */
+	size_t query(const char *deviceId, uint64_t fromUs, uint64_t toUs, SampleCallback callback) const;
+
+	/**
+	 * @brief Returns the IDs of the devices in the index
+	 */
+	std::vector<std::string> getDeviceIds() const;
+
+	/**
+	 * @brief Returns the index entries for a device, sorted by time, or NULL if there are none
+	 */
+	const std::vector<IndexEntry> *getIndex(const char *deviceId) const;
+
+	/**
+	 * @brief Returns the counters since open()
+	 */
+	const Stats &getStats() const { return stats; };
+
+	/**
+	 * @brief Returns true if the segments are being written with O_DIRECT
+	 */
+	bool isDirectIO() const { return usingDirectIO; };
+
+	/**
+	 * @brief Compress samples
+	 *
+	 * @param samples The samples
+	 *
+	 * @param numSamples Number of samples
+	 *
+	 * @param hasTemp Include the t values
+	 *
+	 * @param out Buffer for the compressed samples, at least maxEncodedSize(numSamples) bytes
+	 *
+	 * @return The number of bytes in out
+	 */
+	static size_t encodeSamples(const ADXL362Sample *samples, size_t numSamples, bool hasTemp, uint8_t *out);
+
+	/**
+	 * @brief Decompress samples from encodeSamples()
+	 *
+	 * @return false if the data is not valid
+	 */
+	static bool decodeSamples(const uint8_t *in, size_t len, size_t numSamples, bool hasTemp, ADXL362Sample *samples);
+
+	/**
+	 * @brief Returns the largest possible output of encodeSamples()
+	 */
+	static constexpr size_t maxEncodedSize(size_t numSamples) { return numSamples * 4 * 3; };
+
+	static const uint32_t CHUNK_MAGIC = 0x32363341;		//!< "A362" little endian
+	static const uint8_t FLAG_TEMP = 0x01;				//!< Samples include temperature
+	static const size_t BLOCK_SIZE = 4096;				//!< Alignment of O_DIRECT writes
+	static const size_t MAX_CHUNK_SAMPLES = 16384;		//!< Largest setChunkSamples()
+	static const size_t MAX_DEVICE_ID_LEN = 64;			//!< Longest device ID
+	static const size_t MIN_WRITE_BUFFER_SIZE = 256 * 1024;	//!< Holds at least one chunk of MAX_CHUNK_SAMPLES
+
+protected:
+	/**
+	 * @brief Samples being collected for a device
+	 */
+	struct OpenChunk {
+		uint64_t firstTimeUs = 0;		//!< Time of the first sample
+		uint64_t openedUs = 0;			//!< When the first sample was appended (tick() time)
+		uint64_t partition = 0;			//!< Partition start time in seconds
+		uint32_t firstSample = 0;		//!< Sample number of the first sample
+		uint16_t rateTenthsHz = 0;		//!< Output data rate in 0.1 Hz units
+		uint8_t rangeG = 0;				//!< Range in g
+		bool hasTemp = false;			//!< Samples include temperature
+		std::vector<ADXL362Sample> samples; //!< Samples, empty if there is no open chunk
+	};
+
+	/**
+	 * @brief A segment file open for writing
+	 */
+	struct Segment {
+		int fd = -1;					//!< File descriptor
+		uint8_t *buf = nullptr;			//!< Write buffer, aligned to BLOCK_SIZE
+		size_t bufLen = 0;				//!< Bytes in buf
+		uint64_t fileOffset = 0;		//!< File offset of buf[0], a multiple of BLOCK_SIZE
+		size_t writtenLen = 0;			//!< Bytes of buf already written (the partial block is written again)
+		uint64_t lastWriteUs = 0;		//!< tick() time of the last write
+		bool directIO = false;			//!< Opened with O_DIRECT
+	};
+
+	/**
+	 * @brief Returns the partition start time in seconds for a time
+	 */
+	uint64_t partitionForTime(uint64_t timeUs) const { return timeUs / 1000000 / partitionSeconds * partitionSeconds; };
+
+	/**
+	 * @brief Returns the path of a segment file
+	 */
+	std::string segmentPath(uint64_t partition) const;
+
+	/**
+	 * @brief Compress an open chunk into its segment's write buffer and add it to the index
+	 */
+	void seal(const std::string &deviceId, OpenChunk &chunk);
+
+	/**
+	 * @brief Returns the segment for a partition, opening it if necessary, or NULL on error
+	 */
+	Segment *getSegment(uint64_t partition);
+
+	/**
+	 * @brief Write a segment's buffer to the file, keeping the partial block at the end in the buffer
+	 */
+	bool writeSegment(uint64_t partition, Segment &segment);
+
+	/**
+	 * @brief Write and close a segment, truncating the file to the end of the last chunk
+	 */
+	void closeSegment(uint64_t partition, Segment &segment);
+
+	/**
+	 * @brief Read the chunk headers in a segment file and add them to the index
+	 *
+	 * @return The offset of the end of the last valid chunk
+	 */
+	uint64_t scanSegment(uint64_t partition);
+
+	/**
+	 * @brief Add a chunk to the index, keeping the device's entries sorted by time
+	 */
+	void addToIndex(const std::string &deviceId, const IndexEntry &entry);
+
+	std::string dir; //!< Store directory
+	uint32_t partitionSeconds = 3600; //!< Length of a partition
+	size_t chunkSamples = 4096; //!< Maximum samples in a chunk
+	uint64_t maxChunkAgeUs = 30000000; //!< Seal chunks older than this
+	uint64_t flushIntervalUs = 1000000; //!< Write buffers at least this often
+	size_t writeBufferSize = 1024 * 1024; //!< Size of each segment's buffer
+	bool directIO = true; //!< Try O_DIRECT
+	bool usingDirectIO = false; //!< Segments are open with O_DIRECT
+	bool isOpen = false; //!< open() succeeded
+	uint64_t lastTickUs = 0; //!< Time passed to the last tick()
+
+	std::map<std::string, OpenChunk> openChunks; //!< Open chunk for each device
+	std::map<uint64_t, Segment> segments; //!< Segments open for writing, by partition
+	std::map<uint64_t, uint64_t> segmentEnds; //!< End of the last chunk of existing segments, by partition
+	std::map<std::string, std::vector<IndexEntry>> index; //!< Chunks by device, sorted by time
+	std::map<std::string, uint64_t> maxChunkSpanUs; //!< Longest chunk for each device, for query()
+	std::vector<uint8_t> encodeBuf; //!< Buffer for compressing a chunk
+	Stats stats; //!< Counters
+};
+
+#endif /* __ADXL362SAMPLESTORE_H */
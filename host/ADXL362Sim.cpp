@@ -0,0 +1,283 @@
+#include "ADXL362Sim.h"
+
+// Simulated ADXL362 for host builds of the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+ADXL362Sim::ADXL362Sim() {
+	generator = [](uint32_t index, ADXL362Sample &sample) {
+		sample.x = 0;
+		sample.y = 0;
+		sample.z = 1000;
+		sample.t = 350;
+	};
+	reset();
+}
+
+ADXL362Sim::~ADXL362Sim() {
+}
+
+void ADXL362Sim::reset() {
+	memset(regs, 0, sizeof(regs));
+	regs[ADXL362DMA::REG_DEVID_AD] = 0xAD;
+	regs[ADXL362DMA::REG_DEVID_MST] = 0x1D;
+	regs[ADXL362DMA::REG_PART_ID] = 0xF2;
+	regs[ADXL362DMA::REG_SILICON_ID] = 0x01;
+	regs[ADXL362DMA::REG_STATUS] = 0x40; // AWAKE
+	regs[ADXL362DMA::REG_FIFO_SAMPLES] = 0x80;
+	regs[ADXL362DMA::REG_FILTER_CTL] = 0x13;
+
+	clearFifo();
+	sampleIndex = 0;
+	overrunEntries = 0;
+}
+
+void ADXL362Sim::generateSamples(size_t count) {
+	bool fifoEnabled = (regs[ADXL362DMA::REG_FIFO_CONTROL] & 0x03) != ADXL362DMA::FIFO_DISABLED;
+	bool fifoTemp = (regs[ADXL362DMA::REG_FIFO_CONTROL] & 0x04) != 0;
+
+	for(size_t ii = 0; ii < count; ii++) {
+		ADXL362Sample sample;
+		generator(sampleIndex++, sample);
+
+		int16_t values[4] = { sample.x, sample.y, sample.z, sample.t };
+		for(size_t axis = 0; axis < 4; axis++) {
+			// The device has 12-bit data
+			if (values[axis] > 2047) {
+				values[axis] = 2047;
+			}
+			if (values[axis] < -2048) {
+				values[axis] = -2048;
+			}
+
+			regs[ADXL362DMA::REG_XDATA_L + axis * 2] = (uint8_t)(values[axis] & 0xff);
+			regs[ADXL362DMA::REG_XDATA_L + axis * 2 + 1] = (uint8_t)((uint16_t)values[axis] >> 8);
+			if (axis < 3) {
+				regs[ADXL362DMA::REG_XDATA_8 + axis] = (uint8_t)(values[axis] >> 4);
+			}
+		}
+		regs[ADXL362DMA::REG_STATUS] |= 0x01; // DATA_READY
+
+		if (fifoEnabled) {
+			size_t numAxes = fifoTemp ? 4 : 3;
+			for(size_t axis = 0; axis < numAxes; axis++) {
+				pushEntry(makeEntry((uint8_t)axis, values[axis]));
+			}
+		}
+	}
+	updateFifoRegisters();
+}
+
+void ADXL362Sim::updateTime(uint64_t nowMicros) {
+	uint8_t odr = isMeasuring() ? (regs[ADXL362DMA::REG_FILTER_CTL] & 0x07) : TIME_BASE_STOPPED;
+	if (odr != timeBaseOdr || nowMicros < timeBaseMicros) {
+		// Measurement started or stopped, or the rate changed
+		timeBaseOdr = odr;
+		timeBaseMicros = nowMicros;
+		samplesSinceBase = 0;
+		return;
+	}
+	if (odr == TIME_BASE_STOPPED) {
+		return;
+	}
+	if (odr > ADXL362DMA::ODR_400) {
+		// Reserved values
+		odr = ADXL362DMA::ODR_400;
+	}
+
+	double rateHz = 12.5 * (double)(1 << odr) * (1.0 + (double)odrErrorPpm / 1000000.0);
+	uint64_t due = (uint64_t)((double)(nowMicros - timeBaseMicros) * rateHz / 1000000.0);
+	if (due <= samplesSinceBase) {
+		return;
+	}
+	size_t count = (size_t)(due - samplesSinceBase);
+	samplesSinceBase = due;
+
+	uint8_t fifoMode = regs[ADXL362DMA::REG_FIFO_CONTROL] & 0x03;
+	size_t numAxes = (regs[ADXL362DMA::REG_FIFO_CONTROL] & 0x04) ? 4 : 3;
+	size_t fillSamples = FIFO_SIZE / numAxes + 1;
+	if ((fifoMode == ADXL362DMA::FIFO_STREAM || fifoMode == ADXL362DMA::FIFO_TRIGGERED) && count > fillSamples) {
+		// The last fillSamples samples replace the whole FIFO, so the ones before them only need to be counted
+		size_t skip = count - fillSamples;
+		overrunEntries += (uint32_t)(fifoCount + skip * numAxes);
+		regs[ADXL362DMA::REG_STATUS] |= 0x08; // FIFO_OVERRUN
+		fifoHead = 0;
+		fifoCount = 0;
+		sampleIndex += (uint32_t)skip;
+		count = fillSamples;
+	}
+	generateSamples(count);
+}
+
+size_t ADXL362Sim::pushFifoEntries(const uint16_t *entries, size_t count) {
+	size_t added = 0;
+	for(size_t ii = 0; ii < count; ii++) {
+		if (pushEntry(entries[ii])) {
+			added++;
+		}
+	}
+	updateFifoRegisters();
+	return added;
+}
+
+void ADXL362Sim::clearFifo() {
+	fifoHead = 0;
+	fifoCount = 0;
+	fifoHighByte = false;
+	updateFifoRegisters();
+}
+
+// [static]
+uint16_t ADXL362Sim::makeEntry(uint8_t axis, int16_t value) {
+	// Bits 13:12 are the sign extension of the 12-bit value
+	return (uint16_t)((axis & 0x3) << 14) | ((uint16_t)value & 0x3fff);
+}
+
+void ADXL362Sim::select() {
+	spiState = SpiState::COMMAND;
+	fifoHighByte = false;
+}
+
+void ADXL362Sim::deselect() {
+	// A partially read FIFO entry has already been removed from the FIFO
+	fifoHighByte = false;
+	transactionCount++;
+	updateFifoRegisters();
+}
+
+void ADXL362Sim::transfer(const uint8_t *tx, uint8_t *rx, size_t len) {
+	for(size_t ii = 0; ii < len; ii++) {
+		uint8_t value = transferByte(tx ? tx[ii] : 0xff);
+		if (rx) {
+			rx[ii] = value;
+		}
+	}
+}
+
+uint8_t ADXL362Sim::transferByte(uint8_t tx) {
+	uint8_t rx = 0;
+
+	switch(spiState) {
+	case SpiState::COMMAND:
+		command = tx;
+		if (command == ADXL362DMA::CMD_READ_REGISTER || command == ADXL362DMA::CMD_WRITE_REGISTER) {
+			spiState = SpiState::ADDRESS;
+		}
+		else
+		if (command == ADXL362DMA::CMD_READ_FIFO) {
+			spiState = SpiState::READ_FIFO;
+		}
+		else {
+			spiState = SpiState::IGNORE;
+		}
+		break;
+
+	case SpiState::ADDRESS:
+		address = tx;
+		spiState = (command == ADXL362DMA::CMD_READ_REGISTER) ? SpiState::READ_REGISTER : SpiState::WRITE_REGISTER;
+		break;
+
+	case SpiState::READ_REGISTER:
+		rx = readRegister(address++);
+		break;
+
+	case SpiState::WRITE_REGISTER:
+		writeRegister(address++, tx);
+		break;
+
+	case SpiState::READ_FIFO:
+		if (!fifoHighByte) {
+			// Least significant byte first. Reading the low byte removes the entry from the FIFO.
+			if (fifoCount > 0) {
+				fifoEntry = fifo[fifoHead];
+				fifoHead = (fifoHead + 1) % FIFO_SIZE;
+				fifoCount--;
+				fifoEntriesRead++;
+			}
+			else {
+				fifoEntry = 0;
+			}
+			rx = (uint8_t)(fifoEntry & 0xff);
+			fifoHighByte = true;
+		}
+		else {
+			rx = (uint8_t)(fifoEntry >> 8);
+			fifoHighByte = false;
+		}
+		break;
+
+	case SpiState::IGNORE:
+		break;
+	}
+	return rx;
+}
+
+uint8_t ADXL362Sim::readRegister(uint8_t addr) {
+	if (addr >= sizeof(regs)) {
+		return 0;
+	}
+	uint8_t value = regs[addr];
+
+	if (addr == ADXL362DMA::REG_STATUS) {
+		// FIFO_OVERRUN and DATA_READY clear on read
+		regs[addr] &= ~0x09;
+	}
+	return value;
+}
+
+void ADXL362Sim::writeRegister(uint8_t addr, uint8_t value) {
+	if (addr == ADXL362DMA::REG_SOFT_RESET) {
+		if (value == 'R') {
+			reset();
+		}
+		return;
+	}
+	if (addr < ADXL362DMA::REG_THRESH_ACT_L || addr > ADXL362DMA::REG_SELF_TEST) {
+		// Read-only or reserved
+		return;
+	}
+
+	uint8_t oldFifoControl = regs[ADXL362DMA::REG_FIFO_CONTROL];
+	regs[addr] = value;
+
+	if (addr == ADXL362DMA::REG_FIFO_CONTROL && (oldFifoControl & 0x07) != (value & 0x07)) {
+		// Changing the FIFO mode or temperature setting clears the FIFO
+		clearFifo();
+	}
+	updateFifoRegisters();
+}
+
+bool ADXL362Sim::pushEntry(uint16_t entry) {
+	if (fifoCount >= FIFO_SIZE) {
+		overrunEntries++;
+		regs[ADXL362DMA::REG_STATUS] |= 0x08; // FIFO_OVERRUN
+
+		if ((regs[ADXL362DMA::REG_FIFO_CONTROL] & 0x03) == ADXL362DMA::FIFO_OLDEST_SAVED) {
+			return false;
+		}
+		// Stream mode, discard the oldest entry
+		fifoHead = (fifoHead + 1) % FIFO_SIZE;
+		fifoCount--;
+	}
+	fifo[(fifoHead + fifoCount) % FIFO_SIZE] = entry;
+	fifoCount++;
+	return true;
+}
+
+void ADXL362Sim::updateFifoRegisters() {
+	regs[ADXL362DMA::REG_FIFO_ENTRIES_L] = (uint8_t)(fifoCount & 0xff);
+	regs[ADXL362DMA::REG_FIFO_ENTRIES_H] = (uint8_t)(fifoCount >> 8);
+
+	uint16_t watermark = regs[ADXL362DMA::REG_FIFO_SAMPLES];
+	if (regs[ADXL362DMA::REG_FIFO_CONTROL] & 0x08) {
+		watermark |= 0x100;
+	}
+
+	uint8_t status = regs[ADXL362DMA::REG_STATUS] & ~0x06;
+	if (fifoCount > 0) {
+		status |= 0x02; // FIFO_READY
+	}
+	if (fifoCount >= watermark && watermark > 0) {
+		status |= 0x04; // FIFO_WATERMARK
+	}
+	regs[ADXL362DMA::REG_STATUS] = status;
+}
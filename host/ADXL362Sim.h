@@ -0,0 +1,219 @@
+#ifndef __ADXL362SIM_H
+#define __ADXL362SIM_H
+
+// Simulated ADXL362 for host builds of the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "Particle.h"
+#include "ADXL362DMA.h"
+
+#include <functional>
+
+/**
+ * @brief A simulated ADXL362 on a host SPI bus
+ *
+ * Implements the SPI protocol from the datasheet: write register (0x0A), read register (0x0B),
+ * and read FIFO (0x0D), with auto-incrementing addresses. The registers used by the driver have
+ * their reset values, and writing 'R' to SOFT_RESET resets the device.
+ *
+ * The FIFO holds 512 16-bit entries. Each entry has the axis in bits 15:14 (00 = X, 01 = Y, 10 = Z,
+ * 11 = temperature), sign extension in bits 13:12, and data in bits 11:0. FIFO reads return the
+ * least significant byte of each entry first. If CS goes high after the first byte of an entry, the
+ * entry is discarded. FIFO_DISABLED, FIFO_OLDEST_SAVED, and FIFO_STREAM are implemented; triggered
+ * mode behaves like stream mode.
+ *
+ * Samples are added by calling generateSamples() (or pushFifoEntries() for raw entries), using
+ * a generator function that defaults to 0, 0, 1g. With the simulated HostClock, updateTime()
+ * generates samples at the output data rate set in FILTER_CTL while in measurement mode:
+ *
+ * ```
+ * ADXL362Sim sim;
+ * SPI.attach(&sim, A2);
+ *
+ * HostClock::setSimulated(true);
+ * HostClock::addListener([](uint64_t nowMicros) { sim.updateTime(nowMicros); });
+ * ```
+ */
+class ADXL362Sim : public SPIDevice {
+public:
+	/**
+	 * @brief Function that returns sample number index, in counts
+	 */
+	typedef std::function<void(uint32_t index, ADXL362Sample &sample)> Generator;
+
+	/**
+	 * @brief Constructor. The device starts in the reset state.
+	 */
+	ADXL362Sim();
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362Sim();
+
+	/**
+	 * @brief Reset the registers and clear the FIFO, as after power-up or a soft reset
+	 */
+	void reset();
+
+	/**
+	 * @brief Set the sample generator
+	 */
+	void setGenerator(Generator generator) { this->generator = generator; };
+
+	/**
+	 * @brief Generate samples as if the device had measured them
+	 *
+	 * Updates the data registers. If the FIFO is enabled, adds the entries (XYZ, or XYZT if FIFO_TEMP
+	 * is set) to the FIFO.
+	 *
+	 * @param count Number of samples
+	 */
+	void generateSamples(size_t count);
+
+	/**
+	 * @brief Generate the samples that are due at a time, based on the output data rate
+	 *
+	 * Samples are only generated in measurement mode. Time is counted from when measurement mode
+	 * was entered or the output data rate was changed, so the number of samples does not drift.
+	 *
+	 * In FIFO_STREAM mode, if more samples are due than fit in the FIFO, the samples that would be
+	 * overwritten are counted as overrun without calling the generator. The generator should only
+	 * depend on the sample index.
+	 *
+	 * @param nowMicros The time in microseconds, typically from HostClock
+	 */
+	void updateTime(uint64_t nowMicros);
+
+	/**
+	 * @brief Set the error of the ADXL362 output data rate in parts per million
+	 *
+	 * The ADXL362 output data rate is only accurate to about 10%, so over a long run the device
+	 * clock drifts relative to the MCU. Positive values make the device faster.
+	 */
+	void setOdrErrorPpm(int32_t ppm) { odrErrorPpm = ppm; };
+
+	/**
+	 * @brief Add raw entries to the FIFO, for example to test misaligned reads
+	 *
+	 * @return The number of entries added. In FIFO_OLDEST_SAVED mode, entries that don't fit are
+	 * discarded. Otherwise the oldest entries are overwritten.
+	 */
+	size_t pushFifoEntries(const uint16_t *entries, size_t count);
+
+	/**
+	 * @brief Remove all entries from the FIFO
+	 */
+	void clearFifo();
+
+	/**
+	 * @brief Make a FIFO entry from an axis (0 = X, 1 = Y, 2 = Z, 3 = temperature) and value in counts
+	 */
+	static uint16_t makeEntry(uint8_t axis, int16_t value);
+
+	/**
+	 * @brief Returns the number of entries in the FIFO
+	 */
+	size_t getNumFifoEntries() const { return fifoCount; };
+
+	/**
+	 * @brief Returns the value of a register
+	 */
+	uint8_t getRegister(uint8_t addr) const { return (addr < sizeof(regs)) ? regs[addr] : 0; };
+
+	/**
+	 * @brief Returns true if POWER_CTL is set to measurement mode
+	 */
+	bool isMeasuring() const { return (regs[ADXL362DMA::REG_POWER_CTL] & 0x03) == 0x02; };
+
+	/**
+	 * @brief Returns the number of samples generated since reset()
+	 */
+	uint32_t getSampleIndex() const { return sampleIndex; };
+
+	/**
+	 * @brief Returns the number of entries lost because the FIFO was full
+	 */
+	uint32_t getOverrunEntries() const { return overrunEntries; };
+
+	/**
+	 * @brief Returns the number of FIFO entries read by SPI, including partially read entries
+	 */
+	uint32_t getFifoEntriesRead() const { return fifoEntriesRead; };
+
+	/**
+	 * @brief Returns the number of SPI transactions (CS low to high)
+	 */
+	uint32_t getTransactionCount() const { return transactionCount; };
+
+	// SPIDevice
+	virtual void select();
+	virtual void deselect();
+	virtual void transfer(const uint8_t *tx, uint8_t *rx, size_t len);
+
+	static const size_t FIFO_SIZE = 512; //!< Number of 16-bit FIFO entries
+
+protected:
+	/**
+	 * @brief Handle one byte of an SPI transaction
+	 */
+	uint8_t transferByte(uint8_t tx);
+
+	/**
+	 * @brief Read a register, updating the clear-on-read status bits
+	 */
+	uint8_t readRegister(uint8_t addr);
+
+	/**
+	 * @brief Write a register, ignoring read-only registers
+	 */
+	void writeRegister(uint8_t addr, uint8_t value);
+
+	/**
+	 * @brief Add one entry to the FIFO
+	 */
+	bool pushEntry(uint16_t entry);
+
+	/**
+	 * @brief Update FIFO_ENTRIES and the FIFO status bits
+	 */
+	void updateFifoRegisters();
+
+	/**
+	 * @brief SPI transaction state
+	 */
+	enum class SpiState {
+		COMMAND,		//!< Waiting for the command byte
+		ADDRESS,		//!< Waiting for the register address
+		READ_REGISTER,	//!< Reading registers
+		WRITE_REGISTER,	//!< Writing registers
+		READ_FIFO,		//!< Reading the FIFO
+		IGNORE			//!< Unknown command, ignore until CS goes high
+	};
+
+	uint8_t regs[0x40]; //!< Register values
+	uint16_t fifo[FIFO_SIZE]; //!< FIFO ring buffer
+	size_t fifoHead = 0; //!< Index of the oldest entry
+	size_t fifoCount = 0; //!< Number of entries
+
+	Generator generator; //!< Sample generator
+	uint32_t sampleIndex = 0; //!< Samples generated
+	uint32_t overrunEntries = 0; //!< Entries lost
+	uint32_t fifoEntriesRead = 0; //!< Entries read
+	uint32_t transactionCount = 0; //!< SPI transactions
+
+	int32_t odrErrorPpm = 0; //!< Output data rate error
+	uint8_t timeBaseOdr = TIME_BASE_STOPPED; //!< ODR bits when timeBaseMicros was set
+	uint64_t timeBaseMicros = 0; //!< Time measurement started or the ODR changed
+	uint64_t samplesSinceBase = 0; //!< Samples generated by updateTime() since timeBaseMicros
+	static const uint8_t TIME_BASE_STOPPED = 0xff; //!< timeBaseOdr when not measuring
+
+	SpiState spiState = SpiState::COMMAND; //!< Transaction state
+	uint8_t command = 0; //!< Command byte of this transaction
+	uint8_t address = 0; //!< Current register address
+	bool fifoHighByte = false; //!< Next FIFO byte is the high byte of fifoEntry
+	uint16_t fifoEntry = 0; //!< FIFO entry being read
+};
+
+#endif /* __ADXL362SIM_H */
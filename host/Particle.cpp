@@ -0,0 +1,206 @@
+#include "Particle.h"
+
+#include <stdarg.h>
+
+#include <chrono>
+#include <thread>
+
+// Minimal Particle Device OS shim for building the ADXL362DMA library on a Linux or Mac host
+// https://github.com/rickkas7/ADXL362DMA
+
+Logger Log;
+SPIClass SPI;
+SPIClass SPI1;
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+static std::vector<HostClock::Listener> clockListeners;
+
+bool HostClock::simulated = false;
+uint64_t HostClock::simNanos = 0;
+
+void pinMode(pin_t pin, int mode) {
+}
+
+void digitalWrite(pin_t pin, int value) {
+	SPI.pinChanged(pin, value);
+	SPI1.pinChanged(pin, value);
+}
+
+unsigned long millis() {
+	return (unsigned long) (HostClock::getMicros() / 1000);
+}
+
+unsigned long micros() {
+	return (unsigned long) HostClock::getMicros();
+}
+
+void delay(unsigned long ms) {
+	if (HostClock::isSimulated()) {
+		HostClock::advanceMicros((uint64_t)ms * 1000);
+	}
+	else {
+		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+	}
+}
+
+// [static]
+void HostClock::setSimulated(bool simulated) {
+	HostClock::simulated = simulated;
+	simNanos = 0;
+}
+
+// [static]
+void HostClock::advanceMicros(uint64_t us) {
+	advanceNanos(us * 1000);
+}
+
+// [static]
+void HostClock::advanceNanos(uint64_t ns) {
+	if (!simulated) {
+		return;
+	}
+	simNanos += ns;
+
+	uint64_t now = simNanos / 1000;
+	for(auto &listener : clockListeners) {
+		listener(now);
+	}
+}
+
+// [static]
+uint64_t HostClock::getMicros() {
+	if (simulated) {
+		return simNanos / 1000;
+	}
+	return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// [static]
+void HostClock::addListener(Listener listener) {
+	clockListeners.push_back(listener);
+}
+
+static void logVa(int level, int minLevel, const char *levelName, const char *fmt, va_list ap) {
+	if (level < minLevel) {
+		return;
+	}
+	fprintf(stderr, "%010lu [%s] ", millis(), levelName);
+	vfprintf(stderr, fmt, ap);
+	fprintf(stderr, "\n");
+}
+
+void Logger::trace(const char *fmt, ...) const {
+	va_list ap;
+	va_start(ap, fmt);
+	logVa(LEVEL_TRACE, level, "trace", fmt, ap);
+	va_end(ap);
+}
+
+void Logger::info(const char *fmt, ...) const {
+	va_list ap;
+	va_start(ap, fmt);
+	logVa(LEVEL_INFO, level, "info", fmt, ap);
+	va_end(ap);
+}
+
+void Logger::warn(const char *fmt, ...) const {
+	va_list ap;
+	va_start(ap, fmt);
+	logVa(LEVEL_WARN, level, "warn", fmt, ap);
+	va_end(ap);
+}
+
+void Logger::error(const char *fmt, ...) const {
+	va_list ap;
+	va_start(ap, fmt);
+	logVa(LEVEL_ERROR, level, "error", fmt, ap);
+	va_end(ap);
+}
+
+size_t Print::printf(const char *fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
+	size_t result = vprintf(false, fmt, ap);
+	va_end(ap);
+	return result;
+}
+
+size_t Print::printlnf(const char *fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
+	size_t result = vprintf(true, fmt, ap);
+	va_end(ap);
+	return result;
+}
+
+size_t Print::vprintf(bool newline, const char *fmt, va_list ap) {
+	char stackBuf[20];
+	va_list ap2;
+	va_copy(ap2, ap);
+	int len = vsnprintf(stackBuf, sizeof(stackBuf), fmt, ap);
+
+	size_t result;
+	if (len < (int)sizeof(stackBuf)) {
+		result = write((const uint8_t *)stackBuf, len);
+	}
+	else {
+		std::vector<char> heapBuf(len + 1);
+		vsnprintf(heapBuf.data(), heapBuf.size(), fmt, ap2);
+		result = write((const uint8_t *)heapBuf.data(), len);
+	}
+	va_end(ap2);
+
+	if (newline) {
+		result += write((const uint8_t *)"\r\n", 2);
+	}
+	return result;
+}
+
+SPIClass::SPIClass() {
+}
+
+uint8_t SPIClass::transfer(uint8_t data) {
+	uint8_t rx = 0;
+	transfer(&data, &rx, 1, nullptr);
+	return rx;
+}
+
+void SPIClass::transfer(const void *tx, void *rx, size_t len, wiring_spi_dma_transfercomplete_callback_t callback) {
+	if (device && selected) {
+		device->transfer((const uint8_t *)tx, (uint8_t *)rx, len);
+	}
+	else
+	if (rx) {
+		memset(rx, 0, len);
+	}
+	bytesTransferred += len;
+
+	if (HostClock::isSimulated() && settings.clock > 0) {
+		HostClock::advanceNanos((uint64_t)len * 8 * 1000000000ULL / settings.clock);
+	}
+
+	if (callback) {
+		callback();
+	}
+}
+
+void SPIClass::attach(SPIDevice *device, pin_t csPin) {
+	this->device = device;
+	this->csPin = csPin;
+	selected = false;
+}
+
+void SPIClass::pinChanged(pin_t pin, int value) {
+	if (!device || pin != csPin) {
+		return;
+	}
+	if (value == LOW && !selected) {
+		selected = true;
+		device->select();
+	}
+	else
+	if (value != LOW && selected) {
+		selected = false;
+		device->deselect();
+	}
+}
@@ -0,0 +1,255 @@
+#ifndef __HOST_PARTICLE_H
+#define __HOST_PARTICLE_H
+
+// Minimal Particle Device OS shim for building the ADXL362DMA library on a Linux or Mac host
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+//
+// This is not part of the library and is not uploaded with it. It provides just enough of the
+// Device OS API for the files in src to compile, with an SPIClass whose transfers go to a
+// simulated device (see ADXL362Sim) instead of hardware.
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// The host build is single threaded; ADXL362Worker is not available
+#define PLATFORM_THREADING 0
+
+#define SYSTEM_THREAD(x)
+#define SYSTEM_MODE(x)
+#define retained
+#define ATOMIC_BLOCK()
+
+#define MHZ 1000000
+#define MSBFIRST 1
+#define LSBFIRST 0
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x01
+#define SPI_MODE2 0x02
+#define SPI_MODE3 0x03
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+
+typedef uint16_t pin_t;
+typedef uint32_t system_tick_t;
+
+// Pin numbers only need to be distinct on the host
+enum {
+	D0 = 0, D1, D2, D3, D4, D5, D6, D7, D8,
+	A0 = 10, A1, A2, A3, A4, A5, A6, A7
+};
+
+void pinMode(pin_t pin, int mode);
+void digitalWrite(pin_t pin, int value);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+/**
+ * @brief Host clock used by millis(), micros(), and delay()
+ *
+ * By default this is the real time since the program started. With the simulated clock, time
+ * only moves forward when advanceMicros() or delay() is called, and SPI transfers take the time
+ * they would take at the SPI clock speed. This allows days of streaming to be run in seconds, and
+ * the same run can be repeated exactly.
+ *
+ * Listeners, such as ADXL362Sim::updateTime(), are called every time the simulated clock moves.
+ */
+class HostClock {
+public:
+	/**
+	 * @brief Function called with the new time in microseconds when the simulated clock moves
+	 */
+	typedef std::function<void(uint64_t nowMicros)> Listener;
+
+	/**
+	 * @brief Use the simulated clock (true) or the real clock (false). The simulated clock starts at 0.
+	 */
+	static void setSimulated(bool simulated);
+
+	/**
+	 * @brief Returns true if the simulated clock is being used
+	 */
+	static bool isSimulated() { return simulated; };
+
+	/**
+	 * @brief Move the simulated clock forward. Does nothing with the real clock.
+	 */
+	static void advanceMicros(uint64_t us);
+
+	/**
+	 * @brief Move the simulated clock forward by a time in nanoseconds, keeping the fraction of a microsecond
+	 */
+	static void advanceNanos(uint64_t ns);
+
+	/**
+	 * @brief Returns the time in microseconds. Unlike micros(), this does not roll over.
+	 */
+	static uint64_t getMicros();
+
+	/**
+	 * @brief Add a function to call when the simulated clock moves
+	 */
+	static void addListener(Listener listener);
+
+protected:
+	static bool simulated; //!< Using the simulated clock
+	static uint64_t simNanos; //!< Simulated time in nanoseconds
+};
+
+/**
+ * @brief printf-style logger. Messages below the level are discarded.
+ */
+class Logger {
+public:
+	void trace(const char *fmt, ...) const __attribute__((format(printf, 2, 3)));
+	void info(const char *fmt, ...) const __attribute__((format(printf, 2, 3)));
+	void warn(const char *fmt, ...) const __attribute__((format(printf, 2, 3)));
+	void error(const char *fmt, ...) const __attribute__((format(printf, 2, 3)));
+
+	static const int LEVEL_TRACE = 1; //!< Everything
+	static const int LEVEL_INFO = 30; //!< Info, warnings, and errors
+	static const int LEVEL_WARN = 40; //!< Warnings and errors (default)
+	static const int LEVEL_ERROR = 50; //!< Errors only
+	static const int LEVEL_NONE = 70; //!< Nothing
+
+	int level = LEVEL_WARN; //!< Minimum level to print to stderr
+};
+extern Logger Log;
+
+/**
+ * @brief Byte output, like the Device OS Print class that Serial and TCPClient derive from
+ */
+class Print {
+public:
+	virtual ~Print() {};
+
+	virtual size_t write(uint8_t b) { return write(&b, 1); };
+	virtual size_t write(const uint8_t *buf, size_t size) = 0;
+
+	/**
+	 * @brief Formatted output. Like Device OS, formats into a small buffer on the stack (or the heap
+	 * if it does not fit) and writes it.
+	 */
+	size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+	/**
+	 * @brief Formatted output followed by "\r\n", with a separate write for the line ending
+	 */
+	size_t printlnf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+protected:
+	size_t vprintf(bool newline, const char *fmt, va_list ap);
+};
+
+/**
+ * @brief Mutex, a std::recursive_mutex like the Device OS RecursiveMutex
+ */
+class Mutex {
+public:
+	void lock() { mutex.lock(); };
+	void unlock() { mutex.unlock(); };
+	bool trylock() { return mutex.try_lock(); };
+
+protected:
+	std::recursive_mutex mutex;
+};
+
+/**
+ * @brief SPI settings, stored but not used on the host
+ */
+class SPISettings {
+public:
+	SPISettings() {};
+	SPISettings(unsigned clock, uint8_t bitOrder, uint8_t dataMode) : clock(clock), bitOrder(bitOrder), dataMode(dataMode) {};
+
+	unsigned clock = 4 * MHZ; //!< Clock speed in Hz
+	uint8_t bitOrder = MSBFIRST; //!< MSBFIRST or LSBFIRST
+	uint8_t dataMode = SPI_MODE0; //!< SPI_MODE0 to SPI_MODE3
+};
+
+/**
+ * @brief A device on a host SPI bus, such as ADXL362Sim
+ */
+class SPIDevice {
+public:
+	virtual ~SPIDevice() {};
+
+	/**
+	 * @brief CS was set low
+	 */
+	virtual void select() = 0;
+
+	/**
+	 * @brief CS was set high
+	 */
+	virtual void deselect() = 0;
+
+	/**
+	 * @brief Transfer bytes while selected
+	 *
+	 * @param tx Bytes to send, or nullptr to send 0xff
+	 *
+	 * @param rx Buffer for the received bytes, or nullptr to discard them
+	 *
+	 * @param len Number of bytes
+	 */
+	virtual void transfer(const uint8_t *tx, uint8_t *rx, size_t len) = 0;
+};
+
+typedef void (*wiring_spi_dma_transfercomplete_callback_t)(void);
+
+/**
+ * @brief Host SPI bus
+ *
+ * Transfers go to the attached SPIDevice, which is selected and deselected by digitalWrite() on
+ * its CS pin. With no device attached, received bytes are 0. DMA transfers complete immediately:
+ * the callback is called before transfer() returns. With the simulated HostClock, each transfer
+ * moves the clock forward by the time it would take at the clock speed in settings.
+ */
+class SPIClass {
+public:
+	SPIClass();
+
+	void begin() {};
+	void begin(int ssPin) {};
+	void end() {};
+	void beginTransaction(SPISettings settings) { this->settings = settings; };
+	void endTransaction() {};
+
+	uint8_t transfer(uint8_t data);
+	void transfer(const void *tx, void *rx, size_t len, wiring_spi_dma_transfercomplete_callback_t callback);
+
+	/**
+	 * @brief Attach a simulated device, selected by CS pin csPin, or nullptr to detach
+	 */
+	void attach(SPIDevice *device, pin_t csPin);
+
+	/**
+	 * @brief Called by digitalWrite() for every pin
+	 */
+	void pinChanged(pin_t pin, int value);
+
+	SPISettings settings; //!< Settings from the last beginTransaction()
+	SPIDevice *device = nullptr; //!< Attached device
+	pin_t csPin = 0xffff; //!< CS pin of the attached device
+	bool selected = false; //!< CS is low
+	uint64_t bytesTransferred = 0; //!< Total bytes transferred
+};
+
+extern SPIClass SPI;
+extern SPIClass SPI1;
+
+#endif /* __HOST_PARTICLE_H */
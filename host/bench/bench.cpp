@@ -0,0 +1,493 @@
+// Host micro-benchmarks for the ADXL362DMA library hot paths
+//
+// Runs the driver against the simulated ADXL362 (../ADXL362Sim) and writes the results as JSON to
+// stdout, in the same format as Google Benchmark (--benchmark_format=json), so the results can be
+// tracked over time with the same tools.
+//
+// Build:
+// g++ -O2 -std=gnu++17 -I.. -I../../src bench.cpp ../Particle.cpp ../ADXL362Sim.cpp ../../src/ADXL362DMA.cpp ../../src/ADXL362Dsp.cpp ../../src/ADXL362TextFormatter.cpp -o bench
+//
+// Run this like:
+// ./bench > results.json
+// ./bench --filter=readFifoAsync --min-time=0.5 --repetitions=9
+//
+// Each benchmark is run enough times to take at least --min-time seconds, repeated --repetitions
+// times, and the median is reported. items_per_second counts samples (or values) processed.
+//
+// The readFifoAsync/replay benchmarks run the driver with ADXL362ReplayTransport instead of the SPI
+// shim, so they time only the driver code.
+
+#include "Particle.h"
+#include "ADXL362Sim.h"
+
+#include "ADXL362DMA.h"
+#include "ADXL362Dsp.h"
+#include "ADXL362Pipeline.h"
+#include "ADXL362TextFormatter.h"
+
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Prevents the compiler from optimizing away a result
+template <class T>
+inline void doNotOptimize(const T &value) {
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Result {
+	std::string name;
+	uint64_t iterations;
+	double realNs;
+	double cpuNs;
+	size_t itemsPerIteration;
+};
+
+static std::vector<Result> results;
+static std::string filter;
+static double minTime = 0.2;
+static int repetitions = 5;
+
+static double cpuSeconds() {
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static double realSeconds() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Runs fn (one iteration) repeatedly and records the median time per iteration
+template <class F>
+static void bench(const char *name, size_t itemsPerIteration, F fn) {
+	if (!filter.empty() && std::string(name).find(filter) == std::string::npos) {
+		return;
+	}
+
+	// Find the number of iterations that takes at least minTime
+	uint64_t iterations = 1;
+	while(true) {
+		double start = realSeconds();
+		for(uint64_t ii = 0; ii < iterations; ii++) {
+			fn();
+		}
+		double elapsed = realSeconds() - start;
+		if (elapsed >= minTime || iterations >= (1ULL << 40)) {
+			break;
+		}
+		uint64_t next = (elapsed > 0) ? (uint64_t)((double)iterations * minTime * 1.4 / elapsed) : iterations * 10;
+		iterations = std::max(next, iterations * 2);
+	}
+
+	std::vector<double> realNs, cpuNs;
+	for(int rep = 0; rep < repetitions; rep++) {
+		double realStart = realSeconds();
+		double cpuStart = cpuSeconds();
+		for(uint64_t ii = 0; ii < iterations; ii++) {
+			fn();
+		}
+		cpuNs.push_back((cpuSeconds() - cpuStart) * 1e9 / (double)iterations);
+		realNs.push_back((realSeconds() - realStart) * 1e9 / (double)iterations);
+	}
+	std::sort(realNs.begin(), realNs.end());
+	std::sort(cpuNs.begin(), cpuNs.end());
+
+	Result result;
+	result.name = name;
+	result.iterations = iterations;
+	result.realNs = realNs[realNs.size() / 2];
+	result.cpuNs = cpuNs[cpuNs.size() / 2];
+	result.itemsPerIteration = itemsPerIteration;
+	results.push_back(result);
+
+	fprintf(stderr, "%-40s %12.1f ns %14.0f items/s\n", name, result.realNs, (double)itemsPerIteration * 1e9 / result.cpuNs);
+}
+
+static void writeJson() {
+	char date[32];
+	time_t now = time(nullptr);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+
+	printf("{\n");
+	printf("  \"context\": {\n");
+	printf("    \"date\": \"%s\",\n", date);
+	printf("    \"executable\": \"ADXL362DMA host bench\",\n");
+	printf("    \"compiler\": \"%s\",\n", __VERSION__);
+#ifdef __OPTIMIZE__
+	printf("    \"library_build_type\": \"release\",\n");
+#else
+	printf("    \"library_build_type\": \"debug\",\n");
+#endif
+	printf("    \"min_time\": %.3f,\n", minTime);
+	printf("    \"repetitions\": %d\n", repetitions);
+	printf("  },\n");
+	printf("  \"benchmarks\": [\n");
+	for(size_t ii = 0; ii < results.size(); ii++) {
+		const Result &r = results[ii];
+		printf("    {\n");
+		printf("      \"name\": \"%s\",\n", r.name.c_str());
+		printf("      \"run_type\": \"aggregate\",\n");
+		printf("      \"aggregate_name\": \"median\",\n");
+		printf("      \"iterations\": %llu,\n", (unsigned long long)r.iterations);
+		printf("      \"real_time\": %.3f,\n", r.realNs);
+		printf("      \"cpu_time\": %.3f,\n", r.cpuNs);
+		printf("      \"time_unit\": \"ns\",\n");
+		printf("      \"items_per_second\": %.1f\n", (double)r.itemsPerIteration * 1e9 / r.cpuNs);
+		printf("    }%s\n", (ii + 1 < results.size()) ? "," : "");
+	}
+	printf("  ]\n");
+	printf("}\n");
+}
+
+// Fills a buffer as if readFifoAsync had completed, with FIFO entries in device byte order
+static void fillBuffer(ADXL362DataBase &data, bool storeTemp, size_t numSamples) {
+	size_t sampleSize = storeTemp ? 8 : 6;
+	size_t numAxes = storeTemp ? 4 : 3;
+
+	for(size_t ii = 0; ii < numSamples; ii++) {
+		for(size_t axis = 0; axis < numAxes; axis++) {
+			int16_t value = (int16_t)((ii * 37 + axis * 500) % 4000) - 2000;
+			uint16_t entry = ADXL362Sim::makeEntry((uint8_t)axis, value);
+			data.buf[ii * sampleSize + axis * 2] = (uint8_t)(entry & 0xff);
+			data.buf[ii * sampleSize + axis * 2 + 1] = (uint8_t)(entry >> 8);
+		}
+	}
+	data.storeTemp = storeTemp;
+	data.sampleSizeInBytes = sampleSize;
+	data.startOffset = 0;
+	data.numSamplesRead = numSamples;
+	data.bytesRead = numSamples * sampleSize;
+	data.state = ADXL362DMA::STATE_READ_COMPLETE;
+}
+
+static void benchDecode() {
+	static ADXL362DataEx<1020> xyz;
+	static ADXL362DataEx<1024> xyzt;
+	fillBuffer(xyz, false, 170);
+	fillBuffer(xyzt, true, 128);
+
+	bench("readSigned14", 510, []() {
+		int32_t sum = 0;
+		for(size_t ii = 0; ii < 510; ii++) {
+			sum += xyz.readSigned14(&xyz.buf[ii * 2]);
+		}
+		doNotOptimize(sum);
+	});
+
+	bench("readX", 170, []() {
+		int32_t sum = 0;
+		for(size_t ii = 0; ii < xyz.numSamplesRead; ii++) {
+			sum += xyz.readX(ii);
+		}
+		doNotOptimize(sum);
+	});
+
+	bench("readY", 170, []() {
+		int32_t sum = 0;
+		for(size_t ii = 0; ii < xyz.numSamplesRead; ii++) {
+			sum += xyz.readY(ii);
+		}
+		doNotOptimize(sum);
+	});
+
+	bench("readZ", 170, []() {
+		int32_t sum = 0;
+		for(size_t ii = 0; ii < xyz.numSamplesRead; ii++) {
+			sum += xyz.readZ(ii);
+		}
+		doNotOptimize(sum);
+	});
+
+	bench("readT", 128, []() {
+		int32_t sum = 0;
+		for(size_t ii = 0; ii < xyzt.numSamplesRead; ii++) {
+			sum += xyzt.readT(ii);
+		}
+		doNotOptimize(sum);
+	});
+
+	bench("readX+readY+readZ", 170, []() {
+		int32_t sum = 0;
+		for(size_t ii = 0; ii < xyz.numSamplesRead; ii++) {
+			sum += xyz.readX(ii) + xyz.readY(ii) + xyz.readZ(ii);
+		}
+		doNotOptimize(sum);
+	});
+
+	// Bulk decoders
+	bench("bulk/readSample", 170, []() {
+		int32_t sum = 0;
+		ADXL362Sample sample;
+		for(size_t ii = 0; ii < xyz.numSamplesRead; ii++) {
+			xyz.readSample(ii, sample);
+			sum += sample.x + sample.y + sample.z;
+		}
+		doNotOptimize(sum);
+	});
+
+	bench("bulk/iterator", 170, []() {
+		int32_t sum = std::accumulate(xyz.begin(), xyz.end(), 0, [](int32_t sum, const ADXL362Sample &sample) {
+			return sum + sample.x + sample.y + sample.z;
+		});
+		doNotOptimize(sum);
+	});
+
+	bench("bulk/pipeline/calibrate+lowpass", 170, []() {
+		static int32_t sum = 0;
+		static auto pipeline = makeADXL362Pipeline(ADXL362CalibrateStage(), ADXL362LowPassStage(), [](const ADXL362Sample &sample) {
+			sum += sample.x + sample.y + sample.z;
+		});
+		static bool initialized = false;
+		if (!initialized) {
+			pipeline.get<1>().begin(400, 50);
+			initialized = true;
+		}
+		pipeline.process(xyz);
+		doNotOptimize(sum);
+	});
+}
+
+static void benchDriver() {
+	static ADXL362Sim sim;
+	static ADXL362DMA accel(SPI, A2);
+	static ADXL362DataEx<1020> data;
+	static ADXL362DMA::RetainedState state;
+
+	SPI.attach(&sim, A2);
+	accel.softReset();
+	accel.writeFilterControl(accel.RANGE_2G, false, false, accel.ODR_400);
+	accel.writeFifoControlAndSamples(511, false, accel.FIFO_STREAM);
+	accel.setMeasureMode(true);
+	accel.saveState(state);
+
+	// Entries for a full buffer, starting with X, Y, or Z to exercise the realignment in cleanBuffer
+	static std::vector<uint16_t> entries[3];
+	for(size_t offset = 0; offset < 3; offset++) {
+		for(size_t ii = 0; ii < 510; ii++) {
+			size_t axis = (ii + offset) % 3;
+			entries[offset].push_back(ADXL362Sim::makeEntry((uint8_t)axis, (int16_t)(ii % 2000)));
+		}
+	}
+
+	static const char *names[3] = { "readFifoAsync/aligned", "readFifoAsync/misaligned2", "readFifoAsync/misaligned4" };
+	for(size_t offset = 0; offset < 3; offset++) {
+		bench(names[offset], 170, [offset]() {
+			// Restoring the state clears the partial sample left by the previous iteration
+			accel.restoreState(state);
+			sim.clearFifo();
+			sim.pushFifoEntries(entries[offset].data(), entries[offset].size());
+			accel.readFifoAsync(&data, (uint16_t)entries[offset].size());
+			doNotOptimize(data.numSamplesRead);
+			data.state = ADXL362DMA::STATE_FREE;
+		});
+	}
+
+	// The same reads, recorded with ADXL362RecordingTransport and played back with ADXL362ReplayTransport,
+	// time the driver without the SPI shim and simulated device
+	static uint8_t logBuf[3][4096];
+	static ADXL362DMABasic<ADXL362ReplayTransport> *replay[3];
+	for(size_t offset = 0; offset < 3; offset++) {
+		ADXL362DMABasic<ADXL362RecordingTransport<>> recorder(ADXL362RecordingTransport<>(ADXL362SPITransport(SPI, A2), logBuf[offset], sizeof(logBuf[offset])));
+		recorder.restoreState(state);
+		sim.clearFifo();
+		sim.pushFifoEntries(entries[offset].data(), entries[offset].size());
+		recorder.readFifoAsync(&data, (uint16_t)entries[offset].size());
+		data.state = ADXL362DMA::STATE_FREE;
+
+		replay[offset] = new ADXL362DMABasic<ADXL362ReplayTransport>(ADXL362ReplayTransport(logBuf[offset], recorder.getTransport().getLogLength()));
+	}
+
+	static const char *replayNames[3] = { "readFifoAsync/replay/aligned", "readFifoAsync/replay/misaligned2", "readFifoAsync/replay/misaligned4" };
+	for(size_t offset = 0; offset < 3; offset++) {
+		bench(replayNames[offset], 170, [offset]() {
+			replay[offset]->getTransport().rewind();
+			replay[offset]->restoreState(state);
+			replay[offset]->readFifoAsync(&data, (uint16_t)entries[offset].size());
+			doNotOptimize(data.numSamplesRead);
+			data.state = ADXL362DMA::STATE_FREE;
+		});
+		if (replay[offset]->getTransport().getMismatchCount() != 0) {
+			fprintf(stderr, "%s: replay did not match the recording\n", replayNames[offset]);
+		}
+	}
+
+	// With no device attached, the buffer is all zeros, which has no valid sample, so this is the
+	// worst case for cleanBuffer: scanning the whole buffer
+	SPI.attach(nullptr, A2);
+	bench("readFifoAsync/no valid samples", 170, []() {
+		accel.restoreState(state);
+		accel.readFifoAsync(&data, 510);
+		doNotOptimize(data.numSamplesRead);
+		data.state = ADXL362DMA::STATE_FREE;
+	});
+	SPI.attach(&sim, A2);
+
+	bench("readNumFifoEntries", 1, []() {
+		doNotOptimize(accel.readNumFifoEntries());
+	});
+
+	bench("writeFifoControlAndSamples", 1, []() {
+		accel.writeFifoControlAndSamples(511, false, accel.FIFO_STREAM);
+	});
+
+	sim.setGenerator([](uint32_t index, ADXL362Sample &sample) {
+		sample.x = 200;
+		sample.y = -300;
+		sample.z = 900;
+		sample.t = 350;
+	});
+	sim.generateSamples(1);
+
+	bench("readXYZ", 1, []() {
+		int16_t x, y, z;
+		accel.readXYZ(x, y, z);
+		doNotOptimize(x + y + z);
+	});
+
+	bench("readRollPitchDegrees", 1, []() {
+		float roll, pitch;
+		accel.readRollPitchDegrees(roll, pitch);
+		doNotOptimize(roll + pitch);
+	});
+}
+
+static void benchDsp() {
+	bench("ADXL362Biquad/process", 1024, []() {
+		static ADXL362Biquad biquad;
+		static bool initialized = false;
+		if (!initialized) {
+			biquad.setLowPass(400, 50);
+			initialized = true;
+		}
+		int32_t sum = 0;
+		for(int32_t ii = 0; ii < 1024; ii++) {
+			sum += biquad.process((ii & 0xff) << 4);
+		}
+		doNotOptimize(sum);
+	});
+
+	bench("ADXL362Dsp/isqrt", 1024, []() {
+		uint32_t sum = 0;
+		for(uint32_t ii = 0; ii < 1024; ii++) {
+			sum += ADXL362Dsp::isqrt(ii * 4099 + 1000000);
+		}
+		doNotOptimize(sum);
+	});
+
+	bench("ADXL362Dsp/fft256", 256, []() {
+		static int16_t cosTable[128], sinTable[128];
+		static int32_t re[256], im[256];
+		static bool initialized = false;
+		if (!initialized) {
+			ADXL362Dsp::fftTables(cosTable, sinTable, 256);
+			initialized = true;
+		}
+		for(size_t ii = 0; ii < 256; ii++) {
+			re[ii] = (int32_t)((ii * 37) % 2000) - 1000;
+			im[ii] = 0;
+		}
+		ADXL362Dsp::fft(re, im, 256, cosTable, sinTable);
+		doNotOptimize(re[1]);
+	});
+}
+
+// Discards the output, like Serial with nothing connected, but counts the writes
+class NullPrint : public Print {
+public:
+	size_t write(const uint8_t *buf, size_t size) {
+		writes++;
+		bytes += size;
+		return size;
+	}
+	using Print::write;
+
+	size_t writes = 0;
+	size_t bytes = 0;
+};
+
+static void benchText() {
+	static ADXL362DataEx<1020> xyz;
+	fillBuffer(xyz, false, 170);
+
+	// Example 2 before ADXL362TextFormatter
+	bench("text/printlnf", 170, []() {
+		static NullPrint out;
+		for(size_t ii = 0; ii < xyz.numSamplesRead; ii++) {
+			out.printlnf("%5d %5d %5d", (int)xyz.readX(ii), (int)xyz.readY(ii), (int)xyz.readZ(ii));
+		}
+		doNotOptimize(out.bytes);
+	});
+
+	bench("text/snprintf", 170, []() {
+		static NullPrint out;
+		static char textBuf[1024];
+		size_t len = 0;
+		for(size_t ii = 0; ii < xyz.numSamplesRead; ii++) {
+			if (sizeof(textBuf) - len < ADXL362TextFormatterBase::MAX_LINE_LENGTH) {
+				out.write((const uint8_t *)textBuf, len);
+				len = 0;
+			}
+			len += snprintf(&textBuf[len], sizeof(textBuf) - len, "%5d %5d %5d\r\n", (int)xyz.readX(ii), (int)xyz.readY(ii), (int)xyz.readZ(ii));
+		}
+		out.write((const uint8_t *)textBuf, len);
+		doNotOptimize(out.bytes);
+	});
+
+	bench("text/ADXL362TextFormatter", 170, []() {
+		static NullPrint out;
+		static ADXL362TextFormatter<> formatter;
+		formatter.write(out, xyz);
+		doNotOptimize(out.bytes);
+	});
+
+	bench("text/ADXL362TextFormatter/csv", 170, []() {
+		static NullPrint out;
+		static ADXL362TextFormatter<> formatter;
+		static bool initialized = false;
+		if (!initialized) {
+			formatter.setColumns(ADXL362TextFormatterBase::COLUMN_SAMPLE | ADXL362TextFormatterBase::COLUMN_TIME, 400);
+			formatter.setSeparator(',');
+			formatter.setWidth(0);
+			formatter.setLineEnding("\n");
+			initialized = true;
+		}
+		formatter.write(out, xyz);
+		doNotOptimize(out.bytes);
+	});
+}
+
+int main(int argc, char *argv[]) {
+	for(int ii = 1; ii < argc; ii++) {
+		std::string arg = argv[ii];
+		if (arg.rfind("--filter=", 0) == 0) {
+			filter = arg.substr(9);
+		}
+		else
+		if (arg.rfind("--min-time=", 0) == 0) {
+			minTime = atof(arg.substr(11).c_str());
+		}
+		else
+		if (arg.rfind("--repetitions=", 0) == 0) {
+			repetitions = std::max(1, atoi(arg.substr(14).c_str()));
+		}
+		else {
+			fprintf(stderr, "usage: %s [--filter=substring] [--min-time=seconds] [--repetitions=n]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	Log.level = Logger::LEVEL_ERROR;
+
+	benchDecode();
+	benchDriver();
+	benchDsp();
+	benchText();
+
+	writeJson();
+	return 0;
+}
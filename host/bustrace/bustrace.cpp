@@ -0,0 +1,359 @@
+// Converts ADXL362BusRecorder dumps into a Chrome trace (Perfetto) JSON timeline
+//
+// Reads the "adxl362bus," lines written by ADXL362BusRecorder::dump() (other lines, such as log
+// messages captured from the same serial port, are ignored) and writes a JSON trace that can be
+// opened with https://ui.perfetto.dev or chrome://tracing. Each context (device) is a track with a
+// slice for each transaction, with "wait for bus" and "DMA" slices inside it, and the "bus" track
+// shows when CS was low for any device.
+//
+// A summary of where the bus time goes is written to stderr: time per kind of transaction compared
+// with the time the bytes take at the SPI clock, time waiting for the bus, and gaps between
+// transactions. The SPI clock is taken from the dump header if dump() was passed it, otherwise it
+// is 4 MHz (the driver default) unless --spi-clock is given. --spi-clock overrides the dump.
+//
+// Build (Linux or Mac):
+// g++ -O2 -std=gnu++17 -I.. -I../../src bustrace.cpp -o bustrace
+//
+// Run this like:
+// ./bustrace bus.txt > trace.json
+// ./bustrace --spi-clock=8000000 --output=trace.json serial-capture.txt
+
+#include "Particle.h"
+
+#include "ADXL362DMA.h"
+#include "ADXL362BusRecorder.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+struct Transaction {
+	uint8_t context = 0;		//!< Context from the events
+	uint8_t cmd = 0;			//!< Command byte
+	uint8_t reg = 0;			//!< Register address
+	uint16_t len = 0;			//!< Bytes in the transaction
+	uint64_t beginUs = 0;		//!< EVENT_BEGIN
+	uint64_t selectUs = 0;		//!< EVENT_SELECT
+	uint64_t dmaUs = 0;			//!< EVENT_DMA_START, or 0
+	uint64_t endUs = 0;			//!< EVENT_END
+};
+
+struct Totals {
+	uint64_t count = 0;			//!< Transactions
+	uint64_t bytes = 0;			//!< Bytes transferred
+	uint64_t totalUs = 0;		//!< Begin to end
+	uint64_t waitUs = 0;		//!< Begin to select
+	uint64_t maxUs = 0;			//!< Longest begin to end
+};
+
+static std::string transactionName(const Transaction &t) {
+	char buf[64];
+
+	switch(t.cmd) {
+		case ADXL362DMA::CMD_READ_FIFO:
+			return "readFifo";
+
+		case ADXL362DMA::CMD_READ_REGISTER:
+			switch(t.reg) {
+				case ADXL362DMA::REG_FIFO_ENTRIES_L:
+					return "readNumFifoEntries";
+				case ADXL362DMA::REG_STATUS:
+					return "readStatus";
+				case ADXL362DMA::REG_XDATA_L:
+					return "readXYZ";
+				case ADXL362DMA::REG_DEVID_AD:
+				case ADXL362DMA::REG_DEVID_MST:
+					return "chipDetect";
+			}
+			snprintf(buf, sizeof(buf), "readRegister 0x%02x", t.reg);
+			return buf;
+
+		case ADXL362DMA::CMD_WRITE_REGISTER:
+			if (t.reg == ADXL362DMA::REG_SOFT_RESET) {
+				return "softReset";
+			}
+			snprintf(buf, sizeof(buf), "writeRegister 0x%02x", t.reg);
+			return buf;
+	}
+	snprintf(buf, sizeof(buf), "command 0x%02x", t.cmd);
+	return buf;
+}
+
+// Parses the events from the input; returns false on a read error
+static bool readTransactions(FILE *fp, std::vector<Transaction> &transactions, uint64_t &overwritten, uint64_t &unmatched, unsigned &dumpSpiClock) {
+	std::map<uint8_t, Transaction> open;
+	bool haveTime = false;
+	uint32_t lastMicros = 0;
+	uint64_t timeBase = 0;
+
+	char line[512];
+	while(fgets(line, sizeof(line), fp)) {
+		const char *p = strstr(line, "adxl362bus,");
+		if (!p) {
+			continue;
+		}
+		p += 11;
+
+		unsigned long n1, n2;
+		int fields = sscanf(p, "dump,%*u,%lu,%lu", &n1, &n2);
+		if (fields >= 1) {
+			overwritten += n1;
+			if (fields == 2 && n2 != 0) {
+				// Older dumps don't include the SPI clock
+				dumpSpiClock = (unsigned)n2;
+			}
+			continue;
+		}
+
+		unsigned long micros32;
+		unsigned context, type, cmd, reg, len;
+		if (sscanf(p, "%lu,%u,%u,%u,%u,%u", &micros32, &context, &type, &cmd, &reg, &len) != 6) {
+			continue;
+		}
+
+		// micros() rolls over every 71 minutes
+		if (haveTime && (uint32_t)micros32 < lastMicros && lastMicros - (uint32_t)micros32 > 0x80000000) {
+			timeBase += 0x100000000ULL;
+		}
+		haveTime = true;
+		lastMicros = (uint32_t)micros32;
+		uint64_t us = timeBase + (uint32_t)micros32;
+
+		auto it = open.find((uint8_t)context);
+		switch(type) {
+			case ADXL362BusRecorderBase::EVENT_BEGIN: {
+				if (it != open.end()) {
+					unmatched++;
+				}
+				Transaction t;
+				t.context = (uint8_t)context;
+				t.cmd = (uint8_t)cmd;
+				t.reg = (uint8_t)reg;
+				t.len = (uint16_t)len;
+				t.beginUs = t.selectUs = us;
+				open[(uint8_t)context] = t;
+				break;
+			}
+
+			case ADXL362BusRecorderBase::EVENT_SELECT:
+				if (it != open.end()) {
+					it->second.selectUs = us;
+				}
+				break;
+
+			case ADXL362BusRecorderBase::EVENT_DMA_START:
+				if (it != open.end()) {
+					it->second.dmaUs = us;
+				}
+				break;
+
+			case ADXL362BusRecorderBase::EVENT_END:
+				if (it != open.end()) {
+					it->second.endUs = us;
+					transactions.push_back(it->second);
+					open.erase(it);
+				}
+				else {
+					// The start of the transaction was overwritten in the ring
+					unmatched++;
+				}
+				break;
+		}
+	}
+	unmatched += open.size();
+
+	return !ferror(fp);
+}
+
+static void writeSlice(FILE *out, bool &first, const char *name, const char *cat, int tid, uint64_t ts, uint64_t dur, const std::string &args) {
+	fprintf(out, "%s\n    {\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %llu, \"dur\": %llu%s%s%s}",
+		first ? "" : ",", name, cat, tid, (unsigned long long)ts, (unsigned long long)dur,
+		args.empty() ? "" : ", \"args\": {", args.c_str(), args.empty() ? "" : "}");
+	first = false;
+}
+
+static void writeTrace(FILE *out, const std::vector<Transaction> &transactions, uint64_t startUs, unsigned spiClock) {
+	bool first = true;
+
+	fprintf(out, "{\n  \"displayTimeUnit\": \"ms\",\n  \"traceEvents\": [");
+
+	fprintf(out, "\n    {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"ADXL362 SPI bus\"}}");
+	fprintf(out, ",\n    {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, \"args\": {\"name\": \"bus (CS low)\"}}");
+	first = false;
+
+	std::map<uint8_t, bool> contexts;
+	for(const Transaction &t : transactions) {
+		if (!contexts[t.context]) {
+			contexts[t.context] = true;
+			fprintf(out, ",\n    {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"args\": {\"name\": \"context %u\"}}", t.context + 1, t.context);
+		}
+	}
+
+	for(const Transaction &t : transactions) {
+		std::string name = transactionName(t);
+		int tid = t.context + 1;
+
+		char args[256];
+		snprintf(args, sizeof(args), "\"bytes\": %u, \"reg\": \"0x%02x\", \"context\": %u, \"wait_us\": %llu, \"ideal_us\": %.1f",
+			t.len, t.reg, t.context, (unsigned long long)(t.selectUs - t.beginUs), (double)t.len * 8e6 / spiClock);
+
+		writeSlice(out, first, name.c_str(), "transaction", tid, t.beginUs - startUs, t.endUs - t.beginUs, args);
+		if (t.selectUs > t.beginUs) {
+			writeSlice(out, first, "wait for bus", "wait", tid, t.beginUs - startUs, t.selectUs - t.beginUs, "");
+		}
+		if (t.dmaUs) {
+			writeSlice(out, first, "DMA", "dma", tid, t.dmaUs - startUs, t.endUs - t.dmaUs, "");
+		}
+		writeSlice(out, first, name.c_str(), "bus", 0, t.selectUs - startUs, t.endUs - t.selectUs, args);
+	}
+
+	fprintf(out, "\n  ]\n}\n");
+}
+
+static void writeSummary(const std::vector<Transaction> &transactions, unsigned spiClock, uint64_t overwritten, uint64_t unmatched) {
+	std::map<std::string, Totals> totals;
+	uint64_t busyUs = 0, waitUs = 0;
+	uint64_t gapCount = 0, gapTotalUs = 0, gapMinUs = UINT64_MAX, gapMaxUs = 0;
+
+	// Gap from readNumFifoEntries to the readFifo that follows it, for the same context
+	std::map<uint8_t, uint64_t> entriesEndUs;
+	uint64_t entriesGapCount = 0, entriesGapTotalUs = 0;
+
+	const Transaction *prev = nullptr;
+	for(const Transaction &t : transactions) {
+		std::string name = transactionName(t);
+		Totals &tot = totals[name];
+		uint64_t us = t.endUs - t.beginUs;
+		tot.count++;
+		tot.bytes += t.len;
+		tot.totalUs += us;
+		tot.waitUs += t.selectUs - t.beginUs;
+		if (us > tot.maxUs) {
+			tot.maxUs = us;
+		}
+		busyUs += t.endUs - t.selectUs;
+		waitUs += t.selectUs - t.beginUs;
+
+		if (prev && t.selectUs >= prev->endUs) {
+			uint64_t gap = t.selectUs - prev->endUs;
+			gapCount++;
+			gapTotalUs += gap;
+			if (gap < gapMinUs) gapMinUs = gap;
+			if (gap > gapMaxUs) gapMaxUs = gap;
+		}
+		prev = &t;
+
+		if (t.cmd == ADXL362DMA::CMD_READ_FIFO) {
+			auto it = entriesEndUs.find(t.context);
+			if (it != entriesEndUs.end() && t.beginUs >= it->second) {
+				entriesGapCount++;
+				entriesGapTotalUs += t.beginUs - it->second;
+			}
+		}
+		if (t.cmd == ADXL362DMA::CMD_READ_REGISTER && t.reg == ADXL362DMA::REG_FIFO_ENTRIES_L) {
+			entriesEndUs[t.context] = t.endUs;
+		}
+		else {
+			entriesEndUs.erase(t.context);
+		}
+	}
+
+	uint64_t spanUs = transactions.empty() ? 0 : transactions.back().endUs - transactions.front().beginUs;
+
+	fprintf(stderr, "%llu transactions in %.3f ms, SPI clock %.1f MHz", (unsigned long long)transactions.size(), (double)spanUs / 1000.0, (double)spiClock / 1e6);
+	if (overwritten || unmatched) {
+		fprintf(stderr, " (%llu events overwritten, %llu unmatched)", (unsigned long long)overwritten, (unsigned long long)unmatched);
+	}
+	fprintf(stderr, "\n\n");
+
+	fprintf(stderr, "%-24s %8s %10s %10s %10s %10s %10s %8s\n", "transaction", "count", "bytes", "total us", "mean us", "max us", "ideal us", "overhead");
+	for(const auto &it : totals) {
+		const Totals &tot = it.second;
+		double idealUs = (double)tot.bytes * 8e6 / spiClock;
+		double overhead = tot.totalUs ? 100.0 * ((double)tot.totalUs - idealUs) / (double)tot.totalUs : 0.0;
+		fprintf(stderr, "%-24s %8llu %10llu %10llu %10.1f %10llu %10.0f %7.1f%%\n", it.first.c_str(),
+			(unsigned long long)tot.count, (unsigned long long)tot.bytes, (unsigned long long)tot.totalUs,
+			(double)tot.totalUs / (double)tot.count, (unsigned long long)tot.maxUs, idealUs, overhead);
+	}
+	fprintf(stderr, "\n");
+
+	if (spanUs) {
+		fprintf(stderr, "bus busy (CS low)        %.2f%% of the time\n", 100.0 * (double)busyUs / (double)spanUs);
+	}
+	fprintf(stderr, "waiting for the bus      %llu us\n", (unsigned long long)waitUs);
+	if (gapCount) {
+		fprintf(stderr, "gap between transactions min %llu us, mean %.1f us, max %llu us\n",
+			(unsigned long long)gapMinUs, (double)gapTotalUs / (double)gapCount, (unsigned long long)gapMaxUs);
+	}
+	if (entriesGapCount) {
+		fprintf(stderr, "readNumFifoEntries to readFifo mean %.1f us\n", (double)entriesGapTotalUs / (double)entriesGapCount);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	std::string inputPath;
+	std::string outputPath;
+	unsigned spiClock = 0;
+
+	for(int ii = 1; ii < argc; ii++) {
+		std::string arg = argv[ii];
+		if (arg.rfind("--spi-clock=", 0) == 0) {
+			spiClock = (unsigned)atoi(arg.substr(12).c_str());
+		}
+		else
+		if (arg.rfind("--output=", 0) == 0) {
+			outputPath = arg.substr(9);
+		}
+		else
+		if ((arg == "-" || arg.rfind("--", 0) != 0) && inputPath.empty()) {
+			inputPath = arg;
+		}
+		else {
+			inputPath.clear();
+			break;
+		}
+	}
+	if (inputPath.empty()) {
+		fprintf(stderr, "usage: %s [--spi-clock=hz] [--output=trace.json] dump.txt|-\n", argv[0]);
+		return 1;
+	}
+
+	FILE *in = (inputPath == "-") ? stdin : fopen(inputPath.c_str(), "r");
+	if (!in) {
+		fprintf(stderr, "could not open %s: %s\n", inputPath.c_str(), strerror(errno));
+		return 1;
+	}
+
+	std::vector<Transaction> transactions;
+	uint64_t overwritten = 0, unmatched = 0;
+	unsigned dumpSpiClock = 4 * MHZ;
+	bool ok = readTransactions(in, transactions, overwritten, unmatched, dumpSpiClock);
+	if (in != stdin) {
+		fclose(in);
+	}
+	if (!ok) {
+		fprintf(stderr, "error reading %s\n", inputPath.c_str());
+		return 1;
+	}
+	if (spiClock == 0) {
+		spiClock = dumpSpiClock;
+	}
+
+	FILE *out = stdout;
+	if (!outputPath.empty()) {
+		out = fopen(outputPath.c_str(), "w");
+		if (!out) {
+			fprintf(stderr, "could not create %s: %s\n", outputPath.c_str(), strerror(errno));
+			return 1;
+		}
+	}
+
+	uint64_t startUs = transactions.empty() ? 0 : transactions.front().beginUs;
+	writeTrace(out, transactions, startUs, spiClock);
+	if (out != stdout) {
+		fclose(out);
+	}
+
+	writeSummary(transactions, spiClock, overwritten, unmatched);
+	return 0;
+}
@@ -0,0 +1,461 @@
+// Receives ADXL362SerialStream packets from many devices over TCP and stores them
+//
+// A single-threaded epoll server. Each device connects, sends its device ID on a line by itself
+// (for example System.deviceID() followed by "\n"), and then the COBS-framed packets from
+// ADXL362SerialStream, which can write to a TCPClient as well as to Serial. The samples are
+// stored with ADXL362SampleStore in per-device, time-partitioned, compressed chunks.
+//
+// Sample times come from the server clock: the last sample of the first packet on a connection is
+// given the time it arrived, and later samples are placed by sample number at the output data
+// rate. If that drifts more than a second from the arrival times (the device's clock is not
+// exactly the output data rate), the time is set again from the arrival time.
+//
+// The same program reads the store back with --list and --query.
+//
+// Build (Linux):
+// g++ -O2 -std=gnu++17 -I.. -I../../src ingest.cpp ../Particle.cpp ../ADXL362SampleStore.cpp ../../src/ADXL362DMA.cpp ../../src/ADXL362SerialStream.cpp -o ingest
+//
+// Run this like:
+// ./ingest --data=data --port=7124
+// ./ingest --data=data --list
+// ./ingest --data=data --query=e00fce68ffffffffffffffff --from=1790000000 --to=1790000060 > samples.csv
+//
+// loadgen.cpp in this directory connects simulated devices for load testing.
+
+#include "Particle.h"
+
+#include "ADXL362SampleStore.h"
+#include "ADXL362SerialStream.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void signalHandler(int) {
+	stopRequested = 1;
+}
+
+static uint64_t nowUs() {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+struct Options {
+	std::string dataDir = "data";		//!< Store directory
+	int port = 7124;					//!< TCP port to listen on
+	uint32_t partitionSeconds = 3600;	//!< Length of a time partition
+	size_t chunkSamples = 4096;			//!< Maximum samples in a chunk
+	bool directIO = true;				//!< Try O_DIRECT
+	unsigned statsSeconds = 10;			//!< How often to print statistics
+	bool list = false;					//!< List the devices in the store and exit
+	std::string query;					//!< Device ID to write samples for, then exit
+	double fromSeconds = 0;				//!< Start of the query, seconds since 1970
+	double toSeconds = 1e12;			//!< End of the query, seconds since 1970
+};
+
+struct Stats {
+	uint64_t connections = 0;		//!< Connections accepted
+	uint64_t bytes = 0;				//!< Bytes received
+	uint64_t packets = 0;			//!< Valid packets
+	uint64_t badFrames = 0;			//!< Frames with invalid COBS encoding, CRC, or length
+	uint64_t lostPackets = 0;		//!< Packets missing from the sequence
+	uint64_t restarts = 0;			//!< Times a device stream started over (device reset or begin() called again)
+	uint64_t samples = 0;			//!< Samples stored
+};
+
+/**
+ * @brief One device connection
+ */
+class Connection {
+public:
+	Connection(int fd, ADXL362SampleStore &store, Stats &stats) : fd(fd), store(store), stats(stats) {};
+
+	/**
+	 * @brief Process bytes received from the device
+	 *
+	 * @return false to close the connection
+	 */
+	bool received(const uint8_t *data, size_t len, uint64_t receivedUs) {
+		const uint8_t *end = data + len;
+
+		while(data < end && !haveDeviceId) {
+			char c = (char)*data++;
+			if (c == '\n') {
+				if (deviceId.empty()) {
+					return false;
+				}
+				haveDeviceId = true;
+				Log.info("device %s connected", deviceId.c_str());
+			}
+			else
+			if (c != '\r') {
+				if (deviceId.size() >= ADXL362SampleStore::MAX_DEVICE_ID_LEN || !(isalnum(c) || c == '-' || c == '_' || c == '.')) {
+					Log.info("closing connection with an invalid device ID");
+					return false;
+				}
+				deviceId += c;
+			}
+		}
+
+		// Split into frames at the 0 delimiters
+		while(data < end) {
+			const uint8_t *delim = (const uint8_t *)memchr(data, 0, end - data);
+			const uint8_t *frameEnd = delim ? delim : end;
+
+			if (!discarding) {
+				if (frame.size() + (frameEnd - data) > MAX_FRAME) {
+					// Too long to be a packet; skip to the next delimiter
+					discarding = true;
+					frame.clear();
+				}
+				else {
+					frame.insert(frame.end(), data, frameEnd);
+				}
+			}
+			if (!delim) {
+				break;
+			}
+			if (discarding) {
+				stats.badFrames++;
+				discarding = false;
+			}
+			else
+			if (!frame.empty()) {
+				packet(receivedUs);
+			}
+			frame.clear();
+			data = delim + 1;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Decode and store a complete frame
+	 */
+	void packet(uint64_t receivedUs) {
+		size_t len;
+		ADXL362SerialStreamBase::PacketHeader header;
+		const uint8_t *payload;
+		if (!ADXL362SerialStreamBase::cobsDecode(frame.data(), frame.size(), frame.data(), len) ||
+			!ADXL362SerialStreamBase::parsePacket(frame.data(), len, header, payload) ||
+			header.rateTenthsHz == 0) {
+			stats.badFrames++;
+			return;
+		}
+		stats.packets++;
+
+		// A restarted stream begins again at sequence 0 and sample 0, which is not a gap
+		bool restart = havePacket && ((header.sequence == 0 && header.firstSample == 0) || header.firstSample < nextSample);
+		if (restart) {
+			stats.restarts++;
+		}
+		else
+		if (havePacket) {
+			stats.lostPackets += (uint16_t)(header.sequence - nextSequence);
+		}
+		nextSequence = header.sequence + 1;
+
+		// Time of the first sample in the packet, from the server clock
+		uint64_t periodsUs = (uint64_t)(header.numSamples ? header.numSamples - 1 : 0) * 10000000 / header.rateTenthsHz;
+		uint64_t timeUs = 0;
+		bool anchor = !havePacket || restart || header.rateTenthsHz != anchorRateTenthsHz;
+		if (!anchor) {
+			timeUs = anchorUs + (uint64_t)(header.firstSample - anchorSample) * 10000000 / header.rateTenthsHz;
+			int64_t driftUs = (int64_t)(timeUs + periodsUs) - (int64_t)receivedUs;
+			anchor = (driftUs > MAX_DRIFT_US || driftUs < -MAX_DRIFT_US);
+		}
+		if (anchor) {
+			timeUs = receivedUs - periodsUs;
+			anchorUs = timeUs;
+			anchorSample = header.firstSample;
+			anchorRateTenthsHz = header.rateTenthsHz;
+		}
+		havePacket = true;
+		nextSample = header.firstSample + header.numSamples;
+
+		samples.resize(header.numSamples);
+		for(size_t ii = 0; ii < header.numSamples; ii++) {
+			ADXL362SerialStreamBase::readSample(header, payload, ii, samples[ii]);
+		}
+		bool hasTemp = (header.flags & ADXL362SerialStreamBase::FLAG_TEMP) != 0;
+		store.append(deviceId.c_str(), timeUs, header.firstSample, header.rateTenthsHz, header.rangeG, hasTemp, samples.data(), samples.size());
+		stats.samples += header.numSamples;
+	}
+
+	int fd; //!< Socket
+	std::string deviceId; //!< Device ID from the first line
+
+	static const size_t MAX_FRAME = 4096; //!< Longest frame accepted (packets of up to about 500 samples)
+	static const int64_t MAX_DRIFT_US = 1000000; //!< Set the time again if it drifts this far
+
+protected:
+	ADXL362SampleStore &store; //!< Where to store the samples
+	Stats &stats; //!< Server counters
+	bool haveDeviceId = false; //!< The device ID line has been received
+	std::vector<uint8_t> frame; //!< Bytes of the current frame
+	bool discarding = false; //!< Skipping an oversized frame
+	std::vector<ADXL362Sample> samples; //!< Samples from the current packet
+	bool havePacket = false; //!< A packet has been received
+	uint16_t nextSequence = 0; //!< Expected packet sequence
+	uint32_t nextSample = 0; //!< Expected sample number
+	uint64_t anchorUs = 0; //!< Time of sample anchorSample
+	uint32_t anchorSample = 0; //!< Sample number that anchorUs is the time of
+	uint16_t anchorRateTenthsHz = 0; //!< Rate when anchored
+};
+
+static void usage(const char *argv0) {
+	fprintf(stderr, "usage: %s [--data=dir] [--port=n] [--partition-seconds=n] [--chunk-samples=n]\n", argv0);
+	fprintf(stderr, "          [--no-direct] [--stats-seconds=n]\n");
+	fprintf(stderr, "       %s [--data=dir] --list\n", argv0);
+	fprintf(stderr, "       %s [--data=dir] --query=deviceId [--from=seconds] [--to=seconds]\n", argv0);
+}
+
+static int list(ADXL362SampleStore &store) {
+	printf("%-32s %8s %10s  %-20s %s\n", "device", "chunks", "samples", "first", "last");
+	for(const std::string &deviceId : store.getDeviceIds()) {
+		const std::vector<ADXL362SampleStore::IndexEntry> *entries = store.getIndex(deviceId.c_str());
+		uint64_t numSamples = 0, lastUs = 0;
+		for(const ADXL362SampleStore::IndexEntry &entry : *entries) {
+			numSamples += entry.numSamples;
+			if (entry.lastTimeUs > lastUs) {
+				lastUs = entry.lastTimeUs;
+			}
+		}
+		printf("%-32s %8zu %10llu  %-20.6f %.6f\n", deviceId.c_str(), entries->size(), (unsigned long long)numSamples,
+			(double)entries->front().firstTimeUs / 1e6, (double)lastUs / 1e6);
+	}
+	return 0;
+}
+
+static int query(ADXL362SampleStore &store, const Options &opts) {
+	std::vector<char> outBuf(1024 * 1024);
+	setvbuf(stdout, outBuf.data(), _IOFBF, outBuf.size());
+
+	printf("time,sample,x,y,z,t\n");
+	size_t count = store.query(opts.query.c_str(), (uint64_t)(opts.fromSeconds * 1e6), (uint64_t)(opts.toSeconds * 1e6),
+		[](uint64_t timeUs, uint32_t sampleNum, const ADXL362Sample &sample) {
+			printf("%llu.%06u,%lu,%d,%d,%d,%d\n", (unsigned long long)(timeUs / 1000000), (unsigned)(timeUs % 1000000),
+				(unsigned long)sampleNum, sample.x, sample.y, sample.z, sample.t);
+		});
+	fflush(stdout);
+
+	fprintf(stderr, "%zu samples\n", count);
+	return 0;
+}
+
+static void printStats(const ADXL362SampleStore &store, const Stats &stats, size_t numConnections, double seconds, uint64_t periodSamples) {
+	const ADXL362SampleStore::Stats &storeStats = store.getStats();
+
+	printf("%zu devices, %.0f samples/s, %llu samples, %llu packets, %llu bad frames, %llu lost packets, %llu restarts\n",
+		numConnections, (seconds > 0) ? (double)periodSamples / seconds : 0.0, (unsigned long long)stats.samples,
+		(unsigned long long)stats.packets, (unsigned long long)stats.badFrames, (unsigned long long)stats.lostPackets,
+		(unsigned long long)stats.restarts);
+	printf("  stored %llu chunks, %.1f MB (%.2f bytes/sample, %.1fx), %llu writes, %.1f MB written%s%s\n",
+		(unsigned long long)storeStats.chunks, (double)storeStats.chunkBytes / 1e6,
+		storeStats.sealedSamples ? (double)storeStats.chunkBytes / (double)storeStats.sealedSamples : 0.0,
+		storeStats.chunkBytes ? (double)storeStats.rawBytes / (double)storeStats.chunkBytes : 0.0,
+		(unsigned long long)storeStats.writes, (double)storeStats.bytesWritten / 1e6,
+		store.isDirectIO() ? ", O_DIRECT" : "",
+		storeStats.writeErrors ? ", WRITE ERRORS" : "");
+	fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+	Options opts;
+
+	for(int ii = 1; ii < argc; ii++) {
+		std::string arg = argv[ii];
+		if (arg.rfind("--data=", 0) == 0) {
+			opts.dataDir = arg.substr(7);
+		}
+		else
+		if (arg.rfind("--port=", 0) == 0) {
+			opts.port = atoi(arg.substr(7).c_str());
+		}
+		else
+		if (arg.rfind("--partition-seconds=", 0) == 0) {
+			opts.partitionSeconds = (uint32_t)atoi(arg.substr(20).c_str());
+		}
+		else
+		if (arg.rfind("--chunk-samples=", 0) == 0) {
+			opts.chunkSamples = (size_t)atoi(arg.substr(16).c_str());
+		}
+		else
+		if (arg == "--no-direct") {
+			opts.directIO = false;
+		}
+		else
+		if (arg.rfind("--stats-seconds=", 0) == 0) {
+			opts.statsSeconds = (unsigned)atoi(arg.substr(16).c_str());
+		}
+		else
+		if (arg == "--list") {
+			opts.list = true;
+		}
+		else
+		if (arg.rfind("--query=", 0) == 0) {
+			opts.query = arg.substr(8);
+		}
+		else
+		if (arg.rfind("--from=", 0) == 0) {
+			opts.fromSeconds = atof(arg.substr(7).c_str());
+		}
+		else
+		if (arg.rfind("--to=", 0) == 0) {
+			opts.toSeconds = atof(arg.substr(5).c_str());
+		}
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (opts.port <= 0 || opts.port > 65535 || opts.partitionSeconds == 0 || opts.chunkSamples == 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	ADXL362SampleStore store;
+	store.setPartitionSeconds(opts.partitionSeconds);
+	store.setChunkSamples(opts.chunkSamples);
+	store.setDirectIO(opts.directIO);
+	if (!store.open(opts.dataDir.c_str())) {
+		return 1;
+	}
+
+	if (opts.list) {
+		return list(store);
+	}
+	if (!opts.query.empty()) {
+		return query(store, opts);
+	}
+
+	int listenFd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK, 0);
+	if (listenFd < 0) {
+		fprintf(stderr, "could not create socket: %s\n", strerror(errno));
+		return 1;
+	}
+	int on = 1;
+	setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+	struct sockaddr_in6 addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin6_family = AF_INET6;
+	addr.sin6_addr = in6addr_any;
+	addr.sin6_port = htons((uint16_t)opts.port);
+	if (bind(listenFd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listenFd, 256) != 0) {
+		fprintf(stderr, "could not listen on port %d: %s\n", opts.port, strerror(errno));
+		return 1;
+	}
+
+	int epollFd = epoll_create1(0);
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = listenFd;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+
+	signal(SIGINT, signalHandler);
+	signal(SIGTERM, signalHandler);
+	signal(SIGPIPE, SIG_IGN);
+
+	printf("listening on port %d for data, storing in %s\n", opts.port, opts.dataDir.c_str());
+	fflush(stdout);
+
+	Stats stats;
+	std::map<int, std::unique_ptr<Connection>> connections;
+	std::vector<uint8_t> readBuf(65536);
+	struct epoll_event events[64];
+
+	uint64_t lastStatsUs = nowUs();
+	uint64_t lastStatsSamples = 0;
+
+	while(!stopRequested) {
+		int numEvents = epoll_wait(epollFd, events, 64, 100);
+		if (numEvents < 0 && errno != EINTR) {
+			fprintf(stderr, "epoll_wait failed: %s\n", strerror(errno));
+			break;
+		}
+		uint64_t receivedUs = nowUs();
+
+		for(int ii = 0; ii < numEvents; ii++) {
+			int fd = events[ii].data.fd;
+
+			if (fd == listenFd) {
+				int clientFd;
+				while((clientFd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+					setsockopt(clientFd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+					ev.events = EPOLLIN | EPOLLRDHUP;
+					ev.data.fd = clientFd;
+					epoll_ctl(epollFd, EPOLL_CTL_ADD, clientFd, &ev);
+					connections[clientFd].reset(new Connection(clientFd, store, stats));
+					stats.connections++;
+				}
+				continue;
+			}
+
+			auto it = connections.find(fd);
+			if (it == connections.end()) {
+				continue;
+			}
+
+			// Read what is available, up to a limit so one device can't starve the others
+			bool keep = true;
+			for(int reads = 0; reads < 16 && keep; reads++) {
+				ssize_t count = read(fd, readBuf.data(), readBuf.size());
+				if (count > 0) {
+					stats.bytes += count;
+					keep = it->second->received(readBuf.data(), (size_t)count, receivedUs);
+					if ((size_t)count < readBuf.size()) {
+						break;
+					}
+				}
+				else
+				if (count < 0 && (errno == EAGAIN || errno == EINTR)) {
+					break;
+				}
+				else {
+					keep = false;
+				}
+			}
+			if (!keep) {
+				if (!it->second->deviceId.empty()) {
+					Log.info("device %s disconnected", it->second->deviceId.c_str());
+				}
+				epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+				close(fd);
+				connections.erase(it);
+			}
+		}
+
+		store.tick(receivedUs);
+
+		if (opts.statsSeconds && receivedUs - lastStatsUs >= (uint64_t)opts.statsSeconds * 1000000) {
+			printStats(store, stats, connections.size(), (double)(receivedUs - lastStatsUs) / 1e6, stats.samples - lastStatsSamples);
+			lastStatsUs = receivedUs;
+			lastStatsSamples = stats.samples;
+		}
+	}
+
+	for(auto &it : connections) {
+		close(it.first);
+	}
+	close(listenFd);
+	close(epollFd);
+
+	store.close();
+	printStats(store, stats, 0, 0, 0);
+
+	return 0;
+}
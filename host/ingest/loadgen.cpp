@@ -0,0 +1,285 @@
+// Load generator for the ingest server: simulated devices streaming ADXL362SerialStream packets
+//
+// Each simulated device opens a TCP connection, sends its device ID line, and then streams packets
+// from ADXL362SerialStream the way a device would after each readFifoAsync(): a buffer of raw FIFO
+// samples at the output data rate every --interval-ms. The samples are 1g on Z with a vibration
+// at a different frequency for each device, and a little noise, so they compress like real data.
+//
+// Build (Linux):
+// g++ -O2 -std=gnu++17 -I.. -I../../src loadgen.cpp ../Particle.cpp ../ADXL362Sim.cpp ../../src/ADXL362DMA.cpp ../../src/ADXL362SerialStream.cpp -o loadgen
+//
+// Run this like:
+// ./loadgen --devices=100 --seconds=60
+// ./loadgen --devices=200 --seconds=30 --speed=10
+
+#include "Particle.h"
+
+#include "ADXL362Sim.h"
+#include "ADXL362SerialStream.h"
+
+#include <errno.h>
+#include <math.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void signalHandler(int) {
+	stopRequested = 1;
+}
+
+struct Options {
+	std::string host = "127.0.0.1";		//!< Ingest server
+	std::string port = "7124";			//!< Ingest server port
+	unsigned devices = 100;				//!< Simulated devices
+	float odr = 400;					//!< Output data rate in Hz
+	double seconds = 10;				//!< How long to run
+	double speed = 1;					//!< Samples are generated this many times faster than real time
+	unsigned intervalMs = 100;			//!< How often each device sends a buffer
+	bool storeTemp = false;				//!< Include temperature in the samples
+	std::string prefix = "loadgen";		//!< Device IDs are prefix-0001, etc.
+};
+
+/**
+ * @brief Print that collects the bytes to send on a socket
+ */
+class SocketPrint : public Print {
+public:
+	virtual size_t write(const uint8_t *buf, size_t size) {
+		pending.insert(pending.end(), buf, buf + size);
+		return size;
+	};
+
+	std::vector<uint8_t> pending; //!< Bytes not sent yet
+};
+
+/**
+ * @brief One simulated device
+ */
+struct Device {
+	int fd = -1;						//!< Connection to the server
+	SocketPrint out;					//!< Packets to send
+	ADXL362SerialStream<64> stream;		//!< Packet encoder
+	uint64_t samplesSent = 0;			//!< Samples generated so far
+	double vibrationHz = 0;				//!< Frequency of the simulated vibration
+	std::mt19937 rng;					//!< Noise
+};
+
+static int connectToServer(const Options &opts) {
+	struct addrinfo hints, *res;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if (getaddrinfo(opts.host.c_str(), opts.port.c_str(), &hints, &res) != 0) {
+		return -1;
+	}
+
+	int fd = -1;
+	for(struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+		fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+			break;
+		}
+		if (fd >= 0) {
+			close(fd);
+			fd = -1;
+		}
+	}
+	freeaddrinfo(res);
+	return fd;
+}
+
+static bool sendAll(int fd, const uint8_t *data, size_t len) {
+	while(len > 0) {
+		ssize_t count = send(fd, data, len, 0);
+		if (count < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += count;
+		len -= (size_t)count;
+	}
+	return true;
+}
+
+static bool parseOdr(float odr, uint8_t &value) {
+	static const float rates[] = { 12.5, 25, 50, 100, 200, 400 };
+	for(uint8_t ii = 0; ii < sizeof(rates) / sizeof(rates[0]); ii++) {
+		if (odr == rates[ii]) {
+			value = ii;
+			return true;
+		}
+	}
+	return false;
+}
+
+int main(int argc, char *argv[]) {
+	Options opts;
+
+	for(int ii = 1; ii < argc; ii++) {
+		std::string arg = argv[ii];
+		if (arg.rfind("--host=", 0) == 0) {
+			opts.host = arg.substr(7);
+		}
+		else
+		if (arg.rfind("--port=", 0) == 0) {
+			opts.port = arg.substr(7);
+		}
+		else
+		if (arg.rfind("--devices=", 0) == 0) {
+			opts.devices = (unsigned)atoi(arg.substr(10).c_str());
+		}
+		else
+		if (arg.rfind("--odr=", 0) == 0) {
+			opts.odr = (float)atof(arg.substr(6).c_str());
+		}
+		else
+		if (arg.rfind("--seconds=", 0) == 0) {
+			opts.seconds = atof(arg.substr(10).c_str());
+		}
+		else
+		if (arg.rfind("--speed=", 0) == 0) {
+			opts.speed = atof(arg.substr(8).c_str());
+		}
+		else
+		if (arg.rfind("--interval-ms=", 0) == 0) {
+			opts.intervalMs = (unsigned)atoi(arg.substr(14).c_str());
+		}
+		else
+		if (arg == "--temp") {
+			opts.storeTemp = true;
+		}
+		else
+		if (arg.rfind("--prefix=", 0) == 0) {
+			opts.prefix = arg.substr(9);
+		}
+		else {
+			opts.devices = 0;
+			break;
+		}
+	}
+
+	uint8_t odr;
+	if (opts.devices == 0 || !parseOdr(opts.odr, odr) || opts.speed <= 0 || opts.intervalMs == 0) {
+		fprintf(stderr, "usage: %s [--host=addr] [--port=n] [--devices=n] [--odr=hz] [--seconds=n]\n", argv[0]);
+		fprintf(stderr, "          [--speed=n] [--interval-ms=n] [--temp] [--prefix=id]\n");
+		return 1;
+	}
+
+	Log.level = Logger::LEVEL_ERROR;
+
+	// The stream gets the output data rate and range from a driver, here on a simulated device
+	static ADXL362Sim sim;
+	SPI.attach(&sim, A2);
+	static ADXL362DMA accel(SPI, A2);
+	accel.softReset();
+	accel.writeFilterControl(accel.RANGE_2G, false, false, odr);
+
+	std::vector<std::unique_ptr<Device>> devices;
+	for(unsigned ii = 0; ii < opts.devices; ii++) {
+		std::unique_ptr<Device> device(new Device());
+		device->fd = connectToServer(opts);
+		if (device->fd < 0) {
+			fprintf(stderr, "could not connect to %s:%s: %s\n", opts.host.c_str(), opts.port.c_str(), strerror(errno));
+			return 1;
+		}
+		int on = 1;
+		setsockopt(device->fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+		char deviceId[80];
+		snprintf(deviceId, sizeof(deviceId), "%s-%04u\n", opts.prefix.c_str(), ii + 1);
+		sendAll(device->fd, (const uint8_t *)deviceId, strlen(deviceId));
+
+		device->stream.begin(device->out, accel);
+		device->vibrationHz = 5.0 + (ii % 40);
+		device->rng.seed(ii);
+		devices.push_back(std::move(device));
+	}
+
+	signal(SIGINT, signalHandler);
+	signal(SIGPIPE, SIG_IGN);
+
+	static ADXL362DataEx<65536> data;
+	data.storeTemp = opts.storeTemp;
+	data.sampleSizeInBytes = opts.storeTemp ? 8 : 6;
+	size_t maxSamples = data.bufSize / data.sampleSizeInBytes;
+
+	auto startTime = std::chrono::steady_clock::now();
+	uint64_t bytesSent = 0, samplesSent = 0;
+	bool failed = false;
+
+	while(!stopRequested && !failed) {
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		if (elapsed >= opts.seconds) {
+			break;
+		}
+		uint64_t due = (uint64_t)(elapsed * opts.speed * opts.odr);
+
+		for(size_t dev = 0; dev < devices.size() && !failed; dev++) {
+			Device &device = *devices[dev];
+
+			std::normal_distribution<double> noise(0.0, 2.0);
+			while(device.samplesSent < due && !failed) {
+				size_t count = (size_t)(due - device.samplesSent);
+				if (count > maxSamples) {
+					count = maxSamples;
+				}
+
+				// Raw FIFO entries, least significant byte first
+				uint8_t *p = data.buf;
+				for(size_t ii = 0; ii < count; ii++) {
+					double t = (double)(device.samplesSent + ii) / opts.odr;
+					double vibration = 60.0 * sin(2 * M_PI * device.vibrationHz * t);
+					int16_t values[4] = {
+						(int16_t)lround(12 + noise(device.rng)),
+						(int16_t)lround(-30 + 0.3 * vibration + noise(device.rng)),
+						(int16_t)lround(1000 + vibration + noise(device.rng)),
+						350
+					};
+					for(uint8_t axis = 0; axis < (opts.storeTemp ? 4 : 3); axis++) {
+						uint16_t entry = ADXL362Sim::makeEntry(axis, values[axis]);
+						*p++ = (uint8_t)(entry & 0xff);
+						*p++ = (uint8_t)(entry >> 8);
+					}
+				}
+				data.startOffset = 0;
+				data.numSamplesRead = count;
+				data.bytesRead = count * data.sampleSizeInBytes;
+
+				device.stream.write(data);
+				if (!sendAll(device.fd, device.out.pending.data(), device.out.pending.size())) {
+					fprintf(stderr, "send failed: %s\n", strerror(errno));
+					failed = true;
+				}
+				bytesSent += device.out.pending.size();
+				device.out.pending.clear();
+				device.samplesSent += count;
+				samplesSent += count;
+			}
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(opts.intervalMs));
+	}
+
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	for(auto &device : devices) {
+		close(device->fd);
+	}
+
+	printf("%u devices, %llu samples in %.1f s (%.0f samples/s), %.1f MB sent\n", opts.devices, (unsigned long long)samplesSent,
+		elapsed, (double)samplesSent / elapsed, (double)bytesSent / 1e6);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,231 @@
+// Replays recorded ADXL362 FIFO captures through the ADXL362DMA driver and analysis code
+//
+// The capture is fed to the simulated ADXL362 (../ADXL362Replay), read by the driver using
+// readFifoAsync() as on the device, and each buffer is run through the analysis code in
+// analyze(). Change analyze() to compare algorithm changes against recorded data.
+//
+// Build:
+// g++ -O2 -std=gnu++17 -I.. -I../../src replay.cpp ../Particle.cpp ../ADXL362Sim.cpp ../ADXL362Replay.cpp ../../src/ADXL362DMA.cpp ../../src/ADXL362Dsp.cpp ../../src/ADXL362VelocityRms.cpp -o replay
+//
+// Run this like:
+// ./replay capture.bin
+// ./replay --mode=simulated --odr=400 --interval-ms=500 capture.bin
+//
+// Modes:
+// - fast: fast-forward, as fast as the driver and analysis can go (default). Use this to measure throughput.
+// - simulated: original timing using the simulated clock, so FIFO overflows happen as they would
+//   on the device if it was drained every --interval-ms, but without waiting.
+// - realtime: original timing using the real clock.
+
+#include "Particle.h"
+#include "ADXL362Replay.h"
+
+#include "ADXL362DMA.h"
+#include "ADXL362Pipeline.h"
+#include "ADXL362VelocityRms.h"
+
+#include <chrono>
+#include <string>
+
+struct Options {
+	std::string path;					//!< Capture file
+	std::string mode = "fast";			//!< fast, simulated, or realtime
+	float odrHz = 400;					//!< Output data rate the capture was recorded at
+	uint8_t rangeG = 2;					//!< Range the capture was recorded at
+	size_t bufferSize = 1020;			//!< Buffer size in bytes passed to readFifoAsync()
+	unsigned long intervalMs = 250;		//!< Time between FIFO drains for simulated and realtime
+	int repeat = 1;						//!< Number of times to replay the capture
+};
+
+// Analysis to run on every buffer
+static ADXL362VelocityRms velocityRms;
+static int64_t sums[3];
+static uint32_t maxVelocityUmPerSec;
+static uint32_t velocityWindows;
+
+static auto pipeline = makeADXL362Pipeline(ADXL362LowPassStage(), [](const ADXL362Sample &sample) {
+	sums[0] += sample.x;
+	sums[1] += sample.y;
+	sums[2] += sample.z;
+});
+
+static void analyze(const ADXL362DataBase &data) {
+	velocityRms.process(data);
+	pipeline.process(data);
+}
+
+static bool parseOption(const std::string &arg, const char *name, std::string &value) {
+	std::string prefix = std::string("--") + name + "=";
+	if (arg.rfind(prefix, 0) != 0) {
+		return false;
+	}
+	value = arg.substr(prefix.size());
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	Options opts;
+
+	for(int ii = 1; ii < argc; ii++) {
+		std::string arg = argv[ii];
+		std::string value;
+
+		if (parseOption(arg, "mode", value)) {
+			opts.mode = value;
+		}
+		else
+		if (parseOption(arg, "odr", value)) {
+			opts.odrHz = (float)atof(value.c_str());
+		}
+		else
+		if (parseOption(arg, "range", value)) {
+			opts.rangeG = (uint8_t)atoi(value.c_str());
+		}
+		else
+		if (parseOption(arg, "buffer-size", value)) {
+			opts.bufferSize = (size_t)atoi(value.c_str());
+		}
+		else
+		if (parseOption(arg, "interval-ms", value)) {
+			opts.intervalMs = (unsigned long)atol(value.c_str());
+		}
+		else
+		if (parseOption(arg, "repeat", value)) {
+			opts.repeat = atoi(value.c_str());
+		}
+		else
+		if (arg.rfind("--", 0) != 0 && opts.path.empty()) {
+			opts.path = arg;
+		}
+		else {
+			opts.path.clear();
+			break;
+		}
+	}
+
+	if (opts.path.empty() || (opts.mode != "fast" && opts.mode != "simulated" && opts.mode != "realtime") ||
+		opts.bufferSize < 8 || opts.bufferSize > 8192) {
+		fprintf(stderr, "usage: %s [--mode=fast|simulated|realtime] [--odr=hz] [--range=2|4|8] [--buffer-size=bytes]\n", argv[0]);
+		fprintf(stderr, "          [--interval-ms=n] [--repeat=n] capture.bin\n");
+		return 1;
+	}
+
+	Log.level = Logger::LEVEL_ERROR;
+
+	static ADXL362Sim sim;
+	static ADXL362Replay replay(sim);
+	SPI.attach(&sim, A2);
+
+	if (opts.mode == "simulated") {
+		HostClock::setSimulated(true);
+		HostClock::addListener([&opts](uint64_t nowMicros) {
+			replay.updateTime(nowMicros, opts.odrHz);
+		});
+	}
+
+	uint8_t odr = ADXL362DMA::ODR_12_5;
+	while(odr < ADXL362DMA::ODR_400 && 12.5 * (1 << odr) < opts.odrHz) {
+		odr++;
+	}
+	uint8_t range = (opts.rangeG >= 8) ? ADXL362DMA::RANGE_8G : ((opts.rangeG >= 4) ? ADXL362DMA::RANGE_4G : ADXL362DMA::RANGE_2G);
+
+	static ADXL362DMA accel(SPI, A2);
+	static ADXL362DataEx<8192> data;
+	data.bufSize = opts.bufferSize;
+
+	uint64_t captureBytes = 0;
+	uint64_t captureSamples = 0;
+	uint64_t samplesDelivered = 0;
+	uint32_t realignCount = 0;
+	double driverSeconds = 0;
+	double analyzeSeconds = 0;
+	auto wallStart = std::chrono::steady_clock::now();
+
+	for(int pass = 0; pass < opts.repeat; pass++) {
+		if (!replay.open(opts.path.c_str())) {
+			return 1;
+		}
+
+		// The driver state (including the partial sample) starts fresh for each pass
+		sim.reset();
+		accel.softReset();
+		accel.writeFilterControl(range, false, false, odr);
+		accel.writeFifoControlAndSamples(511, replay.hasTemperature(), accel.FIFO_STREAM);
+		accel.setMeasureMode(true);
+		if (pass == 0) {
+			velocityRms.begin(accel);
+			velocityRms.setCallback([](const ADXL362VelocityRms::Result &result) {
+				if (result.maxUmPerSec > maxVelocityUmPerSec) {
+					maxVelocityUmPerSec = result.maxUmPerSec;
+				}
+				velocityWindows++;
+			});
+			pipeline.get<0>().begin(opts.odrHz, opts.odrHz / 8);
+		}
+
+		while(true) {
+			if (opts.mode == "fast") {
+				replay.fill();
+			}
+			else {
+				delay(opts.intervalMs);
+				if (opts.mode == "realtime") {
+					replay.updateTime(HostClock::getMicros(), opts.odrHz);
+				}
+			}
+
+			// Drain the FIFO
+			size_t samplesThisDrain = 0;
+			while(true) {
+				auto t0 = std::chrono::steady_clock::now();
+				data.state = ADXL362DMA::STATE_FREE;
+				data.numSamplesRead = 0;
+				accel.readFifoAsync(&data);
+				auto t1 = std::chrono::steady_clock::now();
+				driverSeconds += std::chrono::duration<double>(t1 - t0).count();
+
+				if (data.state != ADXL362DMA::STATE_READ_COMPLETE || data.numSamplesRead == 0) {
+					break;
+				}
+				analyze(data);
+				analyzeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+
+				samplesDelivered += data.numSamplesRead;
+				samplesThisDrain += data.numSamplesRead;
+				if (opts.mode == "fast") {
+					break;
+				}
+			}
+
+			if (replay.isDone() && samplesThisDrain == 0) {
+				break;
+			}
+		}
+
+		captureBytes += replay.getBytesRead();
+		captureSamples += replay.getSamplesAdded();
+		realignCount += accel.getRealignCount();
+	}
+
+	double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+	double captureSeconds = (double)captureSamples / opts.odrHz;
+
+	printf("capture               %s (%s)\n", opts.path.c_str(), replay.hasTemperature() ? "XYZT" : "XYZ");
+	printf("mode                  %s\n", opts.mode.c_str());
+	printf("capture bytes         %llu (%d passes)\n", (unsigned long long)captureBytes, opts.repeat);
+	printf("capture samples       %llu (%.1f s at %.1f Hz)\n", (unsigned long long)captureSamples, captureSeconds, opts.odrHz);
+	printf("samples delivered     %llu (%llu lost)\n", (unsigned long long)samplesDelivered,
+		(unsigned long long)((captureSamples > samplesDelivered) ? captureSamples - samplesDelivered : 0));
+	printf("realigned reads       %lu\n", (unsigned long)realignCount);
+	printf("wall time             %.3f s (%.0fx real time)\n", wallSeconds, captureSeconds / wallSeconds);
+	printf("throughput            %.2f MB/s, %.0f samples/s\n", (double)captureBytes / wallSeconds / 1e6, (double)samplesDelivered / wallSeconds);
+	printf("driver time           %.3f s (%.1f ns/sample)\n", driverSeconds, samplesDelivered ? driverSeconds * 1e9 / (double)samplesDelivered : 0.0);
+	printf("analysis time         %.3f s (%.1f ns/sample)\n", analyzeSeconds, samplesDelivered ? analyzeSeconds * 1e9 / (double)samplesDelivered : 0.0);
+	if (samplesDelivered) {
+		printf("mean x,y,z            %.1f, %.1f, %.1f counts\n", (double)sums[0] / (double)samplesDelivered,
+			(double)sums[1] / (double)samplesDelivered, (double)sums[2] / (double)samplesDelivered);
+	}
+	printf("velocity RMS          max %.2f mm/s over %lu windows\n", (double)maxVelocityUmPerSec / 1000.0, (unsigned long)velocityWindows);
+
+	return 0;
+}
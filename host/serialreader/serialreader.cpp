@@ -0,0 +1,306 @@
+// Reads the binary stream from ADXL362SerialStream and writes CSV or binary files
+//
+// Opens a serial port (or reads a file, or standard input with -), splits the stream into
+// COBS-framed packets, checks the CRC, and writes the samples. Lost packets and samples are
+// detected from the sequence and sample numbers, and reported at the end (or on Ctrl-C). A stream
+// that starts over (the device restarted) is counted as a restart instead.
+//
+// Build (Linux or Mac):
+// g++ -O2 -std=gnu++17 -I.. -I../../src serialreader.cpp ../Particle.cpp ../../src/ADXL362DMA.cpp ../../src/ADXL362SerialStream.cpp ../../src/ADXL362TextFormatter.cpp -o serialreader
+//
+// Run this like:
+// ./serialreader /dev/ttyACM0 --output=capture.csv
+// ./serialreader /dev/ttyACM0 --format=raw --output=capture.bin --seconds=600
+//
+// Formats:
+// - csv: sample,time,x,y,z (and t) with one line per sample (default)
+// - bin: 12 byte little endian records: uint32 sample, int16 x, y, z, t
+// - raw: raw FIFO bytes, the capture format used by host/replay
+
+#include "Particle.h"
+
+#include "ADXL362SerialStream.h"
+#include "ADXL362TextFormatter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void signalHandler(int) {
+	stopRequested = 1;
+}
+
+struct Stats {
+	uint64_t bytes = 0;				//!< Bytes read from the input
+	uint64_t packets = 0;			//!< Valid packets
+	uint64_t badFrames = 0;			//!< Frames with invalid COBS encoding, CRC, or length
+	uint64_t lostPackets = 0;		//!< Packets missing from the sequence
+	uint64_t samples = 0;			//!< Samples written
+	uint64_t lostSamples = 0;		//!< Samples missing from the sample numbers
+	uint64_t restarts = 0;			//!< Times the stream started over (device reset or begin() called again)
+};
+
+class SampleWriter {
+public:
+	SampleWriter(FILE *fp, const std::string &format) : fp(fp), format(format) {
+		formatter.setColumns(ADXL362TextFormatterBase::COLUMN_SAMPLE | ADXL362TextFormatterBase::COLUMN_TIME);
+		formatter.setSeparator(',');
+		formatter.setWidth(0);
+		formatter.setLineEnding("\n");
+	};
+
+	void write(const ADXL362SerialStreamBase::PacketHeader &header, const uint8_t *payload) {
+		bool storeTemp = (header.flags & ADXL362SerialStreamBase::FLAG_TEMP) != 0;
+
+		if (format == "raw" && header.type == ADXL362SerialStreamBase::TYPE_RAW) {
+			fwrite(payload, 1, header.numSamples * (storeTemp ? 8 : 6), fp);
+			return;
+		}
+
+		if (format == "csv" && !headerWritten) {
+			fprintf(fp, storeTemp ? "sample,time,x,y,z,t\n" : "sample,time,x,y,z\n");
+			headerWritten = true;
+		}
+
+		if (format == "csv") {
+			formatter.setColumns(ADXL362TextFormatterBase::COLUMN_SAMPLE | ADXL362TextFormatterBase::COLUMN_TIME,
+				header.rateTenthsHz ? (float)header.rateTenthsHz / 10.0f : 1.0f);
+			formatter.setSampleNumber(header.firstSample);
+		}
+
+		for(size_t ii = 0; ii < header.numSamples; ii++) {
+			ADXL362Sample sample;
+			ADXL362SerialStreamBase::readSample(header, payload, ii, sample);
+			uint32_t sampleNum = header.firstSample + (uint32_t)ii;
+
+			if (format == "csv") {
+				if (!formatter.formatSample(sample, storeTemp)) {
+					flush();
+					formatter.formatSample(sample, storeTemp);
+				}
+			}
+			else
+			if (format == "bin") {
+				uint8_t record[12];
+				int16_t values[4] = { sample.x, sample.y, sample.z, sample.t };
+				for(size_t jj = 0; jj < 4; jj++) {
+					record[jj] = (uint8_t)(sampleNum >> (jj * 8));
+					record[4 + jj * 2] = (uint8_t)((uint16_t)values[jj] & 0xff);
+					record[5 + jj * 2] = (uint8_t)((uint16_t)values[jj] >> 8);
+				}
+				fwrite(record, 1, sizeof(record), fp);
+			}
+			else {
+				// raw from decoded samples: rebuild the FIFO entries
+				int16_t values[4] = { sample.x, sample.y, sample.z, sample.t };
+				for(size_t axis = 0; axis < (storeTemp ? 4u : 3u); axis++) {
+					uint16_t entry = (uint16_t)(axis << 14) | ((uint16_t)values[axis] & 0x3fff);
+					uint8_t bytes[2] = { (uint8_t)(entry & 0xff), (uint8_t)(entry >> 8) };
+					fwrite(bytes, 1, 2, fp);
+				}
+			}
+		}
+	}
+
+	// Write any formatted CSV text
+	void flush() {
+		fwrite(formatter.getText(), 1, formatter.getLength(), fp);
+		formatter.clear();
+	}
+
+protected:
+	FILE *fp;
+	std::string format;
+	bool headerWritten = false;
+	ADXL362TextFormatter<65536> formatter;
+};
+
+static int openInput(const std::string &path) {
+	if (path == "-") {
+		return STDIN_FILENO;
+	}
+
+	int fd = open(path.c_str(), O_RDONLY | O_NOCTTY);
+	if (fd < 0) {
+		fprintf(stderr, "could not open %s: %s\n", path.c_str(), strerror(errno));
+		return -1;
+	}
+
+	if (isatty(fd)) {
+		// Raw mode: no line editing, no translation of CR/LF, no echo
+		struct termios tio;
+		if (tcgetattr(fd, &tio) == 0) {
+			cfmakeraw(&tio);
+			cfsetispeed(&tio, B115200);
+			cfsetospeed(&tio, B115200);
+			tio.c_cc[VMIN] = 1;
+			tio.c_cc[VTIME] = 0;
+			tcsetattr(fd, TCSANOW, &tio);
+			tcflush(fd, TCIFLUSH);
+		}
+	}
+	return fd;
+}
+
+int main(int argc, char *argv[]) {
+	std::string inputPath;
+	std::string outputPath;
+	std::string format = "csv";
+	double maxSeconds = 0;
+
+	for(int ii = 1; ii < argc; ii++) {
+		std::string arg = argv[ii];
+		if (arg.rfind("--format=", 0) == 0) {
+			format = arg.substr(9);
+		}
+		else
+		if (arg.rfind("--output=", 0) == 0) {
+			outputPath = arg.substr(9);
+		}
+		else
+		if (arg.rfind("--seconds=", 0) == 0) {
+			maxSeconds = atof(arg.substr(10).c_str());
+		}
+		else
+		if ((arg == "-" || arg.rfind("--", 0) != 0) && inputPath.empty()) {
+			inputPath = arg;
+		}
+		else {
+			inputPath.clear();
+			break;
+		}
+	}
+	if (inputPath.empty() || (format != "csv" && format != "bin" && format != "raw")) {
+		fprintf(stderr, "usage: %s [--format=csv|bin|raw] [--output=path] [--seconds=n] /dev/ttyACM0|file|-\n", argv[0]);
+		return 1;
+	}
+
+	int fd = openInput(inputPath);
+	if (fd < 0) {
+		return 1;
+	}
+
+	FILE *out = stdout;
+	if (!outputPath.empty()) {
+		out = fopen(outputPath.c_str(), (format == "csv") ? "w" : "wb");
+		if (!out) {
+			fprintf(stderr, "could not create %s: %s\n", outputPath.c_str(), strerror(errno));
+			return 1;
+		}
+	}
+	static char outBuf[1024 * 1024];
+	setvbuf(out, outBuf, _IOFBF, sizeof(outBuf));
+
+	signal(SIGINT, signalHandler);
+	signal(SIGTERM, signalHandler);
+
+	SampleWriter writer(out, format);
+	Stats stats;
+
+	std::vector<uint8_t> frame;
+	frame.reserve(65536);
+	bool discarding = false;
+	bool haveSequence = false;
+	uint16_t nextSequence = 0;
+	uint32_t nextSample = 0;
+
+	auto start = std::chrono::steady_clock::now();
+	uint8_t readBuf[65536];
+
+	while(!stopRequested) {
+		if (maxSeconds > 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= maxSeconds) {
+			break;
+		}
+
+		ssize_t count = read(fd, readBuf, sizeof(readBuf));
+		if (count < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			fprintf(stderr, "read error: %s\n", strerror(errno));
+			break;
+		}
+		if (count == 0) {
+			// End of file
+			break;
+		}
+		stats.bytes += (uint64_t)count;
+
+		for(ssize_t ii = 0; ii < count; ii++) {
+			uint8_t c = readBuf[ii];
+			if (c != 0) {
+				if (frame.size() >= 65536) {
+					// Too long to be a packet; wait for the next delimiter
+					discarding = true;
+					frame.clear();
+				}
+				if (!discarding) {
+					frame.push_back(c);
+				}
+				continue;
+			}
+
+			// End of frame
+			if (discarding || frame.empty()) {
+				discarding = false;
+				frame.clear();
+				continue;
+			}
+
+			size_t len;
+			ADXL362SerialStreamBase::PacketHeader header;
+			const uint8_t *payload;
+			if (!ADXL362SerialStreamBase::cobsDecode(frame.data(), frame.size(), frame.data(), len) ||
+				!ADXL362SerialStreamBase::parsePacket(frame.data(), len, header, payload)) {
+				stats.badFrames++;
+				frame.clear();
+				continue;
+			}
+
+			// A restarted stream begins again at sequence 0 and sample 0, which is not a gap
+			bool restart = haveSequence && ((header.sequence == 0 && header.firstSample == 0) || header.firstSample < nextSample);
+			if (restart) {
+				stats.restarts++;
+			}
+			else
+			if (haveSequence) {
+				stats.lostPackets += (uint16_t)(header.sequence - nextSequence);
+				if (header.firstSample > nextSample) {
+					stats.lostSamples += header.firstSample - nextSample;
+				}
+			}
+			haveSequence = true;
+			nextSequence = header.sequence + 1;
+			nextSample = header.firstSample + header.numSamples;
+
+			writer.write(header, payload);
+			stats.packets++;
+			stats.samples += header.numSamples;
+			frame.clear();
+		}
+	}
+
+	writer.flush();
+	fflush(out);
+	if (out != stdout) {
+		fclose(out);
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	fprintf(stderr, "%.1f s: %llu bytes, %llu packets, %llu samples (%.0f samples/s)\n", seconds,
+		(unsigned long long)stats.bytes, (unsigned long long)stats.packets, (unsigned long long)stats.samples,
+		seconds > 0 ? (double)stats.samples / seconds : 0.0);
+	fprintf(stderr, "bad frames %llu, lost packets %llu, lost samples %llu, restarts %llu\n",
+		(unsigned long long)stats.badFrames, (unsigned long long)stats.lostPackets, (unsigned long long)stats.lostSamples,
+		(unsigned long long)stats.restarts);
+
+	return 0;
+}
@@ -0,0 +1,328 @@
+// Long-duration streaming test for the ADXL362DMA library
+//
+// Streams from the simulated ADXL362 (../ADXL362Sim) using the simulated clock, so days of
+// streaming run in seconds. The application drains the FIFO at a nominal interval with random
+// jitter and occasional long stalls, from a seeded random number generator, so any run can be
+// repeated exactly with the same options.
+//
+// Each sample encodes its sample number and a check value, so every sample that is delivered
+// is checked for gaps (dropped samples) and corruption (axes out of order).
+//
+// Build:
+// g++ -O2 -std=gnu++17 -I.. -I../../src soak.cpp ../Particle.cpp ../ADXL362Sim.cpp ../../src/ADXL362DMA.cpp ../../src/ADXL362PowerModel.cpp ../../src/ADXL362BusRecorder.cpp -o soak
+//
+// Run this like:
+// ./soak --days=3 --seed=42
+// ./soak --days=1 --interval-ms=1200 --jitter-ms=300 --stall-probability=0.001 --stall-ms=5000 --temp
+// ./soak --days=0.01 --bus-trace=bus.txt
+//
+// --bus-trace writes the last SPI bus events (ADXL362BusRecorder) to a file for host/bustrace.
+//
+// The exit code is 1 if any delivered sample was corrupt or out of order, or if the SPI transaction
+// count differs from the ADXL362PowerModel estimate by more than --model-tolerance (0.1 is 10%).
+
+#include "Particle.h"
+#include "ADXL362Sim.h"
+
+#include "ADXL362DMA.h"
+#include "ADXL362PowerModel.h"
+#include "ADXL362BusRecorder.h"
+
+#include <chrono>
+#include <random>
+#include <string>
+
+struct Options {
+	double days = 1.0;					//!< Simulated time to run
+	uint32_t seed = 1;					//!< Random number seed for the drain jitter
+	uint8_t odr = ADXL362DMA::ODR_400;	//!< Output data rate
+	bool storeTemp = false;				//!< Store temperature in the FIFO
+	uint8_t fifoMode = ADXL362DMA::FIFO_STREAM; //!< FIFO_STREAM or FIFO_OLDEST_SAVED
+	size_t bufferSize = 1020;			//!< Buffer size in bytes passed to readFifoAsync()
+	double intervalMs = 250;			//!< Nominal time between FIFO drains
+	double jitterMs = 100;				//!< Drain time varies uniformly by +/- this amount
+	double stallProbability = 0.0005;	//!< Probability that a drain is delayed by a stall
+	double stallMs = 3000;				//!< Maximum stall; the stall time is uniform from 0 to this
+	int32_t odrErrorPpm = 0;			//!< ADXL362 clock error
+	unsigned spiClock = 8 * MHZ;		//!< SPI clock speed
+	std::string busTrace;				//!< File to write the last SPI bus events to
+	double modelTolerance = 0.1;		//!< Allowed difference between the SPI transactions and the ADXL362PowerModel estimate
+};
+
+struct Results {
+	uint64_t samplesDelivered = 0;		//!< Samples returned by readFifoAsync()
+	uint64_t droppedSamples = 0;		//!< Samples missing from the sequence
+	uint64_t gapEvents = 0;				//!< Number of places samples were missing
+	uint64_t corruptSamples = 0;		//!< Samples whose check value was wrong
+	uint64_t outOfOrderSamples = 0;		//!< Samples at or before the previous sample number
+	uint64_t drains = 0;				//!< Application wakes to drain the FIFO
+	uint64_t reads = 0;					//!< readFifoAsync() calls that returned samples
+	uint64_t stalls = 0;				//!< Drains delayed by a stall
+	size_t maxFifoEntries = 0;			//!< Most FIFO entries seen at a drain
+	uint64_t nextIndex = 0;				//!< Expected next sample number
+};
+
+static const uint32_t INDEX_BITS = 24;
+static const uint32_t INDEX_MASK = (1 << INDEX_BITS) - 1;
+
+// X and Y are the low and high 12 bits of the sample number, Z and T are check values
+static void encodeSample(uint32_t index, ADXL362Sample &sample) {
+	uint16_t lo = index & 0xfff;
+	uint16_t hi = (index >> 12) & 0xfff;
+	sample.x = (int16_t)lo - 2048;
+	sample.y = (int16_t)hi - 2048;
+	sample.z = (int16_t)((lo * 7 + hi * 13 + 5) & 0xfff) - 2048;
+	sample.t = (int16_t)(lo ^ 0xa5a) - 2048;
+}
+
+static void checkBuffer(const ADXL362DataBase &data, bool storeTemp, Results &results) {
+	for(const ADXL362Sample &sample : data) {
+		uint16_t lo = (uint16_t)(sample.x + 2048);
+		uint16_t hi = (uint16_t)(sample.y + 2048);
+		int16_t z = (int16_t)((lo * 7 + hi * 13 + 5) & 0xfff) - 2048;
+		int16_t t = (int16_t)(lo ^ 0xa5a) - 2048;
+
+		results.samplesDelivered++;
+
+		if (sample.z != z || (storeTemp && sample.t != t) || lo > 0xfff || hi > 0xfff) {
+			results.corruptSamples++;
+			continue;
+		}
+
+		// The sample number wraps at 24 bits; samples are only ever lost, so the difference is forward
+		uint32_t index24 = (uint32_t)lo | ((uint32_t)hi << 12);
+		uint32_t delta = (index24 - (uint32_t)results.nextIndex) & INDEX_MASK;
+		if (delta > (INDEX_MASK / 2)) {
+			results.outOfOrderSamples++;
+			continue;
+		}
+		if (delta > 0) {
+			results.droppedSamples += delta;
+			results.gapEvents++;
+		}
+		results.nextIndex += delta + 1;
+	}
+}
+
+// Writes to a file, for ADXL362BusRecorder::dump()
+class FilePrint : public Print {
+public:
+	FilePrint(const char *path) : fp(fopen(path, "w")) {};
+	~FilePrint() {
+		if (fp) {
+			fclose(fp);
+		}
+	};
+	bool isOpen() const { return fp != nullptr; };
+
+	size_t write(const uint8_t *buf, size_t size) { return fwrite(buf, 1, size, fp); };
+	using Print::write;
+
+protected:
+	FILE *fp;
+};
+
+static bool parseOption(const std::string &arg, const char *name, std::string &value) {
+	std::string prefix = std::string("--") + name + "=";
+	if (arg.rfind(prefix, 0) != 0) {
+		return false;
+	}
+	value = arg.substr(prefix.size());
+	return true;
+}
+
+static void usage(const char *prog) {
+	fprintf(stderr, "usage: %s [--days=n] [--seed=n] [--odr=12.5|25|50|100|200|400] [--temp] [--mode=stream|oldest]\n", prog);
+	fprintf(stderr, "          [--buffer-size=bytes] [--interval-ms=n] [--jitter-ms=n] [--stall-probability=p] [--stall-ms=n]\n");
+	fprintf(stderr, "          [--odr-error-ppm=n] [--spi-clock=hz] [--bus-trace=path] [--model-tolerance=fraction]\n");
+}
+
+int main(int argc, char *argv[]) {
+	Options opts;
+
+	for(int ii = 1; ii < argc; ii++) {
+		std::string arg = argv[ii];
+		std::string value;
+
+		if (parseOption(arg, "days", value)) {
+			opts.days = atof(value.c_str());
+		}
+		else
+		if (parseOption(arg, "seed", value)) {
+			opts.seed = (uint32_t)strtoul(value.c_str(), nullptr, 0);
+		}
+		else
+		if (parseOption(arg, "odr", value)) {
+			double hz = atof(value.c_str());
+			opts.odr = ADXL362DMA::ODR_12_5;
+			while(opts.odr < ADXL362DMA::ODR_400 && 12.5 * (1 << opts.odr) < hz) {
+				opts.odr++;
+			}
+		}
+		else
+		if (arg == "--temp") {
+			opts.storeTemp = true;
+		}
+		else
+		if (parseOption(arg, "mode", value)) {
+			opts.fifoMode = (value == "oldest") ? ADXL362DMA::FIFO_OLDEST_SAVED : ADXL362DMA::FIFO_STREAM;
+		}
+		else
+		if (parseOption(arg, "buffer-size", value)) {
+			opts.bufferSize = (size_t)atoi(value.c_str());
+		}
+		else
+		if (parseOption(arg, "interval-ms", value)) {
+			opts.intervalMs = atof(value.c_str());
+		}
+		else
+		if (parseOption(arg, "jitter-ms", value)) {
+			opts.jitterMs = atof(value.c_str());
+		}
+		else
+		if (parseOption(arg, "stall-probability", value)) {
+			opts.stallProbability = atof(value.c_str());
+		}
+		else
+		if (parseOption(arg, "stall-ms", value)) {
+			opts.stallMs = atof(value.c_str());
+		}
+		else
+		if (parseOption(arg, "odr-error-ppm", value)) {
+			opts.odrErrorPpm = atoi(value.c_str());
+		}
+		else
+		if (parseOption(arg, "spi-clock", value)) {
+			opts.spiClock = (unsigned)atoi(value.c_str());
+		}
+		else
+		if (parseOption(arg, "bus-trace", value)) {
+			opts.busTrace = value;
+		}
+		else
+		if (parseOption(arg, "model-tolerance", value)) {
+			opts.modelTolerance = atof(value.c_str());
+		}
+		else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (opts.bufferSize < 8 || opts.bufferSize > 8192) {
+		fprintf(stderr, "buffer-size must be 8 to 8192\n");
+		return 1;
+	}
+
+	Log.level = Logger::LEVEL_ERROR;
+
+	static ADXL362Sim sim;
+	sim.setGenerator(encodeSample);
+	sim.setOdrErrorPpm(opts.odrErrorPpm);
+	SPI.attach(&sim, A2);
+
+	HostClock::setSimulated(true);
+	HostClock::addListener([](uint64_t nowMicros) {
+		sim.updateTime(nowMicros);
+	});
+
+	static ADXL362DMA accel(SPI, A2, SPISettings(opts.spiClock, MSBFIRST, SPI_MODE0));
+	static ADXL362DataEx<8192> data;
+	data.bufSize = opts.bufferSize;
+
+	static ADXL362BusRecorder<4096> busRecorder;
+	if (!opts.busTrace.empty()) {
+		accel.setBusRecorder(&busRecorder);
+	}
+
+	accel.softReset();
+	accel.writeFilterControl(accel.RANGE_2G, false, false, opts.odr);
+	accel.writeFifoControlAndSamples(511, opts.storeTemp, opts.fifoMode);
+	accel.setMeasureMode(true);
+	accel.resetTransactionStats();
+
+	std::mt19937 rng(opts.seed);
+	std::uniform_real_distribution<double> jitter(-opts.jitterMs, opts.jitterMs);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+	Results results;
+	uint64_t startMicros = HostClock::getMicros();
+	uint64_t endMicros = startMicros + (uint64_t)(opts.days * 86400.0 * 1000000.0);
+	auto wallStart = std::chrono::steady_clock::now();
+
+	while(HostClock::getMicros() < endMicros) {
+		double sleepMs = opts.intervalMs + jitter(rng);
+		if (unit(rng) < opts.stallProbability) {
+			sleepMs += unit(rng) * opts.stallMs;
+			results.stalls++;
+		}
+		if (sleepMs < 0) {
+			sleepMs = 0;
+		}
+		HostClock::advanceNanos((uint64_t)(sleepMs * 1000000.0));
+
+		results.drains++;
+		if (sim.getNumFifoEntries() > results.maxFifoEntries) {
+			results.maxFifoEntries = sim.getNumFifoEntries();
+		}
+
+		// Drain the FIFO like an application would: read until a read returns no samples
+		while(true) {
+			data.state = ADXL362DMA::STATE_FREE;
+			data.numSamplesRead = 0;
+			accel.readFifoAsync(&data);
+			if (data.state != ADXL362DMA::STATE_READ_COMPLETE || data.numSamplesRead == 0) {
+				break;
+			}
+			results.reads++;
+			checkBuffer(data, opts.storeTemp, results);
+		}
+	}
+
+	double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+	double simSeconds = (double)(HostClock::getMicros() - startMicros) / 1000000.0;
+	uint64_t generated = sim.getSampleIndex();
+	size_t entriesPerSample = opts.storeTemp ? 4 : 3;
+
+	ADXL362PowerModel::Config config;
+	ADXL362PowerModel::fromDriver(accel, config);
+	config.spiClockHz = opts.spiClock;
+	config.pollIntervalMs = (float)opts.intervalMs;
+	config.bufferSize = opts.bufferSize;
+	config.finalEmptyPoll = true;
+	float transactionRatio = ADXL362PowerModel::validate(config, accel, (uint32_t)(simSeconds * 1000.0));
+
+	printf("simulated time        %.1f s (%.2f days)\n", simSeconds, simSeconds / 86400.0);
+	printf("wall time             %.2f s (%.0fx real time)\n", wallSeconds, simSeconds / wallSeconds);
+	printf("seed                  %u\n", opts.seed);
+	printf("samples generated     %llu (%.2f Hz)\n", (unsigned long long)generated, (double)generated / simSeconds);
+	printf("samples delivered     %llu (%.0f samples/s wall)\n", (unsigned long long)results.samplesDelivered, (double)results.samplesDelivered / wallSeconds);
+	printf("samples in FIFO       %llu\n", (unsigned long long)(sim.getNumFifoEntries() / entriesPerSample));
+	printf("dropped samples       %llu in %llu gaps (%.4f%%)\n", (unsigned long long)results.droppedSamples, (unsigned long long)results.gapEvents,
+		generated ? 100.0 * (double)results.droppedSamples / (double)generated : 0.0);
+	printf("FIFO overrun entries  %llu\n", (unsigned long long)sim.getOverrunEntries());
+	printf("realigned reads       %lu\n", (unsigned long)accel.getRealignCount());
+	printf("corrupt samples       %llu\n", (unsigned long long)results.corruptSamples);
+	printf("out of order samples  %llu\n", (unsigned long long)results.outOfOrderSamples);
+	printf("drains                %llu (%llu stalls, max FIFO %u entries)\n", (unsigned long long)results.drains, (unsigned long long)results.stalls, (unsigned)results.maxFifoEntries);
+	printf("FIFO reads            %llu\n", (unsigned long long)results.reads);
+	printf("SPI transactions      %lu (%.2f of ADXL362PowerModel estimate)\n", (unsigned long)accel.getTransactionCount(), transactionRatio);
+
+	bool modelMismatch = fabs(transactionRatio - 1.0) > opts.modelTolerance;
+	if (modelMismatch) {
+		printf("SPI transactions differ from the ADXL362PowerModel estimate by more than %.0f%%\n", opts.modelTolerance * 100.0);
+	}
+
+	if (!opts.busTrace.empty()) {
+		FilePrint out(opts.busTrace.c_str());
+		if (!out.isOpen()) {
+			fprintf(stderr, "could not create %s\n", opts.busTrace.c_str());
+			return 1;
+		}
+		busRecorder.dump(out, opts.spiClock);
+		printf("bus events            %u written to %s\n", (unsigned)busRecorder.getNumEvents(), opts.busTrace.c_str());
+	}
+
+	bool failed = results.corruptSamples > 0 || results.outOfOrderSamples > 0 || modelMismatch;
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,205 @@
+#include "Particle.h"
+
+#include "ADXL362ActivityClassifier.h"
+
+// Activity classification for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+// Helper macros for building model blobs
+#define MODEL_INT32(v) (uint8_t)((v) & 0xff), (uint8_t)(((v) >> 8) & 0xff), (uint8_t)(((v) >> 16) & 0xff), (uint8_t)(((v) >> 24) & 0xff)
+#define MODEL_NODE(feature, left, right, threshold) (uint8_t)(feature), 0, (left), (right), MODEL_INT32(threshold)
+#define MODEL_LEAF(label) 0xff, (uint8_t)(label), 0, 0, MODEL_INT32(0)
+
+// Hand-tuned default model. Thresholds are in counts (mg at RANGE_2G).
+const uint8_t ADXL362ActivityClassifier::defaultModel[] = {
+	MODEL_INT32(MODEL_MAGIC), MODEL_VERSION, NUM_FEATURES, 10, 0,
+	MODEL_NODE(FEATURE_HIGH_BAND_RMS, 1, 4, 15),	// 0: little high frequency vibration?
+	MODEL_NODE(FEATURE_STDDEV, 2, 3, 10),			// 1: little movement at all?
+	MODEL_LEAF(Label::STILL),						// 2
+	MODEL_NODE(FEATURE_LOW_BAND_RMS, 5, 6, 60),		// 3: strong step-frequency component?
+	MODEL_NODE(FEATURE_LOW_BAND_RMS, 7, 6, 60),		// 4: strong step-frequency component with vibration?
+	MODEL_LEAF(Label::VEHICLE),						// 5
+	MODEL_LEAF(Label::WALKING),						// 6
+	MODEL_NODE(FEATURE_CROSSINGS, 9, 8, 600),		// 7: steady periodic vibration?
+	MODEL_LEAF(Label::MACHINE_ON),					// 8
+	MODEL_LEAF(Label::VEHICLE),						// 9
+};
+const size_t ADXL362ActivityClassifier::defaultModelSize = sizeof(ADXL362ActivityClassifier::defaultModel);
+
+static int32_t readModelInt32(const uint8_t *p) {
+	return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+
+ADXL362ActivityClassifier::ADXL362ActivityClassifier() {
+	setModel(defaultModel, defaultModelSize);
+}
+
+ADXL362ActivityClassifier::~ADXL362ActivityClassifier() {
+}
+
+void ADXL362ActivityClassifier::begin(float sampleRate, uint16_t windowSamples) {
+	this->windowSamples = (windowSamples > 0) ? windowSamples : 1;
+	sampleRateX16 = (uint32_t)(sampleRate * 16.0);
+
+	lowBand.setBandPass(sampleRate, 2.0, 0.7);
+
+	// Keep the high-pass cutoff below Nyquist at low output data rates
+	float highCutoff = 10.0;
+	if (highCutoff > sampleRate * 0.3) {
+		highCutoff = sampleRate * 0.3;
+	}
+	highBand.setHighPass(sampleRate, highCutoff);
+
+	count = 0;
+	sum = sumSq = lowBandSumSq = highBandSumSq = 0;
+	crossings = 0;
+	prevMean = 0;
+	windowIndex = 0;
+	lastLabel = Label::UNKNOWN;
+}
+
+bool ADXL362ActivityClassifier::setModel(const uint8_t *blob, size_t len) {
+	if (blob == nullptr || len < MODEL_HEADER_SIZE) {
+		return false;
+	}
+	if ((uint32_t)readModelInt32(blob) != MODEL_MAGIC || blob[4] != MODEL_VERSION || blob[5] > NUM_FEATURES) {
+		return false;
+	}
+	uint16_t nodes = blob[6] | (blob[7] << 8);
+	if (nodes == 0 || len < MODEL_HEADER_SIZE + nodes * MODEL_NODE_SIZE) {
+		return false;
+	}
+
+	// Validate the nodes so classify() does not need bounds checks
+	for(uint16_t ii = 0; ii < nodes; ii++) {
+		const uint8_t *node = &blob[MODEL_HEADER_SIZE + ii * MODEL_NODE_SIZE];
+		int8_t feature = (int8_t)node[0];
+		if (feature >= 0) {
+			if ((size_t)feature >= blob[5] || node[2] >= nodes || node[3] >= nodes || node[2] <= ii || node[3] <= ii) {
+				// Children must come after the parent, which also prevents loops
+				return false;
+			}
+		}
+	}
+
+	model = blob;
+	numNodes = nodes;
+	return true;
+}
+
+void ADXL362ActivityClassifier::process(const ADXL362DataBase &data) {
+	ADXL362Sample sample;
+
+	for(size_t ii = 0; ii < data.numSamplesRead; ii++) {
+		data.readSample(ii, sample);
+		processSample(sample.x, sample.y, sample.z);
+	}
+}
+
+void ADXL362ActivityClassifier::processSample(int16_t x, int16_t y, int16_t z) {
+	int32_t mag = ADXL362Dsp::isqrt(ADXL362Dsp::magnitudeSq(x, y, z));
+
+	if (count == 0) {
+		minMag = maxMag = mag;
+		if (windowIndex == 0) {
+			prevMean = mag;
+			lowBand.prime(mag << INPUT_SHIFT);
+			highBand.prime(mag << INPUT_SHIFT);
+		}
+		prevAbove = (mag > prevMean);
+	}
+	if (mag < minMag) {
+		minMag = mag;
+	}
+	if (mag > maxMag) {
+		maxMag = mag;
+	}
+	sum += mag;
+	sumSq += mag * mag;
+
+	bool above = (mag > prevMean);
+	if (above != prevAbove) {
+		crossings++;
+		prevAbove = above;
+	}
+
+	int32_t low = lowBand.process(mag << INPUT_SHIFT);
+	lowBandSumSq += (int64_t)low * low;
+
+	int32_t high = highBand.process(mag << INPUT_SHIFT);
+	highBandSumSq += (int64_t)high * high;
+
+	if (++count >= windowSamples) {
+		endWindow();
+	}
+}
+
+void ADXL362ActivityClassifier::endWindow() {
+	Result result;
+
+	int32_t mean = (int32_t)(sum / count);
+
+	// Computed this way to avoid losing the fractional part of the mean
+	int64_t variance = (sumSq * count - sum * sum) / ((int64_t)count * count);
+	if (variance < 0) {
+		variance = 0;
+	}
+
+	result.features[FEATURE_MEAN] = mean;
+	result.features[FEATURE_STDDEV] = ADXL362Dsp::isqrt((uint32_t)((variance > 0xffffffffLL) ? 0xffffffffLL : variance));
+	result.features[FEATURE_PEAK_TO_PEAK] = maxMag - minMag;
+	result.features[FEATURE_CROSSINGS] = (int32_t)(((uint64_t)crossings * 10 * sampleRateX16) / ((uint64_t)count * 16));
+	result.features[FEATURE_LOW_BAND_RMS] = ADXL362Dsp::isqrt((uint32_t)((lowBandSumSq / count) >> (2 * INPUT_SHIFT)));
+	result.features[FEATURE_HIGH_BAND_RMS] = ADXL362Dsp::isqrt((uint32_t)((highBandSumSq / count) >> (2 * INPUT_SHIFT)));
+
+	result.label = classify(result.features);
+	result.windowIndex = windowIndex++;
+	lastLabel = result.label;
+
+	prevMean = mean;
+	count = 0;
+	sum = sumSq = lowBandSumSq = highBandSumSq = 0;
+	crossings = 0;
+
+	if (callback) {
+		callback(result);
+	}
+}
+
+ADXL362ActivityClassifier::Label ADXL362ActivityClassifier::classify(const int32_t *features) const {
+	uint16_t index = 0;
+
+	while(index < numNodes) {
+		const uint8_t *node = &model[MODEL_HEADER_SIZE + index * MODEL_NODE_SIZE];
+		int8_t feature = (int8_t)node[0];
+		if (feature < 0) {
+			if (node[1] > (uint8_t)Label::MACHINE_ON) {
+				return Label::UNKNOWN;
+			}
+			return (Label)node[1];
+		}
+		index = (features[feature] < readModelInt32(&node[4])) ? node[2] : node[3];
+	}
+	return Label::UNKNOWN;
+}
+
+// [static]
+const char *ADXL362ActivityClassifier::labelName(Label label) {
+	switch(label) {
+		case Label::STILL:
+			return "still";
+
+		case Label::WALKING:
+			return "walking";
+
+		case Label::VEHICLE:
+			return "vehicle";
+
+		case Label::MACHINE_ON:
+			return "machine on";
+
+		default:
+			return "unknown";
+	}
+}
@@ -0,0 +1,176 @@
+#ifndef __ADXL362ACTIVITYCLASSIFIER_H
+#define __ADXL362ACTIVITYCLASSIFIER_H
+
+// Activity classification for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+#include "ADXL362Dsp.h"
+
+#include <functional>
+
+/**
+ * @brief On-device activity classifier (still, walking, vehicle, machine on)
+ *
+ * Features are accumulated one sample at a time over a window, so no samples are buffered and
+ * windows can span FIFO buffers. At the end of each window the features are passed through a
+ * fixed-point decision tree, and the callback receives one label per window instead of the raw
+ * samples.
+ *
+ * Features (all integers, in counts of the sample magnitude; 1 count is 1 mg at RANGE_2G):
+ *
+ * - FEATURE_MEAN: Mean magnitude
+ * - FEATURE_STDDEV: Standard deviation of the magnitude
+ * - FEATURE_PEAK_TO_PEAK: Maximum minus minimum magnitude
+ * - FEATURE_CROSSINGS: Number of times the magnitude crosses the mean of the previous window, per 10 seconds
+ * - FEATURE_LOW_BAND_RMS: RMS of the magnitude band-pass filtered around 2 Hz (walking)
+ * - FEATURE_HIGH_BAND_RMS: RMS of the magnitude high-pass filtered at 10 Hz (machinery, road vibration)
+ *
+ * The model is a constant blob, typically in flash, so it can be replaced by a trained model
+ * without changing code. The blob format (little endian) is:
+ *
+ * - 4 bytes: MODEL_MAGIC
+ * - 1 byte: MODEL_VERSION
+ * - 1 byte: number of features used (must be <= NUM_FEATURES)
+ * - 2 bytes: number of nodes
+ * - 8 bytes per node: feature (int8, -1 for a leaf), label (uint8, for leaves), left node index (uint8),
+ *   right node index (uint8), threshold (int32). Node 0 is the root. If the feature value is less than
+ *   the threshold, evaluation continues at left, otherwise at right.
+ *
+ * A small hand-tuned default model is used if setModel() is not called. It is a reasonable starting
+ * point but should be replaced by a model trained on data from your hardware and mounting.
+ */
+class ADXL362ActivityClassifier {
+public:
+	/**
+	 * @brief Activity labels
+	 */
+	enum class Label : uint8_t {
+		UNKNOWN = 0,		//!< Model did not produce a valid label
+		STILL,				//!< Not moving
+		WALKING,			//!< Walking or running
+		VEHICLE,			//!< In a moving vehicle
+		MACHINE_ON			//!< Attached to running machinery
+	};
+
+	/**
+	 * @brief Result passed to the callback at the end of each window
+	 */
+	struct Result {
+		Label label;						//!< Classification
+		uint32_t windowIndex;				//!< Window number since begin()
+		int32_t features[6];				//!< Feature values, indexed by FEATURE_ constants
+	};
+
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362ActivityClassifier();
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362ActivityClassifier();
+
+	/**
+	 * @brief Configure the filters and window size. Must be called before process().
+	 *
+	 * @param sampleRate The output data rate in Hz. See ADXL362DMA::getOutputDataRate().
+	 *
+	 * @param windowSamples The number of samples in each window (default: 128)
+	 */
+	void begin(float sampleRate, uint16_t windowSamples = 128);
+
+	/**
+	 * @brief Use a model blob instead of the default model
+	 *
+	 * @param blob Pointer to the model. It is not copied and must remain valid, typically a const array in flash.
+	 *
+	 * @param len Length of the blob in bytes
+	 *
+	 * @return true if the blob is valid, false if not (the previous model continues to be used)
+	 */
+	bool setModel(const uint8_t *blob, size_t len);
+
+	/**
+	 * @brief Set the function to call at the end of each window
+	 */
+	void setCallback(std::function<void(const Result &result)> callback) { this->callback = callback; };
+
+	/**
+	 * @brief Process all of the samples in a completed FIFO buffer
+	 *
+	 * @param data A buffer in STATE_READ_COMPLETE state
+	 */
+	void process(const ADXL362DataBase &data);
+
+	/**
+	 * @brief Process a single sample
+	 */
+	void processSample(int16_t x, int16_t y, int16_t z);
+
+	/**
+	 * @brief Returns the label of the most recent complete window
+	 */
+	Label getLabel() const { return lastLabel; };
+
+	/**
+	 * @brief Returns a readable name for a label
+	 */
+	static const char *labelName(Label label);
+
+	/**
+	 * @brief Evaluate the decision tree for a set of features
+	 *
+	 * @param features NUM_FEATURES feature values
+	 */
+	Label classify(const int32_t *features) const;
+
+	static const size_t NUM_FEATURES = 6;			//!< Number of features
+	static const size_t FEATURE_MEAN = 0;			//!< Mean magnitude
+	static const size_t FEATURE_STDDEV = 1;			//!< Standard deviation of magnitude
+	static const size_t FEATURE_PEAK_TO_PEAK = 2;	//!< Peak-to-peak magnitude
+	static const size_t FEATURE_CROSSINGS = 3;		//!< Mean crossings per 10 seconds
+	static const size_t FEATURE_LOW_BAND_RMS = 4;	//!< RMS around 2 Hz
+	static const size_t FEATURE_HIGH_BAND_RMS = 5;	//!< RMS above 10 Hz
+
+	static const uint32_t MODEL_MAGIC = 0x54445841;	//!< "AXDT" in little endian
+	static const uint8_t MODEL_VERSION = 1;			//!< Model blob version
+	static const size_t MODEL_HEADER_SIZE = 8;		//!< Bytes before the first node
+	static const size_t MODEL_NODE_SIZE = 8;		//!< Bytes per node
+
+	static const uint8_t defaultModel[];			//!< Default hand-tuned model blob
+	static const size_t defaultModelSize;			//!< Size of defaultModel in bytes
+
+protected:
+	/**
+	 * @brief Calculate the features and classify at the end of a window
+	 */
+	void endWindow();
+
+	static const int INPUT_SHIFT = 4; //!< Magnitude is scaled by 2^INPUT_SHIFT for the filters
+
+	ADXL362Biquad lowBand; //!< Walking band filter
+	ADXL362Biquad highBand; //!< High frequency filter
+	uint16_t windowSamples = 128; //!< Samples per window
+	uint32_t sampleRateX16 = 0; //!< Sample rate * 16
+	const uint8_t *model; //!< Model blob
+	uint16_t numNodes = 0; //!< Nodes in model
+	std::function<void(const Result &result)> callback = nullptr; //!< Callback function
+
+	uint16_t count = 0; //!< Samples in the current window
+	int64_t sum = 0; //!< Sum of magnitudes
+	int64_t sumSq = 0; //!< Sum of squared magnitudes
+	int32_t minMag = 0; //!< Minimum magnitude
+	int32_t maxMag = 0; //!< Maximum magnitude
+	int32_t prevMean = 0; //!< Mean of the previous window, for crossings
+	bool prevAbove = false; //!< Previous sample was above prevMean
+	uint16_t crossings = 0; //!< Crossings in the current window
+	int64_t lowBandSumSq = 0; //!< Sum of squared low band output
+	int64_t highBandSumSq = 0; //!< Sum of squared high band output
+	uint32_t windowIndex = 0; //!< Windows completed
+	Label lastLabel = Label::UNKNOWN; //!< Label from the last window
+};
+
+#endif /* __ADXL362ACTIVITYCLASSIFIER_H */
@@ -0,0 +1,176 @@
+#include "Particle.h"
+
+#include "ADXL362AnomalyGate.h"
+#include "ADXL362Dsp.h"
+
+#include <math.h>
+
+// Anomaly gating of FIFO buffers for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+static_assert(sizeof(ADXL362AnomalyGateBase::Summary) == 16, "Summary must be 16 bytes");
+static_assert(sizeof(ADXL362AnomalyGateBase::RecordHeader) == 4, "RecordHeader must be 4 bytes");
+
+ADXL362AnomalyGateBase::ADXL362AnomalyGateBase(Decision *pending, size_t pendingSize) : pending(pending), pendingSize(pendingSize) {
+}
+
+ADXL362AnomalyGateBase::~ADXL362AnomalyGateBase() {
+}
+
+void ADXL362AnomalyGateBase::begin(uint8_t rangeG, uint16_t contextBefore, uint16_t contextAfter) {
+	mgPerCount = (float)ADXL362Dsp::mgPerCount(rangeG);
+	this->contextBefore = (contextBefore < pendingSize) ? contextBefore : (uint16_t)(pendingSize - 1);
+	this->contextAfter = contextAfter;
+
+	baseline = 0;
+	deviation = 0;
+	addCount = takeCount = 0;
+	afterRemaining = 0;
+	forwardedCount = summarizedCount = 0;
+}
+
+bool ADXL362AnomalyGateBase::add(const ADXL362DataBase &data) {
+	if ((addCount - takeCount) >= pendingSize) {
+		return false;
+	}
+
+	Decision &decision = pending[addCount % pendingSize];
+	memset(&decision, 0, sizeof(decision));
+
+	Summary &summary = decision.summary;
+	summary.sequence = addCount;
+
+	float rmsMg;
+	measure(data, summary, rmsMg);
+
+	if (addCount < warmupWindows) {
+		// Learn the baseline. The first window initializes it.
+		if (addCount == 0) {
+			baseline = rmsMg;
+		}
+		else {
+			float w = 1.0 / (float)(addCount + 1);
+			deviation += w * (fabsf(rmsMg - baseline) - deviation);
+			baseline += w * (rmsMg - baseline);
+		}
+		summary.flags |= FLAG_WARMUP;
+	}
+	else {
+		float diff = fabsf(rmsMg - baseline);
+		float dev = (deviation > minDeviationMg) ? deviation : minDeviationMg;
+		float score = diff / dev;
+
+		float scaled = score * 256.0;
+		summary.score = (scaled > 65535.0) ? 65535 : (uint16_t)scaled;
+
+		bool anomaly = (score > threshold);
+
+		// Anomalies move the baseline slowly so they don't hide the anomalies that follow
+		float w = anomaly ? (alpha / 8.0) : alpha;
+		deviation += w * (diff - deviation);
+		baseline += w * (rmsMg - baseline);
+
+		if (anomaly) {
+			summary.flags |= FLAG_ANOMALY;
+			decision.forward = true;
+
+			// Mark the windows before this one that are still pending
+			uint32_t first = (addCount - takeCount > contextBefore) ? (addCount - contextBefore) : takeCount;
+			for(uint32_t seq = first; seq < addCount; seq++) {
+				Decision &prev = pending[seq % pendingSize];
+				if (!prev.forward) {
+					prev.forward = true;
+					prev.summary.flags |= FLAG_CONTEXT;
+				}
+			}
+			afterRemaining = contextAfter;
+		}
+		else
+		if (afterRemaining > 0) {
+			afterRemaining--;
+			decision.forward = true;
+			summary.flags |= FLAG_CONTEXT;
+		}
+	}
+	summary.baselineMg = (uint16_t)((baseline < 65535.0) ? baseline : 65535.0);
+
+	addCount++;
+	return true;
+}
+
+bool ADXL362AnomalyGateBase::nextDecision(Decision &decision, bool flush) {
+	if (addCount == takeCount) {
+		return false;
+	}
+
+	Decision &oldest = pending[takeCount % pendingSize];
+
+	// A window that's already being forwarded can't change. Otherwise wait until enough windows
+	// follow it that it can no longer be context for an anomaly.
+	if (!flush && !oldest.forward && (addCount - takeCount) <= contextBefore) {
+		return false;
+	}
+
+	decision = oldest;
+	takeCount++;
+
+	if (decision.forward) {
+		forwardedCount++;
+	}
+	else {
+		summarizedCount++;
+	}
+	return true;
+}
+
+void ADXL362AnomalyGateBase::measure(const ADXL362DataBase &data, Summary &summary, float &rmsMg) {
+	int32_t sum[3] = { 0, 0, 0 };
+	int64_t sumSq[3] = { 0, 0, 0 };
+	int16_t minValue[3] = { INT16_MAX, INT16_MAX, INT16_MAX };
+	int16_t maxValue[3] = { INT16_MIN, INT16_MIN, INT16_MIN };
+
+	ADXL362Sample sample;
+	size_t n = data.numSamplesRead;
+
+	for(size_t ii = 0; ii < n; ii++) {
+		data.readSample(ii, sample);
+
+		int16_t values[3] = { sample.x, sample.y, sample.z };
+		for(size_t axis = 0; axis < 3; axis++) {
+			int16_t v = values[axis];
+			sum[axis] += v;
+			sumSq[axis] += (int32_t)v * v;
+			if (v < minValue[axis]) {
+				minValue[axis] = v;
+			}
+			if (v > maxValue[axis]) {
+				maxValue[axis] = v;
+			}
+		}
+	}
+
+	summary.numSamples = (uint16_t)n;
+	if (n == 0) {
+		rmsMg = 0;
+		return;
+	}
+
+	// Variance * n^2 = n * sumSq - sum^2, which avoids truncating the mean
+	uint64_t varianceN2 = 0;
+	int32_t p2p = 0;
+	for(size_t axis = 0; axis < 3; axis++) {
+		int64_t v = (int64_t)n * sumSq[axis] - (int64_t)sum[axis] * sum[axis];
+		if (v > 0) {
+			varianceN2 += (uint64_t)v;
+		}
+		if (maxValue[axis] - minValue[axis] > p2p) {
+			p2p = maxValue[axis] - minValue[axis];
+		}
+	}
+
+	rmsMg = (float)ADXL362Dsp::isqrt64(varianceN2) / (float)n * mgPerCount;
+
+	summary.rmsMg = (uint16_t)((rmsMg < 65535.0) ? rmsMg : 65535.0);
+	float p2pMg = (float)p2p * mgPerCount;
+	summary.p2pMg = (uint16_t)((p2pMg < 65535.0) ? p2pMg : 65535.0);
+}
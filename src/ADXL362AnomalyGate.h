@@ -0,0 +1,218 @@
+#ifndef __ADXL362ANOMALYGATE_H
+#define __ADXL362ANOMALYGATE_H
+
+// Anomaly gating of FIFO buffers for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+
+/**
+ * @brief Decides which FIFO buffers are worth sending raw, and which only need a summary
+ *
+ * The gate sits between the ring of FIFO buffers and the code that sends them. Each completed
+ * buffer is one window. For each window it calculates the vector AC RMS (the square root of the
+ * sum of the per-axis variances, so it does not depend on orientation) and compares it to a
+ * running baseline:
+ *
+ * score = |rms - baseline| / deviation
+ *
+ * where baseline and deviation are exponentially weighted moving averages of the RMS and of the
+ * absolute difference from the baseline. A window is anomalous when the score exceeds the
+ * threshold. Anomalous windows, plus a configurable number of windows before and after, are
+ * forwarded raw. All other windows are reduced to a 16-byte Summary.
+ *
+ * The per-sample work is integer sums; the floating point baseline is updated once per window.
+ *
+ * Decisions lag the windows by the number of context windows before the anomaly, because a window
+ * can't be summarized until it's known that no anomaly follows it closely. The buffers stay in your
+ * ring (in STATE_READ_COMPLETE) until nextDecision() returns them.
+ *
+ * You will not allocate one of these directly; use ADXL362AnomalyGate, which allocates the storage.
+ */
+class ADXL362AnomalyGateBase {
+public:
+	/**
+	 * @brief Compact record describing one window, sent instead of the raw data for quiet windows
+	 *
+	 * This is sent as-is over the network, so the layout is fixed (little endian, 16 bytes).
+	 */
+	struct Summary {
+		uint32_t sequence;		//!< Window number since begin()
+		uint16_t numSamples;	//!< Samples in the window
+		uint16_t rmsMg;			//!< Vector AC RMS in mg
+		uint16_t p2pMg;			//!< Largest per-axis peak-to-peak in mg
+		uint16_t baselineMg;	//!< Baseline RMS in mg at the time of the window
+		uint16_t score;			//!< Anomaly score * 256, saturated at 65535
+		uint8_t flags;			//!< FLAG_ANOMALY, FLAG_CONTEXT, FLAG_WARMUP
+		uint8_t reserved;		//!< Always 0
+	} __attribute__((packed));
+
+	/**
+	 * @brief A window that has been decided, returned by nextDecision()
+	 */
+	struct Decision {
+		Summary summary;		//!< Summary of the window
+		bool forward;			//!< true to send the raw buffer, false to send only the summary
+	};
+
+	/**
+	 * @brief Header that precedes each record in the example wire format
+	 *
+	 * A RECORD_SUMMARY is the header followed by a Summary. A RECORD_RAW is the header followed by
+	 * a Summary and then the raw FIFO bytes. length is the number of bytes after the header.
+	 */
+	struct RecordHeader {
+		uint8_t type;			//!< RECORD_SUMMARY or RECORD_RAW
+		uint8_t reserved;		//!< Always 0
+		uint16_t length;		//!< Bytes following the header
+	} __attribute__((packed));
+
+	/**
+	 * @brief Constructor - You will not allocate one of these directly
+	 *
+	 * @param pending Storage for windows waiting for a decision
+	 *
+	 * @param pendingSize Number of entries in pending
+	 */
+	ADXL362AnomalyGateBase(Decision *pending, size_t pendingSize);
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362AnomalyGateBase();
+
+	/**
+	 * @brief Set the range and reset the baseline. Must be called before add().
+	 *
+	 * @param rangeG The range (2, 4, or 8), see ADXL362DMA::getRangeG()
+	 *
+	 * @param contextBefore Number of windows before an anomaly to forward raw. Limited to the
+	 * template parameter of ADXL362AnomalyGate.
+	 *
+	 * @param contextAfter Number of windows after an anomaly to forward raw
+	 */
+	void begin(uint8_t rangeG, uint16_t contextBefore = 1, uint16_t contextAfter = 2);
+
+	/**
+	 * @brief Set the score threshold (default: 4.0)
+	 */
+	void setThreshold(float threshold) { this->threshold = threshold; };
+
+	/**
+	 * @brief Set the baseline weight for each normal window (default: 0.05)
+	 *
+	 * Anomalous windows are weighted by 1/8 of this, so a lasting change in the operating point
+	 * is eventually accepted as the new baseline.
+	 */
+	void setBaselineAlpha(float alpha) { this->alpha = alpha; };
+
+	/**
+	 * @brief Set the number of windows used to learn the baseline after begin() (default: 20)
+	 *
+	 * Warmup windows are never anomalous.
+	 */
+	void setWarmupWindows(uint16_t windows) { warmupWindows = windows; };
+
+	/**
+	 * @brief Set the minimum deviation in mg (default: 2)
+	 *
+	 * This keeps a very steady signal from making the score too sensitive.
+	 */
+	void setMinDeviationMg(float mg) { minDeviationMg = mg; };
+
+	/**
+	 * @brief Score a completed buffer. Call for each buffer in the order they were read.
+	 *
+	 * @param data A buffer in STATE_READ_COMPLETE state. Leave it in your ring until nextDecision()
+	 * returns its sequence number.
+	 *
+	 * @return false if there are too many windows waiting for a decision; call nextDecision() first.
+	 */
+	bool add(const ADXL362DataBase &data);
+
+	/**
+	 * @brief Get the decision for the oldest window added
+	 *
+	 * @param decision Filled in with the decision
+	 *
+	 * @param flush Return the oldest window even if an anomaly in a later window could still require
+	 * it as context, for example before sleep.
+	 *
+	 * @return true if a decision was returned, false if no window is ready yet
+	 */
+	bool nextDecision(Decision &decision, bool flush = false);
+
+	/**
+	 * @brief Number of windows added but not yet returned by nextDecision()
+	 */
+	size_t getNumPending() const { return (size_t)(addCount - takeCount); };
+
+	/**
+	 * @brief Current baseline RMS in mg
+	 */
+	float getBaselineMg() const { return baseline; };
+
+	/**
+	 * @brief Number of windows returned with forward set
+	 */
+	uint32_t getForwardedCount() const { return forwardedCount; };
+
+	/**
+	 * @brief Number of windows returned as summaries only
+	 */
+	uint32_t getSummarizedCount() const { return summarizedCount; };
+
+	static const uint8_t FLAG_ANOMALY = 0x01; //!< Score exceeded the threshold
+	static const uint8_t FLAG_CONTEXT = 0x02; //!< Forwarded as context around an anomaly
+	static const uint8_t FLAG_WARMUP = 0x04; //!< Baseline was still being learned
+
+	static const uint8_t RECORD_SUMMARY = 1; //!< RecordHeader type for a summary only
+	static const uint8_t RECORD_RAW = 2; //!< RecordHeader type for a summary and raw FIFO bytes
+
+protected:
+	/**
+	 * @brief Calculate the RMS and peak-to-peak of a window
+	 */
+	void measure(const ADXL362DataBase &data, Summary &summary, float &rmsMg);
+
+	Decision *pending; //!< Windows waiting for a decision
+	size_t pendingSize; //!< Number of entries in pending
+	float mgPerCount = 1.0; //!< Scale from the range
+	uint16_t contextBefore = 1; //!< Windows before an anomaly to forward
+	uint16_t contextAfter = 2; //!< Windows after an anomaly to forward
+	float threshold = 4.0; //!< Score threshold
+	float alpha = 0.05; //!< Baseline weight
+	uint16_t warmupWindows = 20; //!< Windows before anomalies are reported
+	float minDeviationMg = 2.0; //!< Floor for the deviation
+
+	float baseline = 0; //!< EWMA of the RMS in mg
+	float deviation = 0; //!< EWMA of |rms - baseline| in mg
+	uint32_t addCount = 0; //!< Windows added
+	uint32_t takeCount = 0; //!< Windows returned by nextDecision()
+	uint16_t afterRemaining = 0; //!< Windows still to forward after the last anomaly
+	uint32_t forwardedCount = 0; //!< Windows forwarded raw
+	uint32_t summarizedCount = 0; //!< Windows summarized
+};
+
+/**
+ * @brief Anomaly gate
+ *
+ * @param MAX_CONTEXT_BEFORE The largest contextBefore that will be passed to begin(). Each window
+ * waiting for a decision takes 20 bytes.
+ */
+template <uint16_t MAX_CONTEXT_BEFORE>
+class ADXL362AnomalyGate : public ADXL362AnomalyGateBase {
+public:
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362AnomalyGate() : ADXL362AnomalyGateBase(staticPending, MAX_CONTEXT_BEFORE + 1) {};
+
+	/**
+	 * @brief Storage for windows waiting for a decision
+	 */
+	Decision staticPending[MAX_CONTEXT_BEFORE + 1];
+};
+
+#endif /* __ADXL362ANOMALYGATE_H */
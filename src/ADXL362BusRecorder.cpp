@@ -0,0 +1,50 @@
+#include "Particle.h"
+
+#include "ADXL362BusRecorder.h"
+
+// SPI bus transaction recorder for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+static_assert(sizeof(ADXL362BusRecorderBase::Event) == 12, "Event must be 12 bytes");
+
+ADXL362BusRecorderBase::ADXL362BusRecorderBase(Event *events, size_t numEvents) : events(events), numEvents(numEvents), writeCount(0) {
+}
+
+ADXL362BusRecorderBase::~ADXL362BusRecorderBase() {
+}
+
+void ADXL362BusRecorderBase::clear() {
+	writeCount = 0;
+}
+
+size_t ADXL362BusRecorderBase::getNumEvents() const {
+	uint32_t count = writeCount;
+	return (count < numEvents) ? count : numEvents;
+}
+
+uint32_t ADXL362BusRecorderBase::getOverwrittenCount() const {
+	uint32_t count = writeCount;
+	return (count > numEvents) ? count - numEvents : 0;
+}
+
+bool ADXL362BusRecorderBase::getEvent(size_t index, Event &event) const {
+	uint32_t count = writeCount;
+	size_t num = (count < numEvents) ? count : numEvents;
+	if (index >= num) {
+		return false;
+	}
+	event = events[(count - num + index) % numEvents];
+	return true;
+}
+
+void ADXL362BusRecorderBase::dump(Print &out, uint32_t spiClockHz) const {
+	size_t num = getNumEvents();
+
+	out.printlnf("adxl362bus,dump,%u,%lu,%lu", (unsigned)num, (unsigned long)getOverwrittenCount(), (unsigned long)spiClockHz);
+	for(size_t ii = 0; ii < num; ii++) {
+		Event event;
+		if (getEvent(ii, event)) {
+			out.printlnf("adxl362bus,%lu,%u,%u,%u,%u,%u", (unsigned long)event.micros, event.context, event.type, event.cmd, event.reg, event.len);
+		}
+	}
+}
@@ -0,0 +1,162 @@
+#ifndef __ADXL362BUSRECORDER_H
+#define __ADXL362BUSRECORDER_H
+
+// SPI bus transaction recorder for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+
+#include <atomic>
+
+/**
+ * @brief Records timestamped SPI bus events from one or more ADXL362DMA objects into a ring buffer
+ *
+ * Attach it with ADXL362DMA::setBusRecorder(). Each transaction records an EVENT_BEGIN when the
+ * driver starts it, EVENT_SELECT when it has the SPI bus and CS is low, EVENT_DMA_START when a
+ * FIFO read starts the DMA transfer, and EVENT_END when CS goes high again. The time from begin to
+ * select is time spent waiting for the SPI bus, for example for another device on the same bus.
+ *
+ * Each event is 12 bytes. When the ring is full the oldest events are overwritten. Recording is
+ * safe from the DMA completion interrupt, and costs one micros() call and a few stores per event.
+ * Without a recorder attached, the driver only tests a null pointer.
+ *
+ * dump() writes the events as text lines starting with "adxl362bus,", which can be captured from
+ * the USB serial port along with other output. The host/bustrace tool converts them into a Chrome
+ * trace (Perfetto) JSON timeline and summarizes where the bus time goes.
+ *
+ * You will not allocate one of these directly; use ADXL362BusRecorder, which allocates the storage.
+ */
+class ADXL362BusRecorderBase {
+public:
+	/**
+	 * @brief One bus event
+	 */
+	struct Event {
+		uint32_t micros;	//!< micros() when the event occurred
+		uint16_t len;		//!< Bytes in the transaction, including the command (EVENT_BEGIN only)
+		uint8_t type;		//!< EVENT_BEGIN, EVENT_SELECT, EVENT_DMA_START, or EVENT_END
+		uint8_t context;	//!< Context passed to setBusRecorder(), to tell devices apart
+		uint8_t cmd;		//!< Command byte, such as CMD_READ_REGISTER (EVENT_BEGIN only)
+		uint8_t reg;		//!< Register address for register commands (EVENT_BEGIN only)
+		uint8_t reserved[2];	//!< Always 0
+	};
+
+	/**
+	 * @brief Constructor - You will not allocate one of these directly
+	 *
+	 * @param events Storage for the ring of events
+	 *
+	 * @param numEvents Number of events in events
+	 */
+	ADXL362BusRecorderBase(Event *events, size_t numEvents);
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362BusRecorderBase();
+
+	/**
+	 * @brief Add an event. Called by the driver; can be called from an interrupt.
+	 */
+	void record(uint8_t type, uint8_t context, uint8_t cmd = 0, uint8_t reg = 0, uint16_t len = 0) {
+		if (!enabled) {
+			return;
+		}
+
+		// Claiming the slot atomically makes this safe between thread and interrupt context
+		uint32_t index = writeCount.fetch_add(1, std::memory_order_relaxed) % numEvents;
+
+		Event &event = events[index];
+		event.micros = micros();
+		event.len = len;
+		event.type = type;
+		event.context = context;
+		event.cmd = cmd;
+		event.reg = reg;
+		event.reserved[0] = event.reserved[1] = 0;
+	};
+
+	/**
+	 * @brief Start or stop recording (default: recording)
+	 *
+	 * Stop recording before dump() if transactions may happen while dumping, so the ring doesn't change.
+	 */
+	void setEnabled(bool enabled) { this->enabled = enabled; };
+
+	/**
+	 * @brief Returns true if recording
+	 */
+	bool isEnabled() const { return enabled; };
+
+	/**
+	 * @brief Remove all of the events
+	 */
+	void clear();
+
+	/**
+	 * @brief Returns the number of events in the ring
+	 */
+	size_t getNumEvents() const;
+
+	/**
+	 * @brief Returns the number of events overwritten because the ring was full
+	 */
+	uint32_t getOverwrittenCount() const;
+
+	/**
+	 * @brief Get an event
+	 *
+	 * @param index 0 is the oldest event, up to getNumEvents() - 1
+	 *
+	 * @param event Filled in with the event
+	 *
+	 * @return false if index is out of range
+	 */
+	bool getEvent(size_t index, Event &event) const;
+
+	/**
+	 * @brief Write the events as text, oldest first
+	 *
+	 * @param out Where to write, typically Serial
+	 *
+	 * @param spiClockHz (optional) SPI clock speed in Hz, the same as in the SPISettings passed to the
+	 * driver. host/bustrace uses it to compare the transaction times with the ideal time. 0 if not known.
+	 *
+	 * Each line is "adxl362bus,micros,context,type,cmd,reg,len". The first line is
+	 * "adxl362bus,dump,numEvents,overwritten,spiClockHz".
+	 */
+	void dump(Print &out, uint32_t spiClockHz = 0) const;
+
+	static const uint8_t EVENT_BEGIN = 1;		//!< The driver started a transaction
+	static const uint8_t EVENT_SELECT = 2;		//!< The driver has the SPI bus and CS is low
+	static const uint8_t EVENT_DMA_START = 3;	//!< A FIFO read started the DMA transfer
+	static const uint8_t EVENT_END = 4;			//!< CS is high and the SPI bus was released
+
+protected:
+	Event *events; //!< Ring of events
+	size_t numEvents; //!< Number of events in the ring
+	std::atomic<uint32_t> writeCount; //!< Number of events recorded since clear()
+	volatile bool enabled = true; //!< Recording
+};
+
+/**
+ * @brief Bus transaction recorder
+ *
+ * @param NUM_EVENTS Number of events to keep. A register access is 3 events and a FIFO read is 4.
+ */
+template <size_t NUM_EVENTS = 256>
+class ADXL362BusRecorder : public ADXL362BusRecorderBase {
+public:
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362BusRecorder() : ADXL362BusRecorderBase(staticEvents, NUM_EVENTS) {};
+
+	/**
+	 * @brief Storage for the ring of events
+	 */
+	Event staticEvents[NUM_EVENTS];
+};
+
+#endif /* __ADXL362BUSRECORDER_H */
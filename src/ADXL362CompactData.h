@@ -0,0 +1,189 @@
+#ifndef __ADXL362COMPACTDATA_H
+#define __ADXL362COMPACTDATA_H
+
+// Compact FIFO buffers for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+
+/**
+ * @brief Buffer for FIFO data with a small header
+ *
+ * ADXL362DataBase has a virtual destructor and uses size_t and int fields, which is about 36 bytes
+ * of header per buffer on Gen 2 and Gen 3 devices. This class has the same purpose with a 12 byte
+ * header: no vtable, 16-bit counts, and the state and storeTemp flag packed into one byte. With a
+ * large ring of small buffers, the saving can be used for more buffers.
+ *
+ * Pass it to ADXL362DMA::readFifoAsync() the same way as ADXL362DataBase. The state values are the
+ * same (ADXL362DMA::STATE_FREE, etc.). The limits are a 65535 byte buffer, which is far larger than
+ * the FIFO, and a startOffset of 255.
+ *
+ * The DMA completion callback (ADXL362DMA::setCompletionCallback()) is only called for
+ * ADXL362DataBase buffers.
+ *
+ * You will not allocate one of these directly; use ADXL362CompactDataEx, which allocates the buffer.
+ */
+class ADXL362CompactData {
+public:
+	/**
+	 * @brief Constructor - You will not allocate one of these directly
+	 *
+	 * @param buf The buffer to store the data
+	 *
+	 * @param bufSize The size of the buffer in bytes
+	 */
+	ADXL362CompactData(uint8_t *buf, uint16_t bufSize) : buf(buf), bufSize(bufSize), state(ADXL362DMA::STATE_FREE), storeTemp(0) {};
+
+	/**
+	 * @brief Returns the sample size in bytes, 6 (XYZ) or 8 (XYZT)
+	 */
+	size_t getSampleSizeInBytes() const { return storeTemp ? 8 : 6; };
+
+	/**
+	 * @brief Read a whole sample out of the buffer
+	 *
+	 * @param index The index to read from 0 = first instead
+	 *
+	 * @param sample Filled in with the X, Y, Z, and T (if stored, otherwise 0) values
+	 */
+	void readSample(size_t index, ADXL362Sample &sample) const {
+		ADXL362DataBase::decodeSample(&buf[startOffset + getSampleSizeInBytes() * index], storeTemp, sample);
+	};
+
+	/**
+	 * @brief Iterator to the first sample in the buffer. Only valid in STATE_READ_COMPLETE.
+	 */
+	ADXL362DataBase::const_iterator begin() const { return ADXL362DataBase::const_iterator(&buf[startOffset], getSampleSizeInBytes(), storeTemp); };
+
+	/**
+	 * @brief Iterator past the last sample in the buffer
+	 */
+	ADXL362DataBase::const_iterator end() const { return ADXL362DataBase::const_iterator(&buf[startOffset + numSamplesRead * getSampleSizeInBytes()], getSampleSizeInBytes(), storeTemp); };
+
+	/**
+	 * @brief Number of samples in the buffer, the same as numSamplesRead
+	 */
+	size_t size() const { return numSamplesRead; };
+
+	uint8_t *buf; //!< Buffer, the first startOffset bytes are not part of a complete sample
+	uint16_t bufSize; //!< Size of buf in bytes
+	uint16_t bytesRead = 0; //!< Number of bytes (not samples!) read on completion
+	uint16_t numSamplesRead = 0; //!< Number of samples in the buffer
+	uint8_t startOffset = 0; //!< When the FIFO is out of sync with the beginning of the X sample, this is the offset
+	uint8_t state : 2; //!< ADXL362DMA::STATE_FREE, STATE_READING_FIFO, or STATE_READ_COMPLETE
+	uint8_t storeTemp : 1; //!< 1 if the samples include temperature (8 bytes per sample)
+};
+
+/**
+ * @brief Compact buffer with a pointer for an intrusive list, see ADXL362CompactList
+ *
+ * This lets buffers be moved between lists (such as free, reading, and ready) without a separate
+ * array of pointers or indexes. It adds 4 bytes to the header.
+ *
+ * You will not allocate one of these directly; use ADXL362CompactListDataEx, which allocates the buffer.
+ */
+class ADXL362CompactListData : public ADXL362CompactData {
+public:
+	/**
+	 * @brief Constructor - You will not allocate one of these directly
+	 */
+	ADXL362CompactListData(uint8_t *buf, uint16_t bufSize) : ADXL362CompactData(buf, bufSize) {};
+
+	ADXL362CompactListData *next = nullptr; //!< Next buffer in the list
+};
+
+/**
+ * @brief A singly linked FIFO queue of ADXL362CompactListData buffers
+ *
+ * Not thread or interrupt safe; use from one thread, or protect with ATOMIC_BLOCK.
+ */
+class ADXL362CompactList {
+public:
+	/**
+	 * @brief Add a buffer to the end of the list
+	 */
+	void pushBack(ADXL362CompactListData *data) {
+		data->next = nullptr;
+		if (tail) {
+			tail->next = data;
+		}
+		else {
+			head = data;
+		}
+		tail = data;
+		count++;
+	};
+
+	/**
+	 * @brief Remove the buffer at the front of the list
+	 *
+	 * @return The buffer, or nullptr if the list is empty
+	 */
+	ADXL362CompactListData *popFront() {
+		ADXL362CompactListData *data = head;
+		if (data) {
+			head = data->next;
+			if (!head) {
+				tail = nullptr;
+			}
+			data->next = nullptr;
+			count--;
+		}
+		return data;
+	};
+
+	/**
+	 * @brief Returns the buffer at the front of the list without removing it, or nullptr if empty
+	 */
+	ADXL362CompactListData *front() const { return head; };
+
+	/**
+	 * @brief Returns true if the list is empty
+	 */
+	bool isEmpty() const { return head == nullptr; };
+
+	/**
+	 * @brief Returns the number of buffers in the list
+	 */
+	size_t getCount() const { return count; };
+
+protected:
+	ADXL362CompactListData *head = nullptr; //!< First buffer
+	ADXL362CompactListData *tail = nullptr; //!< Last buffer
+	size_t count = 0; //!< Number of buffers
+};
+
+/**
+ * @brief Compact buffer with storage
+ *
+ * @param BUF_SIZE Buffer size in bytes. Should be a multiple of 6 (XYZ) or 8 (XYZT).
+ */
+template <uint16_t BUF_SIZE>
+class ADXL362CompactDataEx : public ADXL362CompactData {
+public:
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362CompactDataEx() : ADXL362CompactData(staticBuf, BUF_SIZE) {};
+
+	alignas(4) uint8_t staticBuf[BUF_SIZE]; //!< Buffer storage
+};
+
+/**
+ * @brief Compact buffer with an intrusive list pointer and storage
+ *
+ * @param BUF_SIZE Buffer size in bytes. Should be a multiple of 6 (XYZ) or 8 (XYZT).
+ */
+template <uint16_t BUF_SIZE>
+class ADXL362CompactListDataEx : public ADXL362CompactListData {
+public:
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362CompactListDataEx() : ADXL362CompactListData(staticBuf, BUF_SIZE) {};
+
+	alignas(4) uint8_t staticBuf[BUF_SIZE]; //!< Buffer storage
+};
+
+#endif /* __ADXL362COMPACTDATA_H */
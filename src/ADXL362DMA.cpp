@@ -1,6 +1,8 @@
 #include "Particle.h"
 
 #include "ADXL362DMA.h"
+#include "ADXL362CompactData.h"
+#include "ADXL362BusRecorder.h"
 
 #include <math.h>
 #include <cmath>
@@ -19,29 +21,51 @@ static Mutex syncCallbackMutex;
 static volatile bool syncCallbackDone;
 #endif
 
-static ADXL362DataBase *readFifoData;
-static ADXL362DMA *readFifoObject;
+template <class Transport>
+ADXL362DMABasic<Transport> *ADXL362DMABasic<Transport>::readFifoObject;
+
+template <class Transport>
+ADXL362DataBase *ADXL362DMABasic<Transport>::readFifoData;
+
+template <class Transport>
+ADXL362CompactData *ADXL362DMABasic<Transport>::readFifoCompactData;
+
+static_assert(sizeof(ADXL362DMA::RetainedState::shadowRegs) == (ADXL362DMA::REG_SELF_TEST - ADXL362DMA::REG_THRESH_ACT_L + 1), "shadowRegs size mismatch");
 
 // These methods are described in greater detail in the .h file
 
 
-ADXL362DMA::ADXL362DMA(SPIClass &spi, int cs, SPISettings settings) : spi(spi), cs(cs), settings(settings) {
+template <class Transport>
+ADXL362DMABasic<Transport>::ADXL362DMABasic(const Transport &transport) : transport(transport) {
+	resetShadowRegisters();
 }
 
-ADXL362DMA::~ADXL362DMA() {
+template <class Transport>
+ADXL362DMABasic<Transport>::~ADXL362DMABasic() {
 }
 
-void ADXL362DMA::softReset() {
+template <class Transport>
+void ADXL362DMABasic<Transport>::softReset() {
 
 	// Log.info("softReset");
 	writeRegister8(REG_SOFT_RESET, 'R');
+
+	resetShadowRegisters();
+	storeTemp = false;
+	rangeG = 2;
+	partialSampleBytesCount = 0;
+	samplesRead = 0;
+	realignCount = 0;
+	configured = false;
 }
 
-bool ADXL362DMA::chipDetect() {
+template <class Transport>
+bool ADXL362DMABasic<Transport>::chipDetect() {
 	return readRegister8(REG_DEVID_AD) == 0xAD && readRegister8(REG_DEVID_MST) == 0x1D;
 }
 
-void ADXL362DMA::setSampleRate(SampleRate rate) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::setSampleRate(SampleRate rate) {
 	uint8_t filterCtl = readFilterControl();
 
 
@@ -84,7 +108,8 @@ void ADXL362DMA::setSampleRate(SampleRate rate) {
 	writeFilterControl(filterCtl);
 }
 
-void ADXL362DMA::setMeasureMode(bool enabled) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::setMeasureMode(bool enabled) {
 
 	uint8_t value = readRegister8(REG_POWER_CTL);
 
@@ -100,7 +125,8 @@ void ADXL362DMA::setMeasureMode(bool enabled) {
 
 }
 
-void ADXL362DMA::readXYZT(int16_t &x, int16_t &y, int16_t &z, int16_t &t) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::readXYZT(int16_t &x, int16_t &y, int16_t &z, int16_t &t) {
 	uint8_t req[10], resp[10];
 
 	req[0] = CMD_READ_REGISTER;
@@ -117,7 +143,8 @@ void ADXL362DMA::readXYZT(int16_t &x, int16_t &y, int16_t &z, int16_t &t) {
 	t = resp[8] | (((int16_t)resp[9]) << 8);
 }
 
-void ADXL362DMA::readXYZ(int16_t &x, int16_t &y, int16_t &z) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::readXYZ(int16_t &x, int16_t &y, int16_t &z) {
 	uint8_t req[8], resp[8];
 
 	req[0] = CMD_READ_REGISTER;
@@ -134,15 +161,18 @@ void ADXL362DMA::readXYZ(int16_t &x, int16_t &y, int16_t &z) {
 
 }
 
-float ADXL362DMA::readTemperatureC() {
+template <class Transport>
+float ADXL362DMABasic<Transport>::readTemperatureC() {
 	return ((float) ((int16_t)readRegister16(REG_TDATA_L))) / 16.0;
 }
 
-float ADXL362DMA::readTemperatureF() {
+template <class Transport>
+float ADXL362DMABasic<Transport>::readTemperatureF() {
 	return (readTemperatureC() * 9.0) / 5.0 + 32.0;
 }
 
-void ADXL362DMA::readRollPitchRadians(float &roll, float &pitch) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::readRollPitchRadians(float &roll, float &pitch) {
 	int16_t x, y, z;
 
 	readXYZ(x, y, z);
@@ -157,7 +187,8 @@ void ADXL362DMA::readRollPitchRadians(float &roll, float &pitch) {
 	roll = atan(yg / sqrt(pow(xg, 2) + pow(zg, 2)));
 }
 
-void ADXL362DMA::readRollPitchDegrees(float &roll, float &pitch) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::readRollPitchDegrees(float &roll, float &pitch) {
 	readRollPitchRadians(roll, pitch);
 	
 	float conv = 180.0 / M_PI;
@@ -167,99 +198,329 @@ void ADXL362DMA::readRollPitchDegrees(float &roll, float &pitch) {
 }
 
 
-uint8_t ADXL362DMA::readStatus() {
+template <class Transport>
+uint8_t ADXL362DMABasic<Transport>::readStatus() {
 	return readRegister8(REG_STATUS);
 }
 
-uint16_t ADXL362DMA::readNumFifoEntries() {
+template <class Transport>
+uint16_t ADXL362DMABasic<Transport>::readNumFifoEntries() {
 	return readRegister16(REG_FIFO_ENTRIES_L);
 }
 
-void ADXL362DMA::readFifoAsync(ADXL362DataBase *data) {
-	readFifoData = data;
-	readFifoObject = this;
+template <class Transport>
+void ADXL362DMABasic<Transport>::readFifoAsync(ADXL362DataBase *data) {
+	readFifoAsync(data, readNumFifoEntries());
+}
 
-	data->sampleSizeInBytes = getSampleSizeInBytes();
+template <class Transport>
+void ADXL362DMABasic<Transport>::readFifoAsync(ADXL362DataBase *data, uint16_t numEntries) {
+	checkFifoOverflow(numEntries);
 
+	data->sampleSizeInBytes = getSampleSizeInBytes();
 
-	data->numSamplesRead = readNumFifoEntries() / (data->sampleSizeInBytes / 2);
+	size_t bytesToRead = fifoReadSize(numEntries, data->bufSize);
 
-	if (data->numSamplesRead < 1) {
+	data->numSamplesRead = (partialSampleBytesCount + bytesToRead) / data->sampleSizeInBytes;
+	if (bytesToRead == 0) {
 		// Leave buffer in free state
 		return;
 	}
 
-	size_t maxFullSamples = (data->bufSize - partialSampleBytesCount) / data->sampleSizeInBytes;
-	if (data->numSamplesRead > maxFullSamples) {
-		data->numSamplesRead = maxFullSamples;
+	data->bytesRead = bytesToRead;
+	data->state = STATE_READING_FIFO;
+	data->storeTemp = storeTemp;
+
+	readFifoData = data;
+	readFifoCompactData = nullptr;
+	readFifoObject = this;
+
+	startFifoRead(data->buf, bytesToRead);
+}
+
+template <class Transport>
+void ADXL362DMABasic<Transport>::readFifoAsync(ADXL362CompactData *data) {
+	readFifoAsync(data, readNumFifoEntries());
+}
+
+template <class Transport>
+void ADXL362DMABasic<Transport>::readFifoAsync(ADXL362CompactData *data, uint16_t numEntries) {
+	checkFifoOverflow(numEntries);
+
+	size_t bytesToRead = fifoReadSize(numEntries, data->bufSize);
+
+	data->numSamplesRead = (uint16_t)((partialSampleBytesCount + bytesToRead) / getSampleSizeInBytes());
+	if (bytesToRead == 0) {
+		// Leave buffer in free state
+		return;
 	}
 
-	data->bytesRead = data->numSamplesRead * data->sampleSizeInBytes;
+	data->bytesRead = (uint16_t)bytesToRead;
 	data->state = STATE_READING_FIFO;
 	data->storeTemp = storeTemp;
 
+	readFifoData = nullptr;
+	readFifoCompactData = data;
+	readFifoObject = this;
+
+	startFifoRead(data->buf, bytesToRead);
+}
+
+template <class Transport>
+void ADXL362DMABasic<Transport>::checkFifoOverflow(uint16_t numEntries) {
+	uint8_t fifoMode = getShadowRegister(REG_FIFO_CONTROL) & 0x03;
+	if (partialSampleBytesCount == 0 || (fifoMode != FIFO_STREAM && fifoMode != FIFO_TRIGGERED)) {
+		return;
+	}
+
+	if (numEntries + getSampleSizeInBytes() / 2 > FIFO_NUM_ENTRIES) {
+		// The FIFO is full or nearly full, so the oldest entries may have been discarded since the last
+		// read. The rest of the partial sample is probably gone, and joining it with the next entries
+		// would make a sample out of two different samples, so discard it.
+		partialSampleBytesCount = 0;
+		realignCount++;
+	}
+}
+
+template <class Transport>
+size_t ADXL362DMABasic<Transport>::fifoReadSize(uint16_t numEntries, size_t bufSize) const {
+	size_t sampleSize = getSampleSizeInBytes();
+
+	if (bufSize <= partialSampleBytesCount) {
+		return 0;
+	}
+
+	// The partial sample from the last read is copied to the start of the buffer, so read enough to
+	// complete it. This gets the buffer back to a sample boundary.
+	size_t numSamples = (partialSampleBytesCount + (size_t)numEntries * 2) / sampleSize;
+
+	size_t maxFullSamples = bufSize / sampleSize;
+	if (numSamples > maxFullSamples) {
+		numSamples = maxFullSamples;
+	}
+	if (numSamples == 0) {
+		return 0;
+	}
+
+	return numSamples * sampleSize - partialSampleBytesCount;
+}
+
+template <class Transport>
+void ADXL362DMABasic<Transport>::startFifoRead(uint8_t *buf, size_t bytesToRead) {
 	if (partialSampleBytesCount) {
-		memcpy(data->buf, partialSampleBytes, partialSampleBytesCount);
+		memcpy(buf, partialSampleBytes, partialSampleBytesCount);
 	}
 
-	beginTransaction();
+	transactionCount++;
+	transactionBytes += 1 + bytesToRead;
 
-	spi.transfer(CMD_READ_FIFO);
+	beginTransaction(CMD_READ_FIFO, 0, 1 + bytesToRead);
 
-	spi.transfer(NULL, &data->buf[partialSampleBytesCount], data->bytesRead, readFifoCallbackInternal);
+	transport.transfer(CMD_READ_FIFO);
+
+	if (busRecorder) {
+		busRecorder->record(ADXL362BusRecorderBase::EVENT_DMA_START, busContext);
+	}
+	transport.transfer(NULL, &buf[partialSampleBytesCount], bytesToRead, readFifoCallbackInternal);
 }
 
 // [static]
-void ADXL362DMA::readFifoCallbackInternal(void) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::readFifoCallbackInternal(void) {
 	readFifoObject->endTransaction();
+
+	if (readFifoCompactData) {
+		readFifoObject->cleanBuffer(readFifoCompactData);
+		readFifoCompactData->state = STATE_READ_COMPLETE;
+		return;
+	}
+
 	readFifoObject->cleanBuffer(readFifoData);
 	readFifoData->state = STATE_READ_COMPLETE;
+
+	if (readFifoObject->completionCallback) {
+		readFifoObject->completionCallback(readFifoData, readFifoObject->completionContext);
+	}
 }
 
-void ADXL362DMA::cleanBuffer(ADXL362DataBase *data) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::cleanBuffer(ADXL362DataBase *data) {
 	data->bytesRead += partialSampleBytesCount;
+
+	data->numSamplesRead = cleanBuffer(data->buf, data->bytesRead, data->sampleSizeInBytes, data->startOffset);
+}
+
+template <class Transport>
+void ADXL362DMABasic<Transport>::cleanBuffer(ADXL362CompactData *data) {
+	data->bytesRead += partialSampleBytesCount;
+
+	size_t startOffset;
+	size_t numSamplesRead = cleanBuffer(data->buf, data->bytesRead, getSampleSizeInBytes(), startOffset);
+	if (startOffset > 0xff) {
+		// No X value near the start of the buffer; the data is not usable
+		numSamplesRead = 0;
+		startOffset = 0;
+	}
+	data->startOffset = (uint8_t)startOffset;
+	data->numSamplesRead = (uint16_t)numSamplesRead;
+}
+
+template <class Transport>
+size_t ADXL362DMABasic<Transport>::cleanBuffer(const uint8_t *buf, size_t bytesRead, size_t sampleSize, size_t &startOffset) {
 	partialSampleBytesCount = 0;
 
-	for(data->startOffset = 0; data->startOffset < data->bytesRead; data->startOffset += 2) {
-		uint8_t dataType = (data->buf[data->startOffset] >> 6) & 0x3;
-		if (dataType == 0x0) { // x-axis
+	for(startOffset = 0; startOffset + 1 < bytesRead; startOffset += 2) {
+		// Check that the entries have the axes X, Y, Z, (T) in order
+		size_t ii;
+		for(ii = 0; ii < sampleSize && startOffset + ii + 1 < bytesRead; ii += 2) {
+			if (ADXL362DataBase::decodeAxis(&buf[startOffset + ii]) != ii / 2) {
+				break;
+			}
+		}
+		if (ii >= sampleSize || startOffset + ii + 1 >= bytesRead) {
 			break;
 		}
 	}
+	if (startOffset > bytesRead) {
+		startOffset = bytesRead;
+	}
+	if (startOffset > 0) {
+		realignCount++;
+	}
 
-	data->numSamplesRead = (data->bytesRead - data->startOffset) / data->sampleSizeInBytes;
+	size_t numSamplesRead = (bytesRead - startOffset) / sampleSize;
 
-	partialSampleBytesCount = data->bytesRead - data->numSamplesRead * data->sampleSizeInBytes;
+	partialSampleBytesCount = bytesRead - startOffset - numSamplesRead * sampleSize;
 	if (partialSampleBytesCount > 0) {
-		memcpy(partialSampleBytes, &data->buf[data->bytesRead - partialSampleBytesCount], partialSampleBytesCount);
+		memcpy(partialSampleBytes, &buf[bytesRead - partialSampleBytesCount], partialSampleBytesCount);
+	}
+
+	samplesRead += numSamplesRead;
+
+	return numSamplesRead;
+}
+
+template <class Transport>
+uint8_t ADXL362DMABasic<Transport>::getShadowRegister(uint8_t addr) const {
+	if (addr < SHADOW_REG_FIRST || addr >= SHADOW_REG_FIRST + NUM_SHADOW_REGS) {
+		return 0;
 	}
+	return shadowRegs[addr - SHADOW_REG_FIRST];
+}
 
+template <class Transport>
+uint16_t ADXL362DMABasic<Transport>::getFifoSamples() const {
+	uint16_t samples = getShadowRegister(REG_FIFO_SAMPLES);
+	if (getShadowRegister(REG_FIFO_CONTROL) & 0x08) {
+		// AH bit
+		samples |= 0x100;
+	}
+	return samples;
+}
+
+template <class Transport>
+float ADXL362DMABasic<Transport>::getOutputDataRate() const {
+	uint8_t odr = getShadowRegister(REG_FILTER_CTL) & ODR_MASK;
+	if (odr > ODR_400) {
+		// Reserved values
+		odr = ODR_400;
+	}
+	return 12.5 * (float)(1 << odr);
 }
 
+template <class Transport>
+void ADXL362DMABasic<Transport>::saveState(RetainedState &state) const {
+	state.magic = RETAINED_STATE_MAGIC;
+	state.version = RETAINED_STATE_VERSION;
+	state.flags = 0;
+	if (storeTemp) {
+		state.flags |= RETAINED_FLAG_STORE_TEMP;
+	}
+	if (configured) {
+		state.flags |= RETAINED_FLAG_CONFIGURED;
+	}
+	state.rangeG = rangeG;
+	state.partialSampleBytesCount = (uint8_t) partialSampleBytesCount;
+	memcpy(state.partialSampleBytes, partialSampleBytes, sizeof(state.partialSampleBytes));
+	memcpy(state.shadowRegs, shadowRegs, sizeof(state.shadowRegs));
+	state.reserved = 0;
+	state.samplesRead = samplesRead;
+}
+
+template <class Transport>
+bool ADXL362DMABasic<Transport>::restoreState(const RetainedState &state) {
+	if (state.magic != RETAINED_STATE_MAGIC || state.version != RETAINED_STATE_VERSION) {
+		return false;
+	}
+	if (state.partialSampleBytesCount > sizeof(partialSampleBytes) || (state.flags & RETAINED_FLAG_CONFIGURED) == 0) {
+		return false;
+	}
+	
+	storeTemp = (state.flags & RETAINED_FLAG_STORE_TEMP) != 0;
+	configured = true;
+	rangeG = state.rangeG;
+	partialSampleBytesCount = state.partialSampleBytesCount;
+	memcpy(partialSampleBytes, state.partialSampleBytes, sizeof(partialSampleBytes));
+	memcpy(shadowRegs, state.shadowRegs, sizeof(shadowRegs));
+	samplesRead = state.samplesRead;
 
-void ADXL362DMA::writeActivityThreshold(uint16_t value) { // value is an 11-bit integer
+	return true;
+}
+
+// [static]
+template <class Transport>
+void ADXL362DMABasic<Transport>::invalidateState(RetainedState &state) {
+	state.magic = 0;
+}
+
+template <class Transport>
+void ADXL362DMABasic<Transport>::resetShadowRegisters() {
+	memset(shadowRegs, 0, sizeof(shadowRegs));
+
+	// Registers with non-zero reset values
+	shadowRegs[REG_FIFO_SAMPLES - SHADOW_REG_FIRST] = 0x80;
+	shadowRegs[REG_FILTER_CTL - SHADOW_REG_FIRST] = 0x13;
+}
+
+template <class Transport>
+void ADXL362DMABasic<Transport>::updateShadowRegister(uint8_t addr, uint8_t value) {
+	if (addr >= SHADOW_REG_FIRST && addr < SHADOW_REG_FIRST + NUM_SHADOW_REGS) {
+		shadowRegs[addr - SHADOW_REG_FIRST] = value;
+		configured = true;
+	}
+}
+
+
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeActivityThreshold(uint16_t value) { // value is an 11-bit integer
 	writeRegister16(REG_THRESH_ACT_L, value);
 }
 
-void ADXL362DMA::writeActivityTime(uint8_t value) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeActivityTime(uint8_t value) {
 	writeRegister8(REG_TIME_ACT, value);
 }
-void ADXL362DMA::writeInactivityThreshold(uint16_t value) { // value is an 11-bit integer
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeInactivityThreshold(uint16_t value) { // value is an 11-bit integer
 	writeRegister16(REG_THRESH_INACT_L, value);
 }
-void ADXL362DMA::writeInactivityTime(uint16_t value) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeInactivityTime(uint16_t value) {
 	writeRegister16(REG_TIME_INACT_L, value);
 }
 
-uint8_t ADXL362DMA::readActivityControl(uint8_t value) {
+template <class Transport>
+uint8_t ADXL362DMABasic<Transport>::readActivityControl(uint8_t value) {
 	return readRegister8(REG_ACT_INACT_CTL);
 }
 
-void ADXL362DMA::writeActivityControl(uint8_t value) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeActivityControl(uint8_t value) {
 	writeRegister8(REG_ACT_INACT_CTL, value);
 }
 
-void ADXL362DMA::writeActivityControl(uint8_t linkLoop, bool inactRef, bool inactEn, bool actRef, bool actEn) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeActivityControl(uint8_t linkLoop, bool inactRef, bool inactEn, bool actRef, bool actEn) {
 	uint8_t value = 0;
 
 	value |= (linkLoop & 0x3) << 4;
@@ -280,20 +541,24 @@ void ADXL362DMA::writeActivityControl(uint8_t linkLoop, bool inactRef, bool inac
 }
 
 
-uint8_t ADXL362DMA::readFifoControl() {
+template <class Transport>
+uint8_t ADXL362DMABasic<Transport>::readFifoControl() {
 	return readRegister8(REG_FIFO_CONTROL);
 }
 
-void ADXL362DMA::writeFifoControl(uint8_t value) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeFifoControl(uint8_t value) {
 	writeRegister8(REG_FIFO_CONTROL, value);
 }
 
-void ADXL362DMA::writeFifoSamples(uint8_t value) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeFifoSamples(uint8_t value) {
 	writeRegister8(REG_FIFO_SAMPLES, value);
 }
 
 
-void ADXL362DMA::writeFifoControlAndSamples(uint16_t samples, bool storeTemp, uint8_t fifoMode) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeFifoControlAndSamples(uint16_t samples, bool storeTemp, uint8_t fifoMode) {
 	uint8_t value = 0;
 
 	this->storeTemp = storeTemp;
@@ -312,31 +577,38 @@ void ADXL362DMA::writeFifoControlAndSamples(uint16_t samples, bool storeTemp, ui
 }
 
 
-uint8_t ADXL362DMA::readIntmap1() {
+template <class Transport>
+uint8_t ADXL362DMABasic<Transport>::readIntmap1() {
 	return readRegister8(REG_FIFO_INTMAP1);
 }
 
-void ADXL362DMA::writeIntmap1(uint8_t value) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeIntmap1(uint8_t value) {
 	writeRegister8(REG_FIFO_INTMAP1, value);
 }
 
-uint8_t ADXL362DMA::readIntmap2() {
+template <class Transport>
+uint8_t ADXL362DMABasic<Transport>::readIntmap2() {
 	return readRegister8(REG_FIFO_INTMAP2);
 }
 
-void ADXL362DMA::writeIntmap2(uint8_t value) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeIntmap2(uint8_t value) {
 	writeRegister8(REG_FIFO_INTMAP2, value);
 }
 
-uint8_t ADXL362DMA::readPowerCtl() {
+template <class Transport>
+uint8_t ADXL362DMABasic<Transport>::readPowerCtl() {
 	return readRegister8(REG_POWER_CTL);
 }
 
-void ADXL362DMA::writePowerCtl(uint8_t value) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writePowerCtl(uint8_t value) {
 	writeRegister8(REG_POWER_CTL, value);
 }
 
-void ADXL362DMA::writePowerCtl(bool extClock, uint8_t lowNoise, bool wakeup, bool autosleep, uint8_t measureMode) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writePowerCtl(bool extClock, uint8_t lowNoise, bool wakeup, bool autosleep, uint8_t measureMode) {
 	uint8_t temp = 0;
 
 	if (extClock) {
@@ -354,7 +626,8 @@ void ADXL362DMA::writePowerCtl(bool extClock, uint8_t lowNoise, bool wakeup, boo
 	writePowerCtl(temp);
 }
 
-void ADXL362DMA::writeLowNoise(uint8_t value) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeLowNoise(uint8_t value) {
 	uint8_t temp = readPowerCtl();
 
 	temp &= 0xc0;
@@ -363,7 +636,8 @@ void ADXL362DMA::writeLowNoise(uint8_t value) {
 	writePowerCtl(temp);
 }
 
-void ADXL362DMA::writeMeasureMode(uint8_t value) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeMeasureMode(uint8_t value) {
 	uint8_t temp = readPowerCtl();
 
 	temp &= 0x3;
@@ -374,16 +648,19 @@ void ADXL362DMA::writeMeasureMode(uint8_t value) {
 
 
 
-uint8_t ADXL362DMA::readFilterControl() {
+template <class Transport>
+uint8_t ADXL362DMABasic<Transport>::readFilterControl() {
 	return readRegister8(REG_FILTER_CTL);
 }
 
-void ADXL362DMA::writeFilterControl(uint8_t value) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeFilterControl(uint8_t value) {
 	writeRegister8(REG_FILTER_CTL, value);
 }
 
 
-void ADXL362DMA::writeFilterControl(uint8_t range, bool halfBW, bool extSample, uint8_t odr) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeFilterControl(uint8_t range, bool halfBW, bool extSample, uint8_t odr) {
 	uint8_t value = 0;
 
 	value |= (range & 0x3) << 6;
@@ -415,7 +692,8 @@ void ADXL362DMA::writeFilterControl(uint8_t range, bool halfBW, bool extSample,
 }
 
 
-uint8_t ADXL362DMA::readRegister8(uint8_t addr) {
+template <class Transport>
+uint8_t ADXL362DMABasic<Transport>::readRegister8(uint8_t addr) {
 	uint8_t req[3], resp[3];
 
 	req[0] = CMD_READ_REGISTER;
@@ -427,7 +705,8 @@ uint8_t ADXL362DMA::readRegister8(uint8_t addr) {
 	return resp[2];
 }
 
-uint16_t ADXL362DMA::readRegister16(uint8_t addr) {
+template <class Transport>
+uint16_t ADXL362DMABasic<Transport>::readRegister16(uint8_t addr) {
 	uint8_t req[4], resp[4];
 
 	req[0] = CMD_READ_REGISTER;
@@ -440,7 +719,8 @@ uint16_t ADXL362DMA::readRegister16(uint8_t addr) {
 }
 
 
-void ADXL362DMA::writeRegister8(uint8_t addr, uint8_t value) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeRegister8(uint8_t addr, uint8_t value) {
 	// Serial.printlnf("writeRegister addr=%02x value=%02x", addr, value);
 
 	uint8_t req[3], resp[3];
@@ -450,9 +730,12 @@ void ADXL362DMA::writeRegister8(uint8_t addr, uint8_t value) {
 	req[2] = value;
 
 	syncTransaction(req, resp, sizeof(req));
+
+	updateShadowRegister(addr, value);
 }
 
-void ADXL362DMA::writeRegister16(uint8_t addr, uint16_t value) {
+template <class Transport>
+void ADXL362DMABasic<Transport>::writeRegister16(uint8_t addr, uint16_t value) {
 	// Serial.printlnf("writeRegister addr=%02x value=%04x", addr, value);
 
 	uint8_t req[4], resp[4];
@@ -463,27 +746,44 @@ void ADXL362DMA::writeRegister16(uint8_t addr, uint16_t value) {
 	req[3] = value >> 8;
 
 	syncTransaction(req, resp, sizeof(req));
+
+	updateShadowRegister(addr, value & 0xff);
+	updateShadowRegister(addr + 1, value >> 8);
 }
 
 
-void ADXL362DMA::beginTransaction() {
+template <class Transport>
+void ADXL362DMABasic<Transport>::beginTransaction(uint8_t cmd, uint8_t reg, size_t len) {
+	if (busRecorder) {
+		busRecorder->record(ADXL362BusRecorderBase::EVENT_BEGIN, busContext, cmd, reg, (uint16_t)len);
+	}
 	if (!initialized) {
 		initialized = true;
-		spi.begin(cs);
+		transport.begin();
+	}
+	transport.beginTransaction();
+	if (busRecorder) {
+		busRecorder->record(ADXL362BusRecorderBase::EVENT_SELECT, busContext);
 	}
-	spi.beginTransaction(settings);
-	digitalWrite(cs, LOW);
 }
 
-void ADXL362DMA::endTransaction() {
-	digitalWrite(cs, HIGH);
-	spi.endTransaction();
+template <class Transport>
+void ADXL362DMABasic<Transport>::endTransaction() {
+	transport.endTransaction();
+	if (busRecorder) {
+		busRecorder->record(ADXL362BusRecorderBase::EVENT_END, busContext);
+	}
 }
 
-void ADXL362DMA::syncTransaction(void *req, void *resp, size_t len) {
-	beginTransaction();
+template <class Transport>
+void ADXL362DMABasic<Transport>::syncTransaction(void *req, void *resp, size_t len) {
+	transactionCount++;
+	transactionBytes += len;
+
+	const uint8_t *reqBytes = (const uint8_t *)req;
+	beginTransaction((len >= 1) ? reqBytes[0] : 0, (len >= 2) ? reqBytes[1] : 0, len);
 
-	spi.transfer(req, resp, len, nullptr);
+	transport.transfer(req, resp, len, nullptr);
 
 	endTransaction();
 }
@@ -496,16 +796,6 @@ It is recommended that an even number of bytes be read (using a multibyte transa
 
 
 
-int16_t ADXL362DataBase::readSigned14(const uint8_t *pValue) const {
-	uint8_t msb = pValue[0] & 0x3f;
-	if (msb & 0x20) {
-		// Add in sign extension
-		msb |= 0xc0;
-	}
-
-	return ((int16_t) pValue[1] | (msb << 8));
-}
-
 int16_t ADXL362DataBase::readX(size_t index) const {
 	return readSigned14(&buf[startOffset + sampleSizeInBytes * index]);
 }
@@ -522,3 +812,11 @@ int16_t ADXL362DataBase::readT(size_t index) const {
 	return readSigned14(&buf[startOffset + sampleSizeInBytes * index + 6]);
 }
 
+
+void ADXL362DataBase::readSample(size_t index, ADXL362Sample &sample) const {
+	decodeSample(&buf[startOffset + sampleSizeInBytes * index], storeTemp, sample);
+}
+
+template class ADXL362DMABasic<ADXL362SPITransport>;
+template class ADXL362DMABasic<ADXL362RecordingTransport<ADXL362SPITransport>>;
+template class ADXL362DMABasic<ADXL362ReplayTransport>;
@@ -15,12 +15,37 @@
 // INT2: depends on usage
 // INT1: depends on usage
 
+#include <iterator>
+
+#if defined(__has_include)
+#if __has_include(<span>) && __cplusplus >= 202002L
+#include <span>
+#define ADXL362_HAS_SPAN 1
+#endif
+#endif
+
+#include "ADXL362Transport.h"
+
 class ADXL362DataBase; // Forward declaration
+class ADXL362CompactData; // Forward declaration
+class ADXL362BusRecorderBase; // Forward declaration
 
 /**
- * @brief Class for ADXL362 accelerometer, connected by SPI
+ * @brief One decoded XYZ or XYZT sample
  */
-class ADXL362DMA {
+struct ADXL362Sample {
+	int16_t x;		//!< X acceleration in counts
+	int16_t y;		//!< Y acceleration in counts
+	int16_t z;		//!< Z acceleration in counts
+	int16_t t;		//!< Temperature, if stored in the FIFO, otherwise 0
+};
+
+/**
+ * @brief Types and constants for ADXL362DMABasic, the same for all transports
+ *
+ * You will not allocate one of these directly; use ADXL362DMA.
+ */
+class ADXL362DMABase {
 public:
 	/**
 	 * @brief Sample rate constants for setSampleRate
@@ -38,27 +63,184 @@ public:
 	};
 
 	/**
-	 * @brief Initialize the ADXL362 handler object. 
+	 * @brief Function called when readFifoAsync() completes
 	 * 
-	 * @param spi The SPI interface, could be `SPI` or `SPI1`
-	 * @param cs The chip select pin to use
-	 * @param settings (optional) SPISettings to set the data rate, etc.
+	 * @param data The buffer, which is in STATE_READ_COMPLETE state
 	 * 
-	 * Usually created as  global variable like this:
-	 *
-	 * ADXL362 accel(SPI, A2);
+	 * @param context The context passed to setCompletionCallback()
 	 * 
-	 * You can have generally have multiple devices on a single SPI bus, but each SPI device must
-	 * have its own CS (chip select) pin. 
+	 * This is called from the SPI DMA completion callback, which may be an interrupt context. It 
+	 * must be short and must not block or allocate memory.
+	 */
+	typedef void (*CompletionCallback)(ADXL362DataBase *data, void *context);
+
+	/**
+	 * @brief Driver state that can be kept in retained memory across MCU sleep
 	 * 
-	 * SPI speed can be from 1 MHz to 8 MHz.
+	 * Declare a global variable of this type with the `retained` keyword. Before sleeping, call
+	 * saveState(). After waking, call restoreState(); if it returns true the ADXL362 kept running
+	 * while the MCU was asleep and the FIFO can be drained immediately, without softReset() or
+	 * reconfiguring the chip.
+	 * 
+	 * The SPI initialization flag is not saved because the SPI peripheral must be initialized
+	 * again after waking; this happens automatically on the next transaction.
+	 */
+	struct RetainedState {
+		uint32_t magic;						//!< RETAINED_STATE_MAGIC when valid
+		uint8_t version;					//!< RETAINED_STATE_VERSION
+		uint8_t flags;						//!< RETAINED_FLAG_STORE_TEMP, RETAINED_FLAG_CONFIGURED
+		uint8_t rangeG;						//!< Range in g (2, 4, or 8)
+		uint8_t partialSampleBytesCount;	//!< Number of valid bytes in partialSampleBytes
+		uint8_t partialSampleBytes[8];		//!< Partial sample carried over to the next FIFO read
+		uint8_t shadowRegs[15];				//!< Configuration registers 0x20 - 0x2E
+		uint8_t reserved;					//!< Padding, set to 0
+		uint32_t samplesRead;				//!< Number of complete samples read from the FIFO (stream position)
+	};
+
+	// Command bytes
+	static const uint8_t CMD_WRITE_REGISTER = 0x0a; 	//!< Write register command
+	static const uint8_t CMD_READ_REGISTER = 0x0b; 		//!< Read register command
+	static const uint8_t CMD_READ_FIFO = 0x0d;			//!< Read FIFO command
+
+	// Registers
+	static const uint8_t REG_DEVID_AD = 0x00;			//!< Device ID register (0xAD)
+	static const uint8_t REG_DEVID_MST = 0x01;			//!< MEMS device ID (0x1D)
+	static const uint8_t REG_PART_ID = 0x02;			//!< Part ID (0xF2)
+	static const uint8_t REG_SILICON_ID = 0x03;			//!< Silicon Revision ID (0x01)
+	static const uint8_t REG_XDATA_8 = 0x08;			//!< X axis data, 8 MSB only
+	static const uint8_t REG_YDATA_8 = 0x09;			//!< Y axis data, 8 MSB only
+	static const uint8_t REG_ZDATA_8 = 0x0a;			//!< Z axis data, 8 MSB only
+	static const uint8_t REG_STATUS = 0x0b;				//!< Status register
+	static const uint8_t REG_FIFO_ENTRIES_L = 0x0c;		//!< Number of FIFO entries (LSB)
+	static const uint8_t REG_FIFO_ENTRIES_H = 0x0d;		//!< Number of FIFO entries (MSB)
+	static const uint8_t REG_XDATA_L = 0x0e;			//!< X axis data (LSB)
+	static const uint8_t REG_XDATA_H = 0x0f;			//!< X axis data (MSB)
+	static const uint8_t REG_YDATA_L = 0x10;			//!< Y axis data (LSB)
+	static const uint8_t REG_YDATA_H = 0x11;			//!< Y axis data (MSB)
+	static const uint8_t REG_ZDATA_L = 0x12;			//!< Z axis data (LSB)
+	static const uint8_t REG_ZDATA_H = 0x13;			//!< Z axis data (MSB)
+	static const uint8_t REG_TDATA_L = 0x14;			//!< Temperature data (LSB)
+	static const uint8_t REG_TDATA_H = 0x15;			//!< Temperature data (MSB)
+	static const uint8_t REG_SOFT_RESET = 0x1f;			//!< Soft reset register
+	static const uint8_t REG_THRESH_ACT_L = 0x20;		//!< Activity threshold (LSB)
+	static const uint8_t REG_THRESH_ACT_H = 0x21;		//!< Activity threshold (MSB)
+	static const uint8_t REG_TIME_ACT = 0x22;			//!< Activity time register
+	static const uint8_t REG_THRESH_INACT_L = 0x23;		//!< Inactivity threshold (LSB)
+	static const uint8_t REG_THRESH_INACT_H = 0x24;		//!< Inactivity threshold (MSB)
+	static const uint8_t REG_TIME_INACT_L = 0x25;		//!< Time inactivity register (LSB)
+	static const uint8_t REG_TIME_INACT_H = 0x26;		//!< Time inactivity register (MSB)
+	static const uint8_t REG_ACT_INACT_CTL = 0x27;		//!< Activity/inactivity control register
+	static const uint8_t REG_FIFO_CONTROL = 0x28;		//!< FIFO control register
+	static const uint8_t REG_FIFO_SAMPLES = 0x29;		//!< Number of samples to store in FIFO 
+	static const uint8_t REG_FIFO_INTMAP1 = 0x2a;		//!< Interrupt mapping register 1
+	static const uint8_t REG_FIFO_INTMAP2 = 0x2b;		//!< Interrupt mapping register 2
+	static const uint8_t REG_FILTER_CTL = 0x2c;			//!< Filter control register
+	static const uint8_t REG_POWER_CTL = 0x2d;			//!< Power control register
+	static const uint8_t REG_SELF_TEST = 0x2e;			//!< Self test register
+
+
+	// Status bits in status register
+	static const uint8_t STATUS_ERR_USER_REGS = 0x80;	//!< SEU error detect
+	static const uint8_t STATUS_AWAKE = 0x40;			//!< AWAKE (1) or inactive (0) state
+	static const uint8_t STATUS_INACT = 0x20;			//!< Inactivity or free fall condition
+	static const uint8_t STATUS_ACT = 0x10;				//!< Activity detected
+	static const uint8_t STATUS_FIFO_OVERRUN = 0x08;	//!< FIFO overflow
+	static const uint8_t STATUS_FIFO_WATERMARK = 0x04;	//!< FIFO reached watermark
+	static const uint8_t STATUS_FIFO_READY = 0x02;		//!< FIFO has at least one sample available
+	static const uint8_t STATUS_DATA_READ = 0x01;		//!< New sample available to read
+
+	// Activity/inactivity control register
+	static const uint8_t LINKLOOP_DEFAULT = 0x0;		//!< Activity and inactivity detection enabled
+	static const uint8_t LINKLOOP_LINKED = 0x1;			//!< Activity and inactivity sequentially linked
+	static const uint8_t LINKLOOP_LOOP = 0x3;			//!< Sequentially linked, interrupts do not need be serviced 
+
+	static const uint8_t ACTIVITY_INACT_REF = 0x08;		//!< Inactivity in referenced mode (1) or absolute mode (0)
+	static const uint8_t ACTIVITY_INACT_EN = 0x04;		//!< Inactivity enable (1)
+	static const uint8_t ACTIVITY_ACT_REF = 0x02;		//!< Activity in referenced mode (1) or absolute mode (0)
+	static const uint8_t ACTIVITY_ACT_EN = 0x01;		//!< Activity enable (1)
+
+	// Range in Filter Control Register
+	static const uint8_t RANGE_2G 	= 0x0;				//!< Range +/- 2g (default)
+	static const uint8_t RANGE_4G 	= 0x1;				//!< Range +/- 4g
+	static const uint8_t RANGE_8G 	= 0x2;				//!< Range +/- 8g
+
+	static const uint8_t HALF_BW_MASK = 0x10;			//!< Mask value for HALF_BW bit in FILTER_CTL register
+	static const uint8_t ODR_MASK = 0x07;				//!< Mask value for ODR bits in FILTER_CTL register
+
+	// Output Data Rate in Filter Control Register
+	static const uint8_t ODR_12_5 	= 0x0;				//!< Output data rate 12.5 Hz
+	static const uint8_t ODR_25 	= 0x1;				//!< Output data rate 25 Hz
+	static const uint8_t ODR_50 	= 0x2;				//!< Output data rate 50 Hz
+	static const uint8_t ODR_100 	= 0x3;				//!< Output data rate 100 Hz (default)
+	static const uint8_t ODR_200 	= 0x4;				//!< Output data rate 200 Hz
+	static const uint8_t ODR_400 	= 0x5;				//!< Output data rate 400 Hz
+
+	static const uint16_t FIFO_NUM_ENTRIES = 512;		//!< Size of the FIFO in 16-bit entries
+
+	// FIFO mode
+	static const uint8_t FIFO_DISABLED 	= 0x0;			//!< FIFO disabled (default)
+	static const uint8_t FIFO_OLDEST_SAVED = 0x1;		//!< FIFO oldest saved
+	static const uint8_t FIFO_STREAM 		= 0x2;		//!< FIFO stream mode
+	static const uint8_t FIFO_TRIGGERED 	= 0x3;		//!< FIFO triggered mode
+
+	// INTMAP1 and INTMAP2
+	static const uint8_t INTMAP_INT_LOW = 0x80;			//!< INT is active low
+	static const uint8_t INTMAP_AWAKE = 0x40;			//!< Map awake status to INT
+	static const uint8_t INTMAP_INACT = 0x20;			//!< Map inactivity status to INT
+	static const uint8_t INTMAP_ACT = 0x10;				//!< Map activity status to INT
+	static const uint8_t INTMAP_FIFO_OVERRUN = 0x08;	//!< Map FIFO overrun to INT
+	static const uint8_t INTMAP_FIFO_WATERMARK = 0x04;	//!< Map FIFO watermark to INT
+	static const uint8_t INTMAP_FIFO_READY = 0x02;		//!< Map FIFO ready to INT 
+	static const uint8_t INTMAP_DATA_READY = 0x01;		//!< Map FIFI data ready to INT
+
+	// Power Control
+	static const uint8_t POWERCTL_EXT_CLK = 0x40;		//!< Use external clock
+	static const uint8_t POWERCTL_WAKEUP = 0x08;		//!< Wakeup mode
+	static const uint8_t POWERCTL_AUTOSLEEP = 0x04;		//!< Autosleep
+
+	static const uint8_t LOWNOISE_NORMAL = 0x0;			//!< Normal operation (default)
+	static const uint8_t LOWNOISE_LOW = 0x1;			//!< Low noise mode
+	static const uint8_t LOWNOISE_ULTRALOW = 0x2;		//!< Ultra low noise mode
+
+	static const uint8_t MEASURE_STANDBY = 0x0;			//!< Standby mode
+	static const uint8_t MEASURE_MEASUREMENT = 0x2;		//!< Measurement mode
+
+	static const uint32_t RETAINED_STATE_MAGIC = 0x36a2d4e1;	//!< RetainedState magic
+	static const uint8_t RETAINED_STATE_VERSION = 1;			//!< RetainedState structure version
+	static const uint8_t RETAINED_FLAG_STORE_TEMP = 0x01;		//!< RetainedState storeTemp flag
+	static const uint8_t RETAINED_FLAG_CONFIGURED = 0x02;		//!< RetainedState chip has been configured since reset
+
+	static const int STATE_FREE = 0;			//!< ADXL362DataEx Not currently in use
+	static const int STATE_READING_FIFO = 1;	//!< ADXL362DataEx Reading FIFO by SPI DMA
+	static const int STATE_READ_COMPLETE = 2;	//!< ADXL362DataEx Reading complete
+};
+
+/**
+ * @brief Class for ADXL362 accelerometer, with the transport to the chip as a template parameter
+ *
+ * You normally use ADXL362DMA, which uses ADXL362SPITransport. The transport is resolved at compile
+ * time, so there's no indirection. Using ADXL362RecordingTransport or ADXL362ReplayTransport instead
+ * records the SPI transactions, or runs the driver against recorded transactions without the chip
+ * or the Particle SPI interface, for example to test or benchmark it on a host computer.
+ *
+ * The other classes in this library that take a driver object take an ADXL362DMA.
+ *
+ * @param Transport The transport policy, see ADXL362SPITransport
+ */
+template <class Transport>
+class ADXL362DMABasic : public ADXL362DMABase {
+public:
+	/**
+	 * @brief Initialize the ADXL362 handler object with a transport
+	 *
+	 * @param transport The transport, which is copied
 	 */
-	ADXL362DMA(SPIClass &spi, int cs = A2, SPISettings settings = SPISettings(4*MHZ, MSBFIRST, SPI_MODE0));
+	ADXL362DMABasic(const Transport &transport);
 
 	/**
 	 * @brief Normally this object is created as a global variable and never deleted
 	 */
-	virtual ~ADXL362DMA();
+	virtual ~ADXL362DMABasic();
 
 	/**
 	 * @brief Issue a soft reset call. 
@@ -189,10 +371,54 @@ public:
 	/**
 	 * @brief Reads entries from the FIFO asynchronously using SPI DMA
 	 * 
-	 * Warning: This API appears to be returning incorrect data. Use the readXYZ() instead.
+	 * @param data The buffer to read into
+	 * 
+	 * Reads FIFO_ENTRIES, then as many whole samples as are available and fit in the buffer. The
+	 * state of the buffer is STATE_READ_COMPLETE when the data is available; use readX(), readY(),
+	 * readZ(), and readT() (or readSample()) to decode the samples.
 	 */
 	void readFifoAsync(ADXL362DataBase *data);
 
+	/**
+	 * @brief Reads entries from the FIFO asynchronously using SPI DMA, without reading FIFO_ENTRIES first
+	 * 
+	 * @param data The buffer to read into
+	 * 
+	 * @param numEntries The number of 16-bit FIFO entries known to be available, for example the 
+	 * watermark after a FIFO_WATERMARK interrupt. Use getFifoSamples() to get the watermark from the
+	 * shadow registers.
+	 * 
+	 * This saves the register read SPI transaction when the number of entries is already known, such
+	 * as immediately after waking from sleep.
+	 */
+	void readFifoAsync(ADXL362DataBase *data, uint16_t numEntries);
+
+	/**
+	 * @brief Reads entries from the FIFO asynchronously using SPI DMA into a compact buffer
+	 * 
+	 * @param data The buffer to read into, see ADXL362CompactData
+	 * 
+	 * This works the same as the ADXL362DataBase version, except that the completion callback is
+	 * not called.
+	 */
+	void readFifoAsync(ADXL362CompactData *data);
+
+	/**
+	 * @brief Reads entries from the FIFO asynchronously using SPI DMA into a compact buffer, without reading FIFO_ENTRIES first
+	 * 
+	 * @param data The buffer to read into, see ADXL362CompactData
+	 * 
+	 * @param numEntries The number of 16-bit FIFO entries known to be available
+	 */
+	void readFifoAsync(ADXL362CompactData *data, uint16_t numEntries);
+
+	/**
+	 * @brief Set a function to call when readFifoAsync() completes, or nullptr to remove it
+	 * 
+	 * This is used by ADXL362Worker to hand completed buffers to a worker thread.
+	 */
+	void setCompletionCallback(CompletionCallback callback, void *context = nullptr) { completionCallback = callback; completionContext = context; };
+
 	/**
 	 * @brief Write the activity threshold register
 	 * 
@@ -519,147 +745,255 @@ public:
 	 */
 	size_t getSampleSizeInBytes() const { return storeTemp ? 8 : 6; };
 
-
 	/**
-	 * @brief Begin a synchronous SPI DMI transaction
+	 * @brief Returns the last value written to a configuration register (0x20 - 0x2E)
+	 * 
+	 * @param addr One of the register addresses from REG_THRESH_ACT_L to REG_SELF_TEST
+	 * 
+	 * The driver keeps a copy of every configuration register it writes so the configuration
+	 * can be saved with saveState() and queried without an SPI transaction. Registers not
+	 * written since softReset() return the chip reset value. Returns 0 for other addresses.
 	 */
-	void syncTransaction(void *req, void *resp, size_t len);
+	uint8_t getShadowRegister(uint8_t addr) const;
 
+	/**
+	 * @brief Returns the FIFO_SAMPLES value (0-511) from the shadow registers, including the AH bit
+	 * 
+	 * This is the FIFO watermark in 16-bit entries, not XYZ samples.
+	 */
+	uint16_t getFifoSamples() const;
 
-	// Command bytes
-	static const uint8_t CMD_WRITE_REGISTER = 0x0a; 	//!< Write register command
-	static const uint8_t CMD_READ_REGISTER = 0x0b; 		//!< Read register command
-	static const uint8_t CMD_READ_FIFO = 0x0d;			//!< Read FIFO command
+	/**
+	 * @brief Returns the output data rate in Hz from the FILTER_CTL shadow register
+	 * 
+	 * This is 12.5 to 400 and does not require an SPI transaction.
+	 */
+	float getOutputDataRate() const;
 
-	// Registers
-	static const uint8_t REG_DEVID_AD = 0x00;			//!< Device ID register (0xAD)
-	static const uint8_t REG_DEVID_MST = 0x01;			//!< MEMS device ID (0x1D)
-	static const uint8_t REG_PART_ID = 0x02;			//!< Part ID (0xF2)
-	static const uint8_t REG_SILICON_ID = 0x03;			//!< Silicon Revision ID (0x01)
-	static const uint8_t REG_XDATA_8 = 0x08;			//!< X axis data, 8 MSB only
-	static const uint8_t REG_YDATA_8 = 0x09;			//!< Y axis data, 8 MSB only
-	static const uint8_t REG_ZDATA_8 = 0x0a;			//!< Z axis data, 8 MSB only
-	static const uint8_t REG_STATUS = 0x0b;				//!< Status register
-	static const uint8_t REG_FIFO_ENTRIES_L = 0x0c;		//!< Number of FIFO entries (LSB)
-	static const uint8_t REG_FIFO_ENTRIES_H = 0x0d;		//!< Number of FIFO entries (MSB)
-	static const uint8_t REG_XDATA_L = 0x0e;			//!< X axis data (LSB)
-	static const uint8_t REG_XDATA_H = 0x0f;			//!< X axis data (MSB)
-	static const uint8_t REG_YDATA_L = 0x10;			//!< Y axis data (LSB)
-	static const uint8_t REG_YDATA_H = 0x11;			//!< Y axis data (MSB)
-	static const uint8_t REG_ZDATA_L = 0x12;			//!< Z axis data (LSB)
-	static const uint8_t REG_ZDATA_H = 0x13;			//!< Z axis data (MSB)
-	static const uint8_t REG_TDATA_L = 0x14;			//!< Temperature data (LSB)
-	static const uint8_t REG_TDATA_H = 0x15;			//!< Temperature data (MSB)
-	static const uint8_t REG_SOFT_RESET = 0x1f;			//!< Soft reset register
-	static const uint8_t REG_THRESH_ACT_L = 0x20;		//!< Activity threshold (LSB)
-	static const uint8_t REG_THRESH_ACT_H = 0x21;		//!< Activity threshold (MSB)
-	static const uint8_t REG_TIME_ACT = 0x22;			//!< Activity time register
-	static const uint8_t REG_THRESH_INACT_L = 0x23;		//!< Inactivity threshold (LSB)
-	static const uint8_t REG_THRESH_INACT_H = 0x24;		//!< Inactivity threshold (MSB)
-	static const uint8_t REG_TIME_INACT_L = 0x25;		//!< Time inactivity register (LSB)
-	static const uint8_t REG_TIME_INACT_H = 0x26;		//!< Time inactivity register (MSB)
-	static const uint8_t REG_ACT_INACT_CTL = 0x27;		//!< Activity/inactivity control register
-	static const uint8_t REG_FIFO_CONTROL = 0x28;		//!< FIFO control register
-	static const uint8_t REG_FIFO_SAMPLES = 0x29;		//!< Number of samples to store in FIFO 
-	static const uint8_t REG_FIFO_INTMAP1 = 0x2a;		//!< Interrupt mapping register 1
-	static const uint8_t REG_FIFO_INTMAP2 = 0x2b;		//!< Interrupt mapping register 2
-	static const uint8_t REG_FILTER_CTL = 0x2c;			//!< Filter control register
-	static const uint8_t REG_POWER_CTL = 0x2d;			//!< Power control register
-	static const uint8_t REG_SELF_TEST = 0x2e;			//!< Self test register
+	/**
+	 * @brief Returns the range in g (2, 4, or 8) as set by writeFilterControl()
+	 */
+	uint8_t getRangeG() const { return rangeG; };
 
+	/**
+	 * @brief Returns whether the FIFO stores temperature (XYZT) in addition to XYZ
+	 */
+	bool getStoreTemp() const { return storeTemp; };
 
-	// Status bits in status register
-	static const uint8_t STATUS_ERR_USER_REGS = 0x80;	//!< SEU error detect
-	static const uint8_t STATUS_AWAKE = 0x40;			//!< AWAKE (1) or inactive (0) state
-	static const uint8_t STATUS_INACT = 0x20;			//!< Inactivity or free fall condition
-	static const uint8_t STATUS_ACT = 0x10;				//!< Activity detected
-	static const uint8_t STATUS_FIFO_OVERRUN = 0x08;	//!< FIFO overflow
-	static const uint8_t STATUS_FIFO_WATERMARK = 0x04;	//!< FIFO reached watermark
-	static const uint8_t STATUS_FIFO_READY = 0x02;		//!< FIFO has at least one sample available
-	static const uint8_t STATUS_DATA_READ = 0x01;		//!< New sample available to read
+	/**
+	 * @brief Save the complete driver state, typically into a retained variable before sleep
+	 * 
+	 * @param state The state object to fill in
+	 * 
+	 * Do not call this while a readFifoAsync() is in progress.
+	 */
+	void saveState(RetainedState &state) const;
 
-	// Activity/inactivity control register
-	static const uint8_t LINKLOOP_DEFAULT = 0x0;		//!< Activity and inactivity detection enabled
-	static const uint8_t LINKLOOP_LINKED = 0x1;			//!< Activity and inactivity sequentially linked
-	static const uint8_t LINKLOOP_LOOP = 0x3;			//!< Sequentially linked, interrupts do not need be serviced 
+	/**
+	 * @brief Restore the driver state saved using saveState(), typically after waking from sleep
+	 * 
+	 * @param state The state object previously filled in by saveState()
+	 * 
+	 * @return true if the state was valid and restored, false if not (for example, after a cold boot
+	 * when retained memory is not initialized). If false, the driver state is not modified and the
+	 * chip should be reset and configured normally.
+	 * 
+	 * This does not access the SPI bus.
+	 */
+	bool restoreState(const RetainedState &state);
 
-	static const uint8_t ACTIVITY_INACT_REF = 0x08;		//!< Inactivity in referenced mode (1) or absolute mode (0)
-	static const uint8_t ACTIVITY_INACT_EN = 0x04;		//!< Inactivity enable (1)
-	static const uint8_t ACTIVITY_ACT_REF = 0x02;		//!< Activity in referenced mode (1) or absolute mode (0)
-	static const uint8_t ACTIVITY_ACT_EN = 0x01;		//!< Activity enable (1)
+	/**
+	 * @brief Invalidate a saved state so the next restoreState() will fail
+	 * 
+	 * @param state The state object to invalidate
+	 * 
+	 * Call this if the ADXL362 loses power, for example.
+	 */
+	static void invalidateState(RetainedState &state);
 
-	// Range in Filter Control Register
-	static const uint8_t RANGE_2G 	= 0x0;				//!< Range +/- 2g (default)
-	static const uint8_t RANGE_4G 	= 0x1;				//!< Range +/- 4g
-	static const uint8_t RANGE_8G 	= 0x2;				//!< Range +/- 8g
+	/**
+	 * @brief Returns the number of complete samples read from the FIFO since softReset()
+	 * 
+	 * This is preserved across sleep using saveState() and restoreState().
+	 */
+	uint32_t getSamplesRead() const { return samplesRead; };
 
-	static const uint8_t HALF_BW_MASK = 0x10;			//!< Mask value for HALF_BW bit in FILTER_CTL register
-	static const uint8_t ODR_MASK = 0x07;				//!< Mask value for ODR bits in FILTER_CTL register
 
-	// Output Data Rate in Filter Control Register
-	static const uint8_t ODR_12_5 	= 0x0;				//!< Output data rate 12.5 Hz
-	static const uint8_t ODR_25 	= 0x1;				//!< Output data rate 25 Hz
-	static const uint8_t ODR_50 	= 0x2;				//!< Output data rate 50 Hz
-	static const uint8_t ODR_100 	= 0x3;				//!< Output data rate 100 Hz (default)
-	static const uint8_t ODR_200 	= 0x4;				//!< Output data rate 200 Hz
-	static const uint8_t ODR_400 	= 0x5;				//!< Output data rate 400 Hz
+	/**
+	 * @brief Begin a synchronous SPI DMI transaction
+	 */
+	void syncTransaction(void *req, void *resp, size_t len);
 
-	// FIFO mode
-	static const uint8_t FIFO_DISABLED 	= 0x0;			//!< FIFO disabled (default)
-	static const uint8_t FIFO_OLDEST_SAVED = 0x1;		//!< FIFO oldest saved
-	static const uint8_t FIFO_STREAM 		= 0x2;		//!< FIFO stream mode
-	static const uint8_t FIFO_TRIGGERED 	= 0x3;		//!< FIFO triggered mode
+	/**
+	 * @brief Returns the number of SPI transactions (CS assertions) since the last resetTransactionStats()
+	 * 
+	 * This can be compared with the ADXL362PowerModel estimate to validate it.
+	 */
+	uint32_t getTransactionCount() const { return transactionCount; };
 
-	// INTMAP1 and INTMAP2
-	static const uint8_t INTMAP_INT_LOW = 0x80;			//!< INT is active low
-	static const uint8_t INTMAP_AWAKE = 0x40;			//!< Map awake status to INT
-	static const uint8_t INTMAP_INACT = 0x20;			//!< Map inactivity status to INT
-	static const uint8_t INTMAP_ACT = 0x10;				//!< Map activity status to INT
-	static const uint8_t INTMAP_FIFO_OVERRUN = 0x08;	//!< Map FIFO overrun to INT
-	static const uint8_t INTMAP_FIFO_WATERMARK = 0x04;	//!< Map FIFO watermark to INT
-	static const uint8_t INTMAP_FIFO_READY = 0x02;		//!< Map FIFO ready to INT 
-	static const uint8_t INTMAP_DATA_READY = 0x01;		//!< Map FIFI data ready to INT
+	/**
+	 * @brief Returns the number of bytes transferred on the SPI bus since the last resetTransactionStats()
+	 * 
+	 * Includes the command and address bytes.
+	 */
+	uint32_t getTransactionBytes() const { return transactionBytes; };
 
-	// Power Control
-	static const uint8_t POWERCTL_EXT_CLK = 0x40;		//!< Use external clock
-	static const uint8_t POWERCTL_WAKEUP = 0x08;		//!< Wakeup mode
-	static const uint8_t POWERCTL_AUTOSLEEP = 0x04;		//!< Autosleep
+	/**
+	 * @brief Clear the transaction counters
+	 */
+	void resetTransactionStats() { transactionCount = transactionBytes = 0; };
 
-	static const uint8_t LOWNOISE_NORMAL = 0x0;			//!< Normal operation (default)
-	static const uint8_t LOWNOISE_LOW = 0x1;			//!< Low noise mode
-	static const uint8_t LOWNOISE_ULTRALOW = 0x2;		//!< Ultra low noise mode
+	/**
+	 * @brief Returns the number of FIFO reads that did not start at a sample boundary since softReset()
+	 * 
+	 * Entries before the first complete sample, and the partial sample from the previous read if
+	 * the FIFO may have overflowed, are discarded, so each of these is a gap in the data. This
+	 * normally only happens when the FIFO overflows.
+	 */
+	uint32_t getRealignCount() const { return realignCount; };
 
-	static const uint8_t MEASURE_STANDBY = 0x0;			//!< Standby mode
-	static const uint8_t MEASURE_MEASUREMENT = 0x2;		//!< Measurement mode
+	/**
+	 * @brief Returns the transport, for example to get the log from ADXL362RecordingTransport
+	 */
+	Transport &getTransport() { return transport; };
 
-	static const int STATE_FREE = 0;			//!< ADXL362DataEx Not currently in use
-	static const int STATE_READING_FIFO = 1;	//!< ADXL362DataEx Reading FIFO by SPI DMA
-	static const int STATE_READ_COMPLETE = 2;	//!< ADXL362DataEx Reading complete
+	/**
+	 * @brief Record timestamped SPI bus events, see ADXL362BusRecorder
+	 *
+	 * @param recorder The recorder, or NULL to stop recording. Several objects can share one recorder.
+	 *
+	 * @param context Stored in each event, to tell the devices sharing a recorder apart
+	 */
+	void setBusRecorder(ADXL362BusRecorderBase *recorder, uint8_t context = 0) { busRecorder = recorder; busContext = context; };
 
 private:
 	/**
-	 * @brief Called before any SPI transaction. Calls spi.beginTransaction() and clears the CS pin.
+	 * @brief Called before any SPI transaction. Calls transport.begin() the first time, then
+	 * transport.beginTransaction(), which clears the CS pin.
+	 *
+	 * The command, register, and length are only used for the bus recorder.
 	 */
-	void beginTransaction();
+	void beginTransaction(uint8_t cmd, uint8_t reg, size_t len);
 
 	/**
-	 * @brief Called after any SPI transaction. Calls spi.endTransaction() and sets the CS pin high.
+	 * @brief Called after any SPI transaction. Calls transport.endTransaction(), which sets the CS pin high.
 	 */
 	void endTransaction();
 
 	static void readFifoCallbackInternal(void);
 
+	/**
+	 * @brief Returns the number of bytes to read from the FIFO so the buffer, including the partial sample
+	 * from the previous read, holds a whole number of samples
+	 */
+	size_t fifoReadSize(uint16_t numEntries, size_t bufSize) const;
+
+	/**
+	 * @brief Discard the partial sample from the previous read if the FIFO may have overflowed since then
+	 * 
+	 * In FIFO_STREAM and FIFO_TRIGGERED mode, a full FIFO discards the oldest entries, which are the
+	 * rest of the partial sample.
+	 * 
+	 * @param numEntries The number of entries in the FIFO
+	 */
+	void checkFifoOverflow(uint16_t numEntries);
+
+	/**
+	 * @brief Copy the partial sample into buf and start the DMA read after it
+	 */
+	void startFifoRead(uint8_t *buf, size_t bytesToRead);
+
+	/**
+	 * @brief Realign a completed buffer and save the partial sample at the end for the next read
+	 */
 	void cleanBuffer(ADXL362DataBase *data);
 
-	SPIClass &spi; //!< SPI interface, typically SPI or SPI1
-	int cs;		//!<  CS chip select pin. Default: A2
-	SPISettings settings; //!<  SPI settings (mode, bit order, speed)
+	/**
+	 * @brief Realign a completed compact buffer and save the partial sample at the end for the next read
+	 */
+	void cleanBuffer(ADXL362CompactData *data);
+
+	/**
+	 * @brief Find the first complete sample and save the partial sample at the end for the next read
+	 * 
+	 * The first sample is the first X entry followed by Y and Z (and temperature) entries. Checking
+	 * the whole sample, not just the X entry, detects a partial sample from the previous read
+	 * that no longer matches the FIFO, for example because the FIFO overflowed in stream mode.
+	 * 
+	 * @param buf The buffer
+	 * 
+	 * @param bytesRead Number of bytes in buf, including the partial sample from the previous read
+	 * 
+	 * @param sampleSize Sample size in bytes (6 or 8)
+	 * 
+	 * @param startOffset Filled in with the offset of the first X value
+	 * 
+	 * @return The number of complete samples
+	 */
+	size_t cleanBuffer(const uint8_t *buf, size_t bytesRead, size_t sampleSize, size_t &startOffset);
+
+	/**
+	 * @brief Set the shadow registers to the chip reset values
+	 */
+	void resetShadowRegisters();
+
+	/**
+	 * @brief Update the shadow copy of a register after it has been written
+	 */
+	void updateShadowRegister(uint8_t addr, uint8_t value);
+
+	static const uint8_t SHADOW_REG_FIRST = 0x20;	//!< First shadowed register (REG_THRESH_ACT_L)
+	static const size_t NUM_SHADOW_REGS = 15;		//!< Number of shadowed registers (0x20 - 0x2E)
+
+	Transport transport; //!< Transport to the chip, typically ADXL362SPITransport
 	bool storeTemp = false; //!< Whether to store temperature 
 	uint8_t rangeG = 2;
 	uint8_t partialSampleBytes[8]; //!< Samples if DMA buffer gets out of alignment
 	size_t  partialSampleBytesCount = 0;
 	bool initialized = false; //!< Set to true after SPI initialization has occurred
+	bool configured = false; //!< Set to true after a configuration register has been written
+	uint8_t shadowRegs[NUM_SHADOW_REGS]; //!< Last value written to registers 0x20 - 0x2E
+	uint32_t samplesRead = 0; //!< Number of complete samples read from the FIFO
+	uint32_t transactionCount = 0; //!< Number of SPI transactions
+	uint32_t transactionBytes = 0; //!< Number of bytes transferred by SPI
+	uint32_t realignCount = 0; //!< Number of FIFO reads that skipped entries to find a sample
+	CompletionCallback completionCallback = nullptr; //!< Called when readFifoAsync() completes
+	void *completionContext = nullptr; //!< Passed to completionCallback
+	ADXL362BusRecorderBase *busRecorder = nullptr; //!< Records bus events, if not NULL
+	uint8_t busContext = 0; //!< Context for busRecorder events
+
+	static ADXL362DMABasic *readFifoObject; //!< Object reading the FIFO, for readFifoCallbackInternal()
+	static ADXL362DataBase *readFifoData; //!< Buffer being read, or NULL if readFifoCompactData
+	static ADXL362CompactData *readFifoCompactData; //!< Compact buffer being read, or NULL if readFifoData
+};
+
+// The code is in ADXL362DMA.cpp, which instantiates these
+extern template class ADXL362DMABasic<ADXL362SPITransport>;
+extern template class ADXL362DMABasic<ADXL362RecordingTransport<ADXL362SPITransport>>;
+extern template class ADXL362DMABasic<ADXL362ReplayTransport>;
 
+/**
+ * @brief Class for ADXL362 accelerometer, connected by SPI
+ */
+class ADXL362DMA : public ADXL362DMABasic<ADXL362SPITransport> {
+public:
+	/**
+	 * @brief Initialize the ADXL362 handler object. 
+	 * 
+	 * @param spi The SPI interface, could be `SPI` or `SPI1`
+	 * @param cs The chip select pin to use
+	 * @param settings (optional) SPISettings to set the data rate, etc.
+	 * 
+	 * Usually created as  global variable like this:
+	 *
+	 * ADXL362 accel(SPI, A2);
+	 * 
+	 * You can have generally have multiple devices on a single SPI bus, but each SPI device must
+	 * have its own CS (chip select) pin. 
+	 * 
+	 * SPI speed can be from 1 MHz to 8 MHz.
+	 */
+	ADXL362DMA(SPIClass &spi, int cs = A2, SPISettings settings = SPISettings(4*MHZ, MSBFIRST, SPI_MODE0)) : ADXL362DMABasic(ADXL362SPITransport(spi, cs, settings)) {};
 };
 
 
@@ -718,6 +1052,17 @@ public:
 	 */
 	int16_t readT(size_t index) const;
 
+	/**
+	 * @brief Read a whole sample out of the buffer
+	 * 
+	 * @param index The index to read from 0 = first instead
+	 * 
+	 * @param sample Filled in with the X, Y, Z, and T (if stored, otherwise 0) values
+	 * 
+	 * This is more efficient than calling readX(), readY(), and readZ() separately.
+	 */
+	void readSample(size_t index, ADXL362Sample &sample) const;
+
 	/**
 	 * @brief Read an signed 14-bit value out of the buffer
 	 * 
@@ -725,7 +1070,146 @@ public:
 	 * 
 	 * @return int16_t 
 	 */
-	int16_t readSigned14(const uint8_t *pValue) const;
+	int16_t readSigned14(const uint8_t *pValue) const { return decodeSigned14(pValue); };
+
+	/**
+	 * @brief Decode a signed 14-bit value from two bytes from the FIFO
+	 * 
+	 * The FIFO returns the least significant byte first. Bits 15:14 of the entry are the axis,
+	 * so the value is in the low 14 bits.
+	 * 
+	 * This is inline so loops over samples (including the iterators) can be optimized.
+	 */
+	static inline int16_t decodeSigned14(const uint8_t *pValue) {
+		uint8_t msb = pValue[1] & 0x3f;
+		if (msb & 0x20) {
+			// Add in sign extension
+			msb |= 0xc0;
+		}
+
+		return (int16_t)(pValue[0] | (msb << 8));
+	}
+
+	/**
+	 * @brief Returns the axis of a FIFO entry (0 = X, 1 = Y, 2 = Z, 3 = temperature)
+	 * 
+	 * @param pValue The pointer to the first of two bytes from the FIFO 
+	 */
+	static inline uint8_t decodeAxis(const uint8_t *pValue) {
+		return (pValue[1] >> 6) & 0x3;
+	}
+
+	/**
+	 * @brief Decode a whole sample from the FIFO bytes
+	 * 
+	 * @param p Pointer to the X value of the sample
+	 * 
+	 * @param storeTemp true if the sample includes temperature
+	 * 
+	 * @param sample Filled in with the decoded sample
+	 */
+	static inline void decodeSample(const uint8_t *p, bool storeTemp, ADXL362Sample &sample) {
+		sample.x = decodeSigned14(&p[0]);
+		sample.y = decodeSigned14(&p[2]);
+		sample.z = decodeSigned14(&p[4]);
+		sample.t = storeTemp ? decodeSigned14(&p[6]) : 0;
+	}
+
+	/**
+	 * @brief Random-access iterator over the decoded samples in the buffer
+	 * 
+	 * Dereferencing returns an ADXL362Sample by value, decoded from the buffer. This allows 
+	 * standard algorithms such as std::transform, std::accumulate, and std::max_element to be
+	 * used directly on a buffer:
+	 * 
+	 * ```
+	 * int32_t sumX = std::accumulate(data.begin(), data.end(), 0, [](int32_t sum, const ADXL362Sample &s) { return sum + s.x; });
+	 * ```
+	 */
+	class const_iterator {
+	public:
+		typedef std::random_access_iterator_tag iterator_category; //!< Random access
+		typedef ADXL362Sample value_type; //!< Decoded sample
+		typedef ptrdiff_t difference_type; //!< Distance between iterators in samples
+		typedef const ADXL362Sample *pointer; //!< Not used, samples are returned by value
+		typedef ADXL362Sample reference; //!< Samples are returned by value
+
+		/**
+		 * @brief Construct an empty iterator
+		 */
+		const_iterator() {};
+
+		/**
+		 * @brief Construct an iterator
+		 * 
+		 * @param p Pointer to the X value of a sample
+		 * 
+		 * @param stride Sample size in bytes (6 or 8)
+		 * 
+		 * @param storeTemp Whether the samples include temperature
+		 */
+		const_iterator(const uint8_t *p, size_t stride, bool storeTemp) : p(p), stride(stride), storeTemp(storeTemp) {};
+
+		ADXL362Sample operator*() const { ADXL362Sample sample; decodeSample(p, storeTemp, sample); return sample; }; //!< Decode the sample
+		ADXL362Sample operator[](difference_type n) const { return *(*this + n); }; //!< Decode the sample n samples away
+
+		const_iterator &operator++() { p += stride; return *this; }; //!< Next sample
+		const_iterator operator++(int) { const_iterator tmp = *this; p += stride; return tmp; }; //!< Next sample
+		const_iterator &operator--() { p -= stride; return *this; }; //!< Previous sample
+		const_iterator operator--(int) { const_iterator tmp = *this; p -= stride; return tmp; }; //!< Previous sample
+		const_iterator &operator+=(difference_type n) { p += n * (difference_type)stride; return *this; }; //!< Move forward n samples
+		const_iterator &operator-=(difference_type n) { p -= n * (difference_type)stride; return *this; }; //!< Move back n samples
+		const_iterator operator+(difference_type n) const { const_iterator tmp = *this; return tmp += n; }; //!< n samples forward
+		const_iterator operator-(difference_type n) const { const_iterator tmp = *this; return tmp -= n; }; //!< n samples back
+		friend const_iterator operator+(difference_type n, const const_iterator &it) { return it + n; }; //!< n samples forward
+		difference_type operator-(const const_iterator &other) const { return (p - other.p) / (difference_type)stride; }; //!< Distance in samples
+
+		bool operator==(const const_iterator &other) const { return p == other.p; }; //!< Same position
+		bool operator!=(const const_iterator &other) const { return p != other.p; }; //!< Different position
+		bool operator<(const const_iterator &other) const { return p < other.p; }; //!< Earlier position
+		bool operator>(const const_iterator &other) const { return p > other.p; }; //!< Later position
+		bool operator<=(const const_iterator &other) const { return p <= other.p; }; //!< Earlier or same position
+		bool operator>=(const const_iterator &other) const { return p >= other.p; }; //!< Later or same position
+
+	protected:
+		const uint8_t *p = nullptr; //!< X value of the current sample
+		size_t stride = 6; //!< Sample size in bytes
+		bool storeTemp = false; //!< Samples include temperature
+	};
+
+	/**
+	 * @brief Iterator to the first sample in the buffer. Only valid in STATE_READ_COMPLETE.
+	 */
+	const_iterator begin() const { return const_iterator(&buf[startOffset], sampleSizeInBytes, storeTemp); };
+
+	/**
+	 * @brief Iterator past the last sample in the buffer
+	 */
+	const_iterator end() const { return const_iterator(&buf[startOffset + numSamplesRead * sampleSizeInBytes], sampleSizeInBytes, storeTemp); };
+
+	/**
+	 * @brief Number of samples in the buffer, the same as numSamplesRead
+	 */
+	size_t size() const { return numSamplesRead; };
+
+#ifdef ADXL362_HAS_SPAN
+	/**
+	 * @brief The raw FIFO bytes of the complete samples, starting with the first X value
+	 * 
+	 * Only available when compiling with C++20. Each entry is two bytes: 2 bits of axis type, 
+	 * 2 bits of sign extension, and 12 bits of data.
+	 */
+	std::span<const uint8_t> rawBytes() const { return std::span<const uint8_t>(&buf[startOffset], numSamplesRead * sampleSizeInBytes); };
+
+	/**
+	 * @brief The raw FIFO entries of the complete samples as 16-bit words, starting with the first X value
+	 * 
+	 * Only available when compiling with C++20. The FIFO sends the least significant byte first, so on
+	 * a little endian processor each word is one FIFO entry. buf must be 2-byte aligned, which is the
+	 * case for ADXL362DataEx.
+	 */
+	std::span<const uint16_t> rawWords() const { return std::span<const uint16_t>(reinterpret_cast<const uint16_t *>(&buf[startOffset]), numSamplesRead * sampleSizeInBytes / 2); };
+#endif
 
 
 	/**
@@ -797,7 +1281,7 @@ public:
 	 * 
 	 * The getEntrySize() method will return either 6 (without temperature) or 8 (with temperature)
 	 */
-	uint8_t staticBuf[BUF_SIZE];
+	alignas(4) uint8_t staticBuf[BUF_SIZE];
 
 
 };
@@ -0,0 +1,179 @@
+#include "Particle.h"
+
+#include "ADXL362Dsp.h"
+
+#include <math.h>
+
+// Fixed-point signal processing helpers for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+ADXL362Biquad::ADXL362Biquad() {
+	setCoefficients(1L << COEF_SHIFT, 0, 0, 0, 0);
+}
+
+void ADXL362Biquad::setBandPass(float sampleRate, float centerFreq, float q) {
+	float w0 = 2.0 * M_PI * centerFreq / sampleRate;
+	float alpha = sinf(w0) / (2.0 * q);
+
+	setFloatCoefficients(alpha, 0, -alpha, 1.0 + alpha, -2.0 * cosf(w0), 1.0 - alpha);
+}
+
+void ADXL362Biquad::setLowPass(float sampleRate, float cutoffFreq, float q) {
+	float w0 = 2.0 * M_PI * cutoffFreq / sampleRate;
+	float alpha = sinf(w0) / (2.0 * q);
+	float cosw0 = cosf(w0);
+
+	setFloatCoefficients((1.0 - cosw0) / 2.0, 1.0 - cosw0, (1.0 - cosw0) / 2.0, 1.0 + alpha, -2.0 * cosw0, 1.0 - alpha);
+}
+
+void ADXL362Biquad::setHighPass(float sampleRate, float cutoffFreq, float q) {
+	float w0 = 2.0 * M_PI * cutoffFreq / sampleRate;
+	float alpha = sinf(w0) / (2.0 * q);
+	float cosw0 = cosf(w0);
+
+	setFloatCoefficients((1.0 + cosw0) / 2.0, -(1.0 + cosw0), (1.0 + cosw0) / 2.0, 1.0 + alpha, -2.0 * cosw0, 1.0 - alpha);
+}
+
+void ADXL362Biquad::setCoefficients(int32_t b0, int32_t b1, int32_t b2, int32_t a1, int32_t a2) {
+	this->b0 = b0;
+	this->b1 = b1;
+	this->b2 = b2;
+	this->a1 = a1;
+	this->a2 = a2;
+	reset();
+}
+
+void ADXL362Biquad::prime(int32_t x) {
+	// DC gain is (b0 + b1 + b2) / (1 + a1 + a2)
+	int64_t num = (int64_t)b0 + b1 + b2;
+	int64_t den = (1LL << COEF_SHIFT) + a1 + a2;
+
+	x1 = x2 = x;
+	y1 = y2 = (den != 0) ? (int32_t)((num * x) / den) : 0;
+}
+
+void ADXL362Biquad::setFloatCoefficients(float b0, float b1, float b2, float a0, float a1, float a2) {
+	const double scale = (double)(1L << COEF_SHIFT);
+
+	setCoefficients(
+		(int32_t) lround((double)(b0 / a0) * scale),
+		(int32_t) lround((double)(b1 / a0) * scale),
+		(int32_t) lround((double)(b2 / a0) * scale),
+		(int32_t) lround((double)(a1 / a0) * scale),
+		(int32_t) lround((double)(a2 / a0) * scale));
+}
+
+// [static]
+uint16_t ADXL362Dsp::isqrt(uint32_t value) {
+	uint32_t result = 0;
+	uint32_t bit = 1UL << 30;
+
+	while(bit > value) {
+		bit >>= 2;
+	}
+	while(bit != 0) {
+		if (value >= result + bit) {
+			value -= result + bit;
+			result = (result >> 1) + bit;
+		}
+		else {
+			result >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint16_t) result;
+}
+
+// [static]
+uint32_t ADXL362Dsp::isqrt64(uint64_t value) {
+	uint64_t result = 0;
+	uint64_t bit = 1ULL << 62;
+
+	while(bit > value) {
+		bit >>= 2;
+	}
+	while(bit != 0) {
+		if (value >= result + bit) {
+			value -= result + bit;
+			result = (result >> 1) + bit;
+		}
+		else {
+			result >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t) result;
+}
+
+// [static]
+int32_t ADXL362Dsp::axisValue(const ADXL362Sample &sample, Axis axis) {
+	switch(axis) {
+		case Axis::X:
+			return sample.x;
+
+		case Axis::Y:
+			return sample.y;
+
+		case Axis::Z:
+			return sample.z;
+
+		default:
+		case Axis::MAGNITUDE:
+			return isqrt(magnitudeSq(sample.x, sample.y, sample.z));
+	}
+}
+
+// [static]
+void ADXL362Dsp::fftTables(int16_t *cosTable, int16_t *sinTable, size_t n) {
+	for(size_t ii = 0; ii < n / 2; ii++) {
+		double angle = 2.0 * M_PI * (double)ii / (double)n;
+		cosTable[ii] = (int16_t) lround(cos(angle) * 32767.0);
+		sinTable[ii] = (int16_t) lround(sin(angle) * 32767.0);
+	}
+}
+
+// [static]
+void ADXL362Dsp::fft(int32_t *re, int32_t *im, size_t n, const int16_t *cosTable, const int16_t *sinTable) {
+	// Bit reversal permutation
+	for(size_t ii = 1, jj = 0; ii < n; ii++) {
+		size_t bit = n >> 1;
+		for(; jj & bit; bit >>= 1) {
+			jj ^= bit;
+		}
+		jj ^= bit;
+		if (ii < jj) {
+			int32_t temp = re[ii];
+			re[ii] = re[jj];
+			re[jj] = temp;
+			temp = im[ii];
+			im[ii] = im[jj];
+			im[jj] = temp;
+		}
+	}
+
+	// Butterflies, scaled by 1/2 each stage
+	for(size_t len = 2; len <= n; len <<= 1) {
+		size_t half = len / 2;
+		size_t step = n / len;
+		for(size_t ii = 0; ii < n; ii += len) {
+			for(size_t kk = 0; kk < half; kk++) {
+				int32_t wr = cosTable[kk * step];
+				int32_t wi = -sinTable[kk * step];
+
+				int32_t *pr = &re[ii + kk + half];
+				int32_t *pi = &im[ii + kk + half];
+
+				int32_t vr = (int32_t)(((int64_t)*pr * wr - (int64_t)*pi * wi) >> 15);
+				int32_t vi = (int32_t)(((int64_t)*pr * wi + (int64_t)*pi * wr) >> 15);
+
+				int32_t ur = re[ii + kk];
+				int32_t ui = im[ii + kk];
+
+				re[ii + kk] = (ur + vr) >> 1;
+				im[ii + kk] = (ui + vi) >> 1;
+				*pr = (ur - vr) >> 1;
+				*pi = (ui - vi) >> 1;
+			}
+		}
+	}
+}
@@ -0,0 +1,175 @@
+#ifndef __ADXL362DSP_H
+#define __ADXL362DSP_H
+
+// Fixed-point signal processing helpers for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+
+/**
+ * @brief Fixed-point biquad (second-order IIR) filter
+ *
+ * Coefficients are calculated using floating point when the filter is configured, using the
+ * RBJ Audio EQ Cookbook formulas, and stored as Q28 fixed point. Filtering a sample uses only
+ * integer math with a 64-bit accumulator, so it is fast and deterministic on the nRF52 and RTL872x.
+ * The Q28 coefficients keep low cutoff frequencies (relative to the sample rate) stable.
+ *
+ * The state is carried between calls to process(), so filtering continues correctly across
+ * FIFO buffers.
+ */
+class ADXL362Biquad {
+public:
+	/**
+	 * @brief Constructor. The filter passes samples through unchanged until configured.
+	 */
+	ADXL362Biquad();
+
+	/**
+	 * @brief Configure as a band-pass filter (constant 0 dB peak gain)
+	 *
+	 * @param sampleRate Sample rate in Hz
+	 * @param centerFreq Center frequency in Hz
+	 * @param q Quality factor. Higher values are narrower.
+	 */
+	void setBandPass(float sampleRate, float centerFreq, float q);
+
+	/**
+	 * @brief Configure as a low-pass filter
+	 *
+	 * @param sampleRate Sample rate in Hz
+	 * @param cutoffFreq Cutoff frequency in Hz
+	 * @param q Quality factor (default: 0.7071, Butterworth)
+	 */
+	void setLowPass(float sampleRate, float cutoffFreq, float q = 0.7071);
+
+	/**
+	 * @brief Configure as a high-pass filter
+	 *
+	 * @param sampleRate Sample rate in Hz
+	 * @param cutoffFreq Cutoff frequency in Hz
+	 * @param q Quality factor (default: 0.7071, Butterworth)
+	 */
+	void setHighPass(float sampleRate, float cutoffFreq, float q = 0.7071);
+
+	/**
+	 * @brief Set the Q28 coefficients directly, normalized so a0 = 1
+	 */
+	void setCoefficients(int32_t b0, int32_t b1, int32_t b2, int32_t a1, int32_t a2);
+
+	/**
+	 * @brief Clear the filter state (previous inputs and outputs)
+	 */
+	void reset() { x1 = x2 = y1 = y2 = 0; };
+
+	/**
+	 * @brief Set the filter state as if the input had been a constant value forever
+	 *
+	 * @param x The input value, such as the first sample. This avoids the transient when filtering a
+	 * signal with a large DC offset, such as gravity.
+	 */
+	void prime(int32_t x);
+
+	/**
+	 * @brief Filter one sample
+	 *
+	 * @param x Input sample. Scale the input up (for example, counts << 4) to retain precision.
+	 *
+	 * @return Filtered sample, in the same units as the input
+	 */
+	inline int32_t process(int32_t x) {
+		int64_t acc = (int64_t)b0 * x + (int64_t)b1 * x1 + (int64_t)b2 * x2 - (int64_t)a1 * y1 - (int64_t)a2 * y2;
+		// Round rather than truncate; the truncation bias is amplified by the feedback terms
+		int32_t y = (int32_t)((acc + ((int64_t)1 << (COEF_SHIFT - 1))) >> COEF_SHIFT);
+		x2 = x1;
+		x1 = x;
+		y2 = y1;
+		y1 = y;
+		return y;
+	}
+
+	static const int COEF_SHIFT = 28; //!< Coefficients are Q28
+
+protected:
+	/**
+	 * @brief Normalize floating point coefficients by a0 and convert to Q28
+	 */
+	void setFloatCoefficients(float b0, float b1, float b2, float a0, float a1, float a2);
+
+	int32_t b0, b1, b2, a1, a2; //!< Q28 coefficients
+	int32_t x1 = 0, x2 = 0, y1 = 0, y2 = 0; //!< Filter state
+};
+
+/**
+ * @brief Fixed-point helper functions
+ */
+class ADXL362Dsp {
+public:
+	/**
+	 * @brief Which signal to analyze
+	 */
+	enum class Axis {
+		X,					//!< X axis
+		Y,					//!< Y axis
+		Z,					//!< Z axis
+		MAGNITUDE			//!< Magnitude of XYZ (orientation independent)
+	};
+
+	/**
+	 * @brief Returns the value of one axis, or the magnitude, of a sample in counts
+	 */
+	static int32_t axisValue(const ADXL362Sample &sample, Axis axis);
+
+	/**
+	 * @brief Fill in the twiddle factor tables for fft()
+	 *
+	 * @param cosTable Filled in with n / 2 cosine values in Q15
+	 * @param sinTable Filled in with n / 2 sine values in Q15
+	 * @param n FFT size, a power of 2
+	 */
+	static void fftTables(int16_t *cosTable, int16_t *sinTable, size_t n);
+
+	/**
+	 * @brief In-place fixed-point radix-2 FFT
+	 *
+	 * @param re Real parts, n values
+	 * @param im Imaginary parts, n values
+	 * @param n FFT size, a power of 2
+	 * @param cosTable Cosine table from fftTables()
+	 * @param sinTable Sine table from fftTables()
+	 *
+	 * Each stage is scaled by 1/2 to prevent overflow, so the result is the DFT divided by n. For a
+	 * sine wave of amplitude A in the input, the magnitude of its bin is A / 2.
+	 */
+	static void fft(int32_t *re, int32_t *im, size_t n, const int16_t *cosTable, const int16_t *sinTable);
+
+	/**
+	 * @brief Integer square root (floor)
+	 */
+	static uint16_t isqrt(uint32_t value);
+
+	/**
+	 * @brief Integer square root (floor) of a 64-bit value
+	 */
+	static uint32_t isqrt64(uint64_t value);
+
+	/**
+	 * @brief Returns the squared magnitude of an XYZ sample in counts squared
+	 */
+	static inline uint32_t magnitudeSq(int32_t x, int32_t y, int32_t z) {
+		return (uint32_t)(x * x) + (uint32_t)(y * y) + (uint32_t)(z * z);
+	}
+
+	/**
+	 * @brief Returns the number of milli-g per count for a range
+	 *
+	 * @param rangeG 2, 4, or 8, as returned by ADXL362DMA::getRangeG()
+	 *
+	 * From the datasheet, the sensitivity is 1 mg/LSB at +/- 2g, 2 mg/LSB at +/- 4g, and 4 mg/LSB at +/- 8g.
+	 */
+	static inline int32_t mgPerCount(uint8_t rangeG) {
+		return (rangeG >= 2) ? (rangeG / 2) : 1;
+	}
+};
+
+#endif /* __ADXL362DSP_H */
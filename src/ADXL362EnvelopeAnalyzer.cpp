@@ -0,0 +1,111 @@
+#include "Particle.h"
+
+#include "ADXL362EnvelopeAnalyzer.h"
+
+#include <math.h>
+
+// Envelope (demodulation) analysis for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+ADXL362EnvelopeAnalyzerBase::ADXL362EnvelopeAnalyzerBase(const Buffers &buffers, size_t fftSize) : buffers(buffers), fftSize(fftSize) {
+}
+
+ADXL362EnvelopeAnalyzerBase::~ADXL362EnvelopeAnalyzerBase() {
+}
+
+void ADXL362EnvelopeAnalyzerBase::begin(float sampleRate, float bandCenter, float bandQ, uint16_t decimation, ADXL362Dsp::Axis axis) {
+	this->decimation = (decimation > 0) ? decimation : 1;
+	this->axis = axis;
+	envelopeRate = sampleRate / (float)this->decimation;
+
+	bandPass.setBandPass(sampleRate, bandCenter, bandQ);
+
+	// Anti-alias filter for decimation, below the Nyquist frequency of the envelope
+	lowPass.setLowPass(sampleRate, envelopeRate * 0.4);
+
+	ADXL362Dsp::fftTables(buffers.cosTable, buffers.sinTable, fftSize);
+	for(size_t ii = 0; ii < fftSize; ii++) {
+		buffers.window[ii] = (int16_t) lround(32767.0 * 0.5 * (1.0 - cos(2.0 * M_PI * (double)ii / (double)(fftSize - 1))));
+	}
+	memset(buffers.spectrum, 0, (fftSize / 2) * sizeof(uint16_t));
+
+	primed = false;
+	decimationCount = 0;
+	count = 0;
+	spectrumCount = 0;
+}
+
+void ADXL362EnvelopeAnalyzerBase::process(const ADXL362DataBase &data) {
+	ADXL362Sample sample;
+
+	for(size_t ii = 0; ii < data.numSamplesRead; ii++) {
+		data.readSample(ii, sample);
+		processSample(sample);
+	}
+}
+
+void ADXL362EnvelopeAnalyzerBase::processSample(const ADXL362Sample &sample) {
+	int32_t value = ADXL362Dsp::axisValue(sample, axis) << INPUT_SHIFT;
+
+	if (!primed) {
+		bandPass.prime(value);
+		primed = true;
+	}
+
+	int32_t band = bandPass.process(value);
+	if (band < 0) {
+		band = -band;
+	}
+	int32_t envelope = lowPass.process(band);
+
+	if (++decimationCount >= decimation) {
+		decimationCount = 0;
+		buffers.re[count++] = envelope;
+		if (count >= fftSize) {
+			analyze();
+			count = 0;
+		}
+	}
+}
+
+void ADXL362EnvelopeAnalyzerBase::analyze() {
+	// Remove the mean of the envelope, which would otherwise leak into the low bins
+	int64_t sum = 0;
+	for(size_t ii = 0; ii < fftSize; ii++) {
+		sum += buffers.re[ii];
+	}
+	int32_t mean = (int32_t)(sum / (int64_t)fftSize);
+
+	for(size_t ii = 0; ii < fftSize; ii++) {
+		buffers.re[ii] = (int32_t)(((int64_t)(buffers.re[ii] - mean) * buffers.window[ii]) >> 15);
+		buffers.im[ii] = 0;
+	}
+
+	ADXL362Dsp::fft(buffers.re, buffers.im, fftSize, buffers.cosTable, buffers.sinTable);
+
+	// A sine of amplitude A gives a bin magnitude of A / 2, and the Hann window halves it again
+	for(size_t ii = 0; ii < fftSize / 2; ii++) {
+		int64_t re = buffers.re[ii];
+		int64_t im = buffers.im[ii];
+		uint64_t magSq = (uint64_t)(re * re + im * im);
+		uint32_t mag = ADXL362Dsp::isqrt((uint32_t)((magSq > 0xffffffffULL) ? 0xffffffffULL : magSq));
+		uint32_t amplitude = (mag * 4) >> INPUT_SHIFT;
+		buffers.spectrum[ii] = (uint16_t)((amplitude > 0xffff) ? 0xffff : amplitude);
+	}
+
+	spectrumCount++;
+
+	if (callback) {
+		callback(*this);
+	}
+}
+
+size_t ADXL362EnvelopeAnalyzerBase::getPeakBin() const {
+	size_t peak = 1;
+	for(size_t ii = 2; ii < fftSize / 2; ii++) {
+		if (buffers.spectrum[ii] > buffers.spectrum[peak]) {
+			peak = ii;
+		}
+	}
+	return peak;
+}
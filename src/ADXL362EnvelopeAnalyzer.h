@@ -0,0 +1,163 @@
+#ifndef __ADXL362ENVELOPEANALYZER_H
+#define __ADXL362ENVELOPEANALYZER_H
+
+// Envelope (demodulation) analysis for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+#include "ADXL362Dsp.h"
+
+#include <functional>
+
+/**
+ * @brief Streaming envelope analysis for bearing fault detection
+ *
+ * Bearing faults show up as a modulation of high-frequency structural resonances at the fault
+ * frequency. Envelope analysis recovers the modulation:
+ *
+ * - Band-pass filter around the resonance
+ * - Rectify (absolute value)
+ * - Low-pass filter and decimate, leaving the envelope
+ * - FFT of the envelope, where the fault frequencies appear as peaks
+ *
+ * The filters are fixed-point biquads whose state is carried across FIFO buffers, and the FFT is
+ * fixed-point. At 400 Hz the band-pass filter can be placed up to about 180 Hz.
+ *
+ * You will not allocate one of these directly; use ADXL362EnvelopeAnalyzer, which allocates the buffers.
+ */
+class ADXL362EnvelopeAnalyzerBase {
+public:
+	/**
+	 * @brief Buffers used by the analyzer, allocated by ADXL362EnvelopeAnalyzer
+	 */
+	struct Buffers {
+		int32_t *re;			//!< FFT real parts, also used to collect the envelope (fftSize)
+		int32_t *im;			//!< FFT imaginary parts (fftSize)
+		int16_t *cosTable;		//!< Twiddle factors (fftSize / 2)
+		int16_t *sinTable;		//!< Twiddle factors (fftSize / 2)
+		int16_t *window;		//!< Hann window in Q15 (fftSize)
+		uint16_t *spectrum;		//!< Envelope spectrum amplitude in counts (fftSize / 2)
+	};
+
+	/**
+	 * @brief Constructor - You will not allocate one of these directly
+	 *
+	 * @param buffers Buffer storage
+	 *
+	 * @param fftSize FFT size, a power of 2
+	 */
+	ADXL362EnvelopeAnalyzerBase(const Buffers &buffers, size_t fftSize);
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362EnvelopeAnalyzerBase();
+
+	/**
+	 * @brief Configure the analyzer. Must be called before process().
+	 *
+	 * @param sampleRate The output data rate in Hz, typically 400. See ADXL362DMA::getOutputDataRate().
+	 *
+	 * @param bandCenter Center of the band-pass filter (the resonance) in Hz
+	 *
+	 * @param bandQ Quality factor of the band-pass filter. Higher values are narrower.
+	 *
+	 * @param decimation The envelope is low-pass filtered and decimated by this factor before the
+	 * FFT. The envelope spectrum covers 0 to sampleRate / (2 * decimation) Hz.
+	 *
+	 * @param axis Which axis to analyze (default: MAGNITUDE)
+	 */
+	void begin(float sampleRate, float bandCenter, float bandQ = 2.0, uint16_t decimation = 4, ADXL362Dsp::Axis axis = ADXL362Dsp::Axis::MAGNITUDE);
+
+	/**
+	 * @brief Set the function to call when a new envelope spectrum is available
+	 */
+	void setCallback(std::function<void(const ADXL362EnvelopeAnalyzerBase &analyzer)> callback) { this->callback = callback; };
+
+	/**
+	 * @brief Process all of the samples in a completed FIFO buffer
+	 *
+	 * @param data A buffer in STATE_READ_COMPLETE state
+	 */
+	void process(const ADXL362DataBase &data);
+
+	/**
+	 * @brief Process a single sample
+	 */
+	void processSample(const ADXL362Sample &sample);
+
+	/**
+	 * @brief Returns the envelope amplitude for an FFT bin, in counts
+	 *
+	 * @param bin 0 to getNumBins() - 1
+	 */
+	uint16_t getAmplitude(size_t bin) const { return (bin < fftSize / 2) ? buffers.spectrum[bin] : 0; };
+
+	/**
+	 * @brief Returns the number of spectrum bins (fftSize / 2)
+	 */
+	size_t getNumBins() const { return fftSize / 2; };
+
+	/**
+	 * @brief Returns the frequency of a bin in Hz
+	 */
+	float getBinFrequency(size_t bin) const { return (float)bin * envelopeRate / (float)fftSize; };
+
+	/**
+	 * @brief Returns the bin with the largest amplitude, excluding DC
+	 */
+	size_t getPeakBin() const;
+
+	/**
+	 * @brief Returns the number of spectra calculated since begin()
+	 */
+	uint32_t getSpectrumCount() const { return spectrumCount; };
+
+protected:
+	/**
+	 * @brief Window, FFT, and calculate the spectrum
+	 */
+	void analyze();
+
+	static const int INPUT_SHIFT = 4; //!< Input is scaled by 2^INPUT_SHIFT for the filters
+
+	Buffers buffers; //!< Buffer storage
+	size_t fftSize; //!< FFT size
+	float envelopeRate = 0; //!< Sample rate after decimation
+	uint16_t decimation = 1; //!< Decimation factor
+	ADXL362Dsp::Axis axis = ADXL362Dsp::Axis::MAGNITUDE; //!< Signal to analyze
+	ADXL362Biquad bandPass; //!< Band-pass around the resonance
+	ADXL362Biquad lowPass; //!< Envelope low-pass (anti-alias for decimation)
+	std::function<void(const ADXL362EnvelopeAnalyzerBase &analyzer)> callback = nullptr; //!< Callback function
+
+	bool primed = false; //!< Filters have been primed with the first sample
+	uint16_t decimationCount = 0; //!< Samples since the last decimated output
+	size_t count = 0; //!< Envelope samples collected in buffers.re
+	uint32_t spectrumCount = 0; //!< Spectra calculated
+};
+
+/**
+ * @brief Envelope analyzer
+ *
+ * @param FFT_SIZE FFT size, a power of 2 (for example, 128 or 256). RAM use is about 14 bytes * FFT_SIZE.
+ */
+template <size_t FFT_SIZE>
+class ADXL362EnvelopeAnalyzer : public ADXL362EnvelopeAnalyzerBase {
+public:
+	static_assert(FFT_SIZE >= 4 && (FFT_SIZE & (FFT_SIZE - 1)) == 0, "FFT_SIZE must be a power of 2");
+
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362EnvelopeAnalyzer() : ADXL362EnvelopeAnalyzerBase(Buffers{ staticRe, staticIm, staticCos, staticSin, staticWindow, staticSpectrum }, FFT_SIZE) {};
+
+	int32_t staticRe[FFT_SIZE]; //!< Real parts
+	int32_t staticIm[FFT_SIZE]; //!< Imaginary parts
+	int16_t staticCos[FFT_SIZE / 2]; //!< Cosine table
+	int16_t staticSin[FFT_SIZE / 2]; //!< Sine table
+	int16_t staticWindow[FFT_SIZE]; //!< Hann window
+	uint16_t staticSpectrum[FFT_SIZE / 2]; //!< Spectrum
+};
+
+#endif /* __ADXL362ENVELOPEANALYZER_H */
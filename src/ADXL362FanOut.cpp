@@ -0,0 +1,127 @@
+#include "Particle.h"
+
+#include "ADXL362FanOut.h"
+
+// Multi-rate fan-out of FIFO buffers for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+ADXL362FanOutBase::Handle::Handle(const Handle &other) : slot(other.slot) {
+	if (slot) {
+		slot->refs.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+ADXL362FanOutBase::Handle &ADXL362FanOutBase::Handle::operator=(const Handle &other) {
+	if (other.slot) {
+		other.slot->refs.fetch_add(1, std::memory_order_relaxed);
+	}
+	release();
+	slot = other.slot;
+	return *this;
+}
+
+void ADXL362FanOutBase::Handle::release() {
+	if (slot) {
+		// Read the buffer before the decrement; once refs is 0 the slot can be reused by publish()
+		ADXL362DataBase *data = slot->data;
+		if (slot->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			data->state = ADXL362DMA::STATE_FREE;
+		}
+		slot = nullptr;
+	}
+}
+
+ADXL362FanOutBase::ADXL362FanOutBase(Slot *slots, size_t numSlots, Subscriber *subscribers, size_t numSubscribers) :
+	slots(slots), numSlots(numSlots), subscribers(subscribers), numSubscribers(numSubscribers) {
+
+	for(size_t ii = 0; ii < numSlots; ii++) {
+		slots[ii].data = nullptr;
+		slots[ii].refs.store(0);
+	}
+	for(size_t ii = 0; ii < numSubscribers; ii++) {
+		subscribers[ii].divisor = 0;
+	}
+}
+
+ADXL362FanOutBase::~ADXL362FanOutBase() {
+}
+
+int ADXL362FanOutBase::subscribe(uint16_t divisor, std::function<void(const Delivery &delivery)> callback) {
+	for(size_t ii = 0; ii < numSubscribers; ii++) {
+		Subscriber &sub = subscribers[ii];
+		if (sub.divisor == 0) {
+			sub.callback = callback;
+			sub.divisor = (divisor > 0) ? divisor : 1;
+			sub.phase = 0;
+			sub.sampleIndex = 0;
+			return (int)ii;
+		}
+	}
+	return -1;
+}
+
+void ADXL362FanOutBase::unsubscribe(int id) {
+	if (id >= 0 && (size_t)id < numSubscribers) {
+		subscribers[id].divisor = 0;
+		subscribers[id].callback = nullptr;
+	}
+}
+
+bool ADXL362FanOutBase::publish(ADXL362DataBase *data) {
+	Slot *slot = nullptr;
+	for(size_t ii = 0; ii < numSlots; ii++) {
+		if (slots[ii].refs.load(std::memory_order_acquire) == 0) {
+			slot = &slots[ii];
+			break;
+		}
+	}
+	if (!slot) {
+		return false;
+	}
+
+	// The reference held by publish() itself, released when ownHandle goes out of scope
+	slot->data = data;
+	slot->refs.store(1, std::memory_order_release);
+	Handle ownHandle(slot);
+
+	size_t n = data->numSamplesRead;
+
+	for(size_t ii = 0; ii < numSubscribers; ii++) {
+		Subscriber &sub = subscribers[ii];
+		if (sub.divisor == 0) {
+			continue;
+		}
+
+		if (sub.phase >= n) {
+			// No samples selected from this buffer
+			sub.phase -= n;
+			continue;
+		}
+
+		Delivery delivery;
+		delivery.handle = ownHandle;
+		delivery.firstSample = sub.phase;
+		delivery.step = sub.divisor;
+		delivery.numSamples = (n - 1 - sub.phase) / sub.divisor + 1;
+		delivery.sampleIndex = sub.sampleIndex;
+
+		sub.phase = (uint16_t)(delivery.firstSample + delivery.numSamples * delivery.step - n);
+		sub.sampleIndex += delivery.numSamples;
+
+		if (sub.callback) {
+			sub.callback(delivery);
+		}
+	}
+
+	return true;
+}
+
+size_t ADXL362FanOutBase::getNumInUse() const {
+	size_t count = 0;
+	for(size_t ii = 0; ii < numSlots; ii++) {
+		if (slots[ii].refs.load(std::memory_order_relaxed) != 0) {
+			count++;
+		}
+	}
+	return count;
+}
@@ -0,0 +1,207 @@
+#ifndef __ADXL362FANOUT_H
+#define __ADXL362FANOUT_H
+
+// Multi-rate fan-out of FIFO buffers for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+
+#include <atomic>
+#include <functional>
+
+/**
+ * @brief Shares each completed FIFO buffer among several subscribers, each at its own rate
+ *
+ * For example, one sensor can feed 400 Hz raw data to an FFT, 25 Hz data to a flash log, and
+ * 1 Hz data to telemetry, without copying the buffers.
+ *
+ * Each buffer passed to publish() is wrapped in a reference-counted Handle. Every subscriber whose
+ * rate selects at least one sample in the buffer gets a Delivery containing a Handle. If the
+ * subscriber only needs the data during the callback, it does nothing else. If it needs the data
+ * later (for example, to write it to flash from another thread), it keeps a copy of the Handle.
+ * The buffer goes back to STATE_FREE when the last Handle is destroyed or released.
+ *
+ * Reference counts are atomic, so handles can be released from a different thread than the one
+ * that calls publish().
+ *
+ * The rate is a divisor of the output data rate: a subscriber with a divisor of 16 at 400 Hz gets
+ * every 16th sample (25 Hz). The position is carried across buffers, so the spacing is exact
+ * regardless of how many samples are in each buffer. This is sample selection only; if aliasing
+ * matters, low-pass filter in the subscriber (see ADXL362Biquad) using all of the samples.
+ *
+ * You will not allocate one of these directly; use ADXL362FanOut, which allocates the storage.
+ */
+class ADXL362FanOutBase {
+public:
+	/**
+	 * @brief Reference count for a buffer that has been published
+	 */
+	struct Slot {
+		ADXL362DataBase *data;			//!< The buffer
+		std::atomic<uint16_t> refs;		//!< Number of handles, 0 = slot is free
+	};
+
+	/**
+	 * @brief Reference-counted handle to a published buffer
+	 *
+	 * Copying a handle adds a reference. The buffer is freed when the last handle is destroyed or
+	 * release() is called on it.
+	 */
+	class Handle {
+	public:
+		/**
+		 * @brief Construct an empty handle
+		 */
+		Handle() {};
+
+		/**
+		 * @brief Copy constructor, adds a reference
+		 */
+		Handle(const Handle &other);
+
+		/**
+		 * @brief Move constructor, the other handle becomes empty
+		 */
+		Handle(Handle &&other) : slot(other.slot) { other.slot = nullptr; };
+
+		/**
+		 * @brief Destructor, releases the reference
+		 */
+		~Handle() { release(); };
+
+		/**
+		 * @brief Assignment, releases the current reference and adds one to the other buffer
+		 */
+		Handle &operator=(const Handle &other);
+
+		/**
+		 * @brief Release the reference. The handle is empty afterwards.
+		 */
+		void release();
+
+		/**
+		 * @brief Returns the buffer, or nullptr if the handle is empty
+		 */
+		const ADXL362DataBase *get() const { return slot ? slot->data : nullptr; };
+
+		/**
+		 * @brief Access the buffer
+		 */
+		const ADXL362DataBase *operator->() const { return get(); };
+
+		/**
+		 * @brief Returns true if the handle refers to a buffer
+		 */
+		explicit operator bool() const { return slot != nullptr; };
+
+	protected:
+		/**
+		 * @brief Construct a handle that takes over a reference already counted in slot
+		 */
+		explicit Handle(Slot *slot) : slot(slot) {};
+
+		Slot *slot = nullptr; //!< Reference counted slot, or nullptr if empty
+
+		friend class ADXL362FanOutBase;
+	};
+
+	/**
+	 * @brief Passed to the subscriber callback
+	 */
+	struct Delivery {
+		Handle handle;			//!< Handle to the buffer, copy it to keep the buffer after the callback
+		size_t firstSample;		//!< Index in the buffer of the first sample selected for this subscriber
+		size_t step;			//!< Distance between selected samples (the divisor)
+		size_t numSamples;		//!< Number of samples selected in this buffer
+		uint32_t sampleIndex;	//!< Output sample number of the first selected sample, counted from subscribe()
+
+		/**
+		 * @brief Read a selected sample
+		 *
+		 * @param index 0 to numSamples - 1
+		 *
+		 * @param sample Filled in with the sample
+		 */
+		void readSample(size_t index, ADXL362Sample &sample) const { handle->readSample(firstSample + index * step, sample); };
+	};
+
+	/**
+	 * @brief Subscriber state
+	 */
+	struct Subscriber {
+		std::function<void(const Delivery &delivery)> callback;	//!< Called for each buffer with selected samples
+		uint16_t divisor;			//!< Take every divisor samples, 0 = not in use
+		uint16_t phase;				//!< Samples to skip before the next selected sample
+		uint32_t sampleIndex;		//!< Output samples delivered
+	};
+
+	/**
+	 * @brief Constructor - You will not allocate one of these directly
+	 */
+	ADXL362FanOutBase(Slot *slots, size_t numSlots, Subscriber *subscribers, size_t numSubscribers);
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362FanOutBase();
+
+	/**
+	 * @brief Add a subscriber
+	 *
+	 * @param divisor 1 for every sample, 16 for every 16th sample, etc.
+	 *
+	 * @param callback Called from publish() for each buffer that contains selected samples
+	 *
+	 * @return A subscriber id to pass to unsubscribe(), or -1 if there are no free subscriber entries
+	 */
+	int subscribe(uint16_t divisor, std::function<void(const Delivery &delivery)> callback);
+
+	/**
+	 * @brief Remove a subscriber. Handles it is holding are not affected.
+	 */
+	void unsubscribe(int id);
+
+	/**
+	 * @brief Share a completed buffer with the subscribers
+	 *
+	 * @param data A buffer in STATE_READ_COMPLETE state. Do not change its state after this; it's set to
+	 * STATE_FREE when the last handle is released, which may be before publish() returns.
+	 *
+	 * @return false if there are no free slots. The buffer is not changed, and you can retry later.
+	 */
+	bool publish(ADXL362DataBase *data);
+
+	/**
+	 * @brief Returns the number of buffers that are still referenced by a handle
+	 */
+	size_t getNumInUse() const;
+
+protected:
+	Slot *slots; //!< Reference counts
+	size_t numSlots; //!< Number of slots
+	Subscriber *subscribers; //!< Subscribers
+	size_t numSubscribers; //!< Number of subscriber entries
+};
+
+/**
+ * @brief Fan-out of FIFO buffers to subscribers at different rates
+ *
+ * @param MAX_BUFFERS The number of buffers that can be held by handles at once, typically the
+ * number of buffers in your ring
+ *
+ * @param MAX_SUBSCRIBERS The number of subscribers (default: 4)
+ */
+template <size_t MAX_BUFFERS, size_t MAX_SUBSCRIBERS = 4>
+class ADXL362FanOut : public ADXL362FanOutBase {
+public:
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362FanOut() : ADXL362FanOutBase(staticSlots, MAX_BUFFERS, staticSubscribers, MAX_SUBSCRIBERS) {};
+
+	Slot staticSlots[MAX_BUFFERS]; //!< Reference counts
+	Subscriber staticSubscribers[MAX_SUBSCRIBERS]; //!< Subscribers
+};
+
+#endif /* __ADXL362FANOUT_H */
@@ -0,0 +1,97 @@
+#include "Particle.h"
+
+#include "ADXL362GoertzelBank.h"
+
+#include <math.h>
+
+// Goertzel filter bank for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+ADXL362GoertzelBankBase::ADXL362GoertzelBankBase(Bin *bins, size_t numBins) : bins(bins), numBins(numBins) {
+	memset(bins, 0, numBins * sizeof(Bin));
+}
+
+ADXL362GoertzelBankBase::~ADXL362GoertzelBankBase() {
+}
+
+void ADXL362GoertzelBankBase::begin(float sampleRate, uint16_t windowSamples, Axis axis) {
+	this->sampleRate = sampleRate;
+	this->windowSamples = (windowSamples > 0) ? windowSamples : 1;
+	this->axis = axis;
+
+	memset(bins, 0, numBins * sizeof(Bin));
+	count = 0;
+	sum = 0;
+	haveDc = false;
+	windowCount = 0;
+}
+
+bool ADXL362GoertzelBankBase::setFrequency(size_t index, float frequency) {
+	if (index >= numBins || frequency <= 0 || frequency >= sampleRate / 2) {
+		return false;
+	}
+
+	Bin &bin = bins[index];
+	bin.frequency = frequency;
+	bin.coef = (int32_t) lroundf(2.0 * cosf(2.0 * M_PI * frequency / sampleRate) * (float)(1 << COEF_SHIFT));
+	bin.s1 = bin.s2 = 0;
+	bin.amplitude = 0;
+	return true;
+}
+
+void ADXL362GoertzelBankBase::process(const ADXL362DataBase &data) {
+	ADXL362Sample sample;
+
+	for(size_t ii = 0; ii < data.numSamplesRead; ii++) {
+		data.readSample(ii, sample);
+		processSample(sample);
+	}
+}
+
+void ADXL362GoertzelBankBase::processSample(const ADXL362Sample &sample) {
+	int32_t value = ADXL362Dsp::axisValue(sample, axis);
+
+	if (!haveDc) {
+		dc = value;
+		haveDc = true;
+	}
+	sum += value;
+	value -= dc;
+
+	for(size_t ii = 0; ii < numBins; ii++) {
+		Bin &bin = bins[ii];
+		int32_t s = value + (int32_t)(((int64_t)bin.coef * bin.s1) >> COEF_SHIFT) - bin.s2;
+		bin.s2 = bin.s1;
+		bin.s1 = s;
+	}
+
+	if (++count >= windowSamples) {
+		endWindow();
+	}
+}
+
+void ADXL362GoertzelBankBase::endWindow() {
+	for(size_t ii = 0; ii < numBins; ii++) {
+		Bin &bin = bins[ii];
+
+		// power = s1^2 + s2^2 - coef * s1 * s2, amplitude = 2 * sqrt(power) / N
+		int64_t s1 = bin.s1, s2 = bin.s2;
+		int64_t power = s1 * s1 + s2 * s2 - (((bin.coef * s1) >> COEF_SHIFT) * s2);
+		if (power < 0) {
+			power = 0;
+		}
+		uint64_t ampSq = ((uint64_t)power * 4) / ((uint64_t)count * count);
+		bin.amplitude = ADXL362Dsp::isqrt((uint32_t)((ampSq > 0xffffffffULL) ? 0xffffffffULL : ampSq));
+
+		bin.s1 = bin.s2 = 0;
+	}
+
+	dc = sum / (int32_t)count;
+	sum = 0;
+	count = 0;
+	windowCount++;
+
+	if (callback) {
+		callback(*this);
+	}
+}
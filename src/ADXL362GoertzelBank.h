@@ -0,0 +1,163 @@
+#ifndef __ADXL362GOERTZELBANK_H
+#define __ADXL362GOERTZELBANK_H
+
+// Goertzel filter bank for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+#include "ADXL362Dsp.h"
+
+#include <functional>
+
+/**
+ * @brief Goertzel filter bank for monitoring a few specific frequencies
+ *
+ * When only a few frequencies matter, such as the line frequency harmonics and known bearing
+ * tones of a motor, a Goertzel filter per frequency is much cheaper than a full FFT. Each sample
+ * costs one multiply per frequency, and the fixed-point state is carried between calls to process(),
+ * so windows can span FIFO buffers.
+ *
+ * At the end of each window, the amplitude at each frequency is available from getAmplitude() and
+ * the callback is called. The DC component (gravity) is removed using the mean of the previous window.
+ *
+ * You will not allocate one of these directly; use ADXL362GoertzelBank, which allocates the bins.
+ */
+class ADXL362GoertzelBankBase {
+public:
+	/**
+	 * @brief Which signal to analyze (X, Y, Z, or MAGNITUDE)
+	 */
+	typedef ADXL362Dsp::Axis Axis;
+
+	/**
+	 * @brief State for one frequency
+	 */
+	struct Bin {
+		float frequency;	//!< Frequency in Hz
+		int32_t coef;		//!< 2 * cos(2 * pi * frequency / sampleRate) in Q14
+		int32_t s1;			//!< Goertzel state s[n-1]
+		int32_t s2;			//!< Goertzel state s[n-2]
+		uint16_t amplitude;	//!< Amplitude in counts from the last complete window
+	};
+
+	/**
+	 * @brief Constructor - You will not allocate one of these directly
+	 *
+	 * @param bins Bin storage
+	 *
+	 * @param numBins Number of bins
+	 */
+	ADXL362GoertzelBankBase(Bin *bins, size_t numBins);
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362GoertzelBankBase();
+
+	/**
+	 * @brief Set the sample rate and window size. Call before setFrequency().
+	 *
+	 * @param sampleRate The output data rate in Hz. See ADXL362DMA::getOutputDataRate().
+	 *
+	 * @param windowSamples The number of samples in each window. The frequency resolution is
+	 * sampleRate / windowSamples, so 400 samples at 400 Hz resolves 1 Hz.
+	 *
+	 * @param axis Which axis to analyze (default: MAGNITUDE)
+	 */
+	void begin(float sampleRate, uint16_t windowSamples, Axis axis = Axis::MAGNITUDE);
+
+	/**
+	 * @brief Set the frequency for a bin
+	 *
+	 * @param index 0 to the number of bins - 1
+	 *
+	 * @param frequency Frequency in Hz, less than half of the sample rate
+	 *
+	 * @return true if set, false if the index or frequency are out of range
+	 */
+	bool setFrequency(size_t index, float frequency);
+
+	/**
+	 * @brief Set the function to call at the end of each window
+	 */
+	void setCallback(std::function<void(const ADXL362GoertzelBankBase &bank)> callback) { this->callback = callback; };
+
+	/**
+	 * @brief Process all of the samples in a completed FIFO buffer
+	 *
+	 * @param data A buffer in STATE_READ_COMPLETE state
+	 */
+	void process(const ADXL362DataBase &data);
+
+	/**
+	 * @brief Process a single sample
+	 */
+	void processSample(const ADXL362Sample &sample);
+
+	/**
+	 * @brief Returns the amplitude at a frequency from the last complete window, in counts
+	 *
+	 * @param index 0 to the number of bins - 1
+	 */
+	uint16_t getAmplitude(size_t index) const { return (index < numBins) ? bins[index].amplitude : 0; };
+
+	/**
+	 * @brief Returns the frequency of a bin in Hz
+	 *
+	 * @param index 0 to the number of bins - 1
+	 */
+	float getFrequency(size_t index) const { return (index < numBins) ? bins[index].frequency : 0; };
+
+	/**
+	 * @brief Returns the number of bins
+	 */
+	size_t getNumBins() const { return numBins; };
+
+	/**
+	 * @brief Returns the number of windows completed since begin()
+	 */
+	uint32_t getWindowCount() const { return windowCount; };
+
+	static const int COEF_SHIFT = 14; //!< Coefficients are Q14
+
+protected:
+	/**
+	 * @brief Calculate the amplitudes and clear the state at the end of a window
+	 */
+	void endWindow();
+
+	Bin *bins; //!< Bin storage
+	size_t numBins; //!< Number of bins
+	float sampleRate = 0; //!< Sample rate in Hz
+	uint16_t windowSamples = 0; //!< Samples per window
+	Axis axis = Axis::MAGNITUDE; //!< Signal to analyze
+	std::function<void(const ADXL362GoertzelBankBase &bank)> callback = nullptr; //!< Callback function
+
+	uint16_t count = 0; //!< Samples in the current window
+	int32_t dc = 0; //!< Mean of the previous window
+	int32_t sum = 0; //!< Sum of the current window
+	bool haveDc = false; //!< dc is valid
+	uint32_t windowCount = 0; //!< Windows completed
+};
+
+/**
+ * @brief Goertzel filter bank
+ *
+ * @param NUM_BINS Number of frequencies to monitor
+ */
+template <size_t NUM_BINS>
+class ADXL362GoertzelBank : public ADXL362GoertzelBankBase {
+public:
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362GoertzelBank() : ADXL362GoertzelBankBase(staticBins, NUM_BINS) {};
+
+	/**
+	 * @brief Bin storage
+	 */
+	Bin staticBins[NUM_BINS];
+};
+
+#endif /* __ADXL362GOERTZELBANK_H */
@@ -0,0 +1,246 @@
+#ifndef __ADXL362PIPELINE_H
+#define __ADXL362PIPELINE_H
+
+// Compile-time processing pipeline for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+#include "ADXL362Dsp.h"
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief A chain of processing stages run in a single loop over a FIFO buffer
+ *
+ * A stage is any object (including a lambda) that can be called with an ADXL362Sample &. It can
+ * modify the sample in place. If it returns bool, returning false drops the sample so the later
+ * stages don't see it (for decimation or detection). If it returns void, the sample always
+ * continues.
+ *
+ * The stages are template parameters, so the calls are resolved at compile time and can be
+ * inlined into the loop. There are no virtual calls and no intermediate arrays; each sample is
+ * read from the buffer once and passes through all stages before the next sample is read.
+ *
+ * With stages that are lambdas, use makeADXL362Pipeline() so the types are deduced:
+ *
+ * ```
+ * auto pipeline = makeADXL362Pipeline(
+ *     ADXL362CalibrateStage(),
+ *     ADXL362DecimateStage<16>(),
+ *     [](const ADXL362Sample &sample) { Log.info("x=%d", sample.x); });
+ *
+ * pipeline.process(dataBuffer);
+ * ```
+ */
+template <class... Stages>
+class ADXL362Pipeline {
+public:
+	/**
+	 * @brief Default constructor, all stages are default constructed
+	 */
+	ADXL362Pipeline() {};
+
+	/**
+	 * @brief Constructor with stage objects, which are moved or copied into the pipeline
+	 */
+	explicit ADXL362Pipeline(Stages... stages) : stages(std::move(stages)...) {};
+
+	/**
+	 * @brief Run all of the samples in a completed FIFO buffer through the stages
+	 *
+	 * @param data A buffer in STATE_READ_COMPLETE state
+	 *
+	 * @return The number of samples that passed through all of the stages
+	 */
+	size_t process(const ADXL362DataBase &data) {
+		size_t passed = 0;
+		ADXL362Sample sample;
+
+		for(size_t ii = 0; ii < data.numSamplesRead; ii++) {
+			data.readSample(ii, sample);
+			if (run(sample, std::integral_constant<size_t, 0>())) {
+				passed++;
+			}
+		}
+		return passed;
+	}
+
+	/**
+	 * @brief Run a single sample through the stages
+	 *
+	 * @return true if the sample passed through all of the stages
+	 */
+	bool processSample(ADXL362Sample &sample) {
+		return run(sample, std::integral_constant<size_t, 0>());
+	}
+
+	/**
+	 * @brief Access a stage by index, for example to configure it or read its results
+	 */
+	template <size_t I>
+	typename std::tuple_element<I, std::tuple<Stages...> >::type &get() { return std::get<I>(stages); };
+
+	/**
+	 * @brief Number of stages
+	 */
+	static constexpr size_t NUM_STAGES = sizeof...(Stages);
+
+protected:
+	/**
+	 * @brief Call stage I and continue with the next stage if it didn't drop the sample
+	 */
+	template <size_t I>
+	inline bool run(ADXL362Sample &sample, std::integral_constant<size_t, I>) {
+		if (!call(std::get<I>(stages), sample, 0)) {
+			return false;
+		}
+		return run(sample, std::integral_constant<size_t, I + 1>());
+	}
+
+	/**
+	 * @brief End of the chain
+	 */
+	inline bool run(ADXL362Sample &, std::integral_constant<size_t, sizeof...(Stages)>) {
+		return true;
+	}
+
+	/**
+	 * @brief Call a stage that returns a value convertible to bool
+	 */
+	template <class S>
+	static inline auto call(S &stage, ADXL362Sample &sample, int) -> decltype(static_cast<bool>(stage(sample))) {
+		return static_cast<bool>(stage(sample));
+	}
+
+	/**
+	 * @brief Call a stage that returns void; the sample always continues
+	 */
+	template <class S>
+	static inline bool call(S &stage, ADXL362Sample &sample, long) {
+		stage(sample);
+		return true;
+	}
+
+	std::tuple<Stages...> stages; //!< Stage objects
+};
+
+/**
+ * @brief Make a pipeline, deducing the stage types (required for lambdas)
+ */
+template <class... Stages>
+ADXL362Pipeline<typename std::decay<Stages>::type...> makeADXL362Pipeline(Stages &&... stages) {
+	return ADXL362Pipeline<typename std::decay<Stages>::type...>(std::forward<Stages>(stages)...);
+}
+
+/**
+ * @brief Pipeline stage that removes an offset from each axis and applies a gain
+ *
+ * value = (value - offset) * gain / 16384
+ */
+class ADXL362CalibrateStage {
+public:
+	/**
+	 * @brief Set the offset in counts for each axis, for example from a flat, stationary reading
+	 */
+	void setOffset(int16_t x, int16_t y, int16_t z) { offset[0] = x; offset[1] = y; offset[2] = z; };
+
+	/**
+	 * @brief Set the gain for each axis, where 1.0 is no change
+	 */
+	void setGain(float x, float y, float z) {
+		gain[0] = (int32_t)(x * (float)(1 << GAIN_SHIFT));
+		gain[1] = (int32_t)(y * (float)(1 << GAIN_SHIFT));
+		gain[2] = (int32_t)(z * (float)(1 << GAIN_SHIFT));
+	};
+
+	/**
+	 * @brief Called by the pipeline for each sample
+	 */
+	inline void operator()(ADXL362Sample &sample) const {
+		sample.x = (int16_t)(((int32_t)(sample.x - offset[0]) * gain[0]) >> GAIN_SHIFT);
+		sample.y = (int16_t)(((int32_t)(sample.y - offset[1]) * gain[1]) >> GAIN_SHIFT);
+		sample.z = (int16_t)(((int32_t)(sample.z - offset[2]) * gain[2]) >> GAIN_SHIFT);
+	};
+
+	static const int GAIN_SHIFT = 14; //!< Gain is Q14
+
+protected:
+	int16_t offset[3] = { 0, 0, 0 }; //!< Offset in counts
+	int32_t gain[3] = { 1 << GAIN_SHIFT, 1 << GAIN_SHIFT, 1 << GAIN_SHIFT }; //!< Gain in Q14
+};
+
+/**
+ * @brief Pipeline stage that low-pass filters each axis
+ *
+ * Place this before ADXL362DecimateStage to reduce aliasing. The output is in counts.
+ */
+class ADXL362LowPassStage {
+public:
+	/**
+	 * @brief Set the filter frequency. Must be called before processing.
+	 *
+	 * @param sampleRate The output data rate in Hz
+	 *
+	 * @param cutoffHz The cutoff frequency in Hz
+	 */
+	void begin(float sampleRate, float cutoffHz) {
+		for(size_t ii = 0; ii < 3; ii++) {
+			filter[ii].setLowPass(sampleRate, cutoffHz);
+		}
+		primed = false;
+	};
+
+	/**
+	 * @brief Called by the pipeline for each sample
+	 */
+	inline void operator()(ADXL362Sample &sample) {
+		int16_t *values[3] = { &sample.x, &sample.y, &sample.z };
+
+		for(size_t ii = 0; ii < 3; ii++) {
+			int32_t value = (int32_t)*values[ii] << INPUT_SHIFT;
+			if (!primed) {
+				filter[ii].prime(value);
+			}
+			*values[ii] = (int16_t)(filter[ii].process(value) >> INPUT_SHIFT);
+		}
+		primed = true;
+	};
+
+protected:
+	static const int INPUT_SHIFT = 4; //!< Input is scaled by 2^INPUT_SHIFT for the filters
+
+	ADXL362Biquad filter[3]; //!< Per-axis filter
+	bool primed = false; //!< Filters have been primed with the first sample
+};
+
+/**
+ * @brief Pipeline stage that passes every Nth sample. The position is carried across buffers.
+ *
+ * @param N The decimation factor
+ */
+template <uint16_t N>
+class ADXL362DecimateStage {
+public:
+	static_assert(N > 0, "N must be at least 1");
+
+	/**
+	 * @brief Called by the pipeline for each sample
+	 *
+	 * @return true for every Nth sample
+	 */
+	inline bool operator()(ADXL362Sample &) {
+		if (++count >= N) {
+			count = 0;
+			return true;
+		}
+		return false;
+	};
+
+protected:
+	uint16_t count = N - 1; //!< Samples since the last one passed; the first sample passes
+};
+
+#endif /* __ADXL362PIPELINE_H */
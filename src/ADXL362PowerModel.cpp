@@ -0,0 +1,179 @@
+#include "Particle.h"
+
+#include "ADXL362PowerModel.h"
+
+// Configuration-based energy model for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+// [static]
+void ADXL362PowerModel::fromDriver(const ADXL362DMA &accel, Config &config) {
+	config.odr = accel.getOutputDataRate();
+
+	uint8_t powerCtl = accel.getShadowRegister(ADXL362DMA::REG_POWER_CTL);
+	config.lowNoise = (powerCtl >> 4) & 0x3;
+	config.measureMode = powerCtl & 0x3;
+	config.wakeup = (powerCtl & ADXL362DMA::POWERCTL_WAKEUP) != 0;
+	config.autosleep = (powerCtl & ADXL362DMA::POWERCTL_AUTOSLEEP) != 0;
+
+	config.storeTemp = accel.getStoreTemp();
+	config.fifoMode = accel.getShadowRegister(ADXL362DMA::REG_FIFO_CONTROL) & 0x03;
+
+	uint8_t intmap = accel.getShadowRegister(ADXL362DMA::REG_FIFO_INTMAP1) | accel.getShadowRegister(ADXL362DMA::REG_FIFO_INTMAP2);
+	if (intmap & ADXL362DMA::INTMAP_FIFO_WATERMARK) {
+		config.watermarkEntries = accel.getFifoSamples();
+	}
+	else {
+		config.watermarkEntries = 0;
+	}
+}
+
+// [static]
+float ADXL362PowerModel::sensorCurrentUa(const Config &config) {
+	if ((config.measureMode & 0x3) != ADXL362DMA::MEASURE_MEASUREMENT) {
+		return STANDBY_CURRENT_UA;
+	}
+	if (config.wakeup) {
+		return WAKEUP_CURRENT_UA;
+	}
+
+	// Linear fit through the 100 Hz and 400 Hz datasheet values
+	float slope = (NORMAL_400HZ_CURRENT_UA - NORMAL_100HZ_CURRENT_UA) / 300.0;
+	float current = NORMAL_100HZ_CURRENT_UA + (config.odr - 100.0) * slope;
+
+	switch(config.lowNoise) {
+		case ADXL362DMA::LOWNOISE_LOW:
+			current *= LOW_NOISE_FACTOR;
+			break;
+
+		case ADXL362DMA::LOWNOISE_ULTRALOW:
+			current *= ULTRALOW_NOISE_FACTOR;
+			break;
+
+		default:
+			break;
+	}
+
+	if (config.autosleep) {
+		// Drops to wake-up mode while inactive
+		float active = config.activeFraction;
+		if (active < 0.0) {
+			active = 0.0;
+		}
+		if (active > 1.0) {
+			active = 1.0;
+		}
+		current = current * active + WAKEUP_CURRENT_UA * (1.0 - active);
+	}
+
+	return current;
+}
+
+// [static]
+void ADXL362PowerModel::estimate(const Config &config, Estimate &estimate) {
+	estimate.sensorCurrentUa = sensorCurrentUa(config);
+	estimate.sensorChargeMahPerDay = estimate.sensorCurrentUa * 24.0 / 1000.0;
+
+	float activeOdr = config.odr;
+	if ((config.measureMode & 0x3) != ADXL362DMA::MEASURE_MEASUREMENT || config.wakeup) {
+		// FIFO is not filled at the output data rate in these modes
+		activeOdr = 0;
+	}
+	else
+	if (config.autosleep) {
+		activeOdr *= config.activeFraction;
+	}
+	estimate.samplesPerHour = activeOdr * 3600.0;
+
+	size_t sampleSizeInBytes = config.storeTemp ? 8 : 6;
+	size_t entriesPerSample = sampleSizeInBytes / 2;
+
+	if (config.watermarkEntries >= entriesPerSample) {
+		float samplesPerWake = (float)(config.watermarkEntries / entriesPerSample);
+		estimate.wakesPerHour = estimate.samplesPerHour / samplesPerWake;
+	}
+	else
+	if (config.pollIntervalMs > 0) {
+		estimate.wakesPerHour = 3600000.0 / config.pollIntervalMs;
+	}
+	else {
+		estimate.wakesPerHour = 0;
+	}
+
+	// Samples in the FIFO at each wake, limited by the size of the FIFO
+	float samplesPerWake = 0;
+	bool fifoFull = false;
+	if (estimate.wakesPerHour > 0) {
+		samplesPerWake = estimate.samplesPerHour / estimate.wakesPerHour;
+		float maxSamplesPerWake = (float)(ADXL362DMA::FIFO_NUM_ENTRIES / entriesPerSample);
+		if (samplesPerWake > maxSamplesPerWake) {
+			samplesPerWake = maxSamplesPerWake;
+			fifoFull = true;
+		}
+	}
+
+	// readFifoAsync() reads at most as many samples as fit in the buffer
+	float readsPerWake = 1.0;
+	float bufferSamples = (float)(config.bufferSize / sampleSizeInBytes);
+	if (bufferSamples > 0 && samplesPerWake > bufferSamples) {
+		readsPerWake = ceilf(samplesPerWake / bufferSamples);
+	}
+
+	// readFifoAsync(data) reads FIFO_ENTRIES (4 byte transaction), then the command byte and the FIFO data
+	float transactionsPerRead = config.readEntriesFirst ? 2.0 : 1.0;
+	float overheadBytesPerRead = config.readEntriesFirst ? 5.0 : 1.0;
+
+	float transactionsPerWake = readsPerWake * transactionsPerRead;
+	float overheadBytesPerWake = readsPerWake * overheadBytesPerRead;
+
+	if (config.readStatusFirst) {
+		// readStatus() is a 3 byte transaction
+		transactionsPerWake += 1.0;
+		overheadBytesPerWake += 3.0;
+	}
+
+	if (config.finalEmptyPoll) {
+		// The FIFO keeps filling during the last read, so the next FIFO_ENTRIES read sometimes finds
+		// a sample and takes another read before the one that finds none
+		float lastReadSamples = samplesPerWake;
+		if (bufferSamples > 0) {
+			lastReadSamples -= (readsPerWake - 1.0) * bufferSamples;
+		}
+		float arrivals = 0;
+		if (fifoFull && config.fifoMode != ADXL362DMA::FIFO_OLDEST_SAVED && (ADXL362DMA::FIFO_NUM_ENTRIES % entriesPerSample) != 0) {
+			// A full FIFO in stream mode ends with part of a sample, which the next sample to arrive completes
+			arrivals = 1.0;
+		}
+		else
+		if (config.spiClockHz > 0) {
+			float lastReadSeconds = (lastReadSamples * (float)sampleSizeInBytes + overheadBytesPerRead) * 8.0 / (float)config.spiClockHz;
+			arrivals = lastReadSeconds * activeOdr;
+			if (arrivals > 1.0) {
+				arrivals = 1.0;
+			}
+		}
+		transactionsPerWake += 1.0 + arrivals * transactionsPerRead;
+		overheadBytesPerWake += 4.0 + arrivals * overheadBytesPerRead;
+	}
+
+	estimate.transactionsPerHour = estimate.wakesPerHour * transactionsPerWake;
+	estimate.bytesPerHour = estimate.wakesPerHour * overheadBytesPerWake + estimate.samplesPerHour * (float)sampleSizeInBytes;
+
+	if (config.spiClockHz > 0) {
+		estimate.spiBusMsPerHour = estimate.bytesPerHour * 8.0 * 1000.0 / (float)config.spiClockHz;
+	}
+	else {
+		estimate.spiBusMsPerHour = 0;
+	}
+}
+
+// [static]
+float ADXL362PowerModel::validate(const Config &config, const ADXL362DMA &accel, uint32_t elapsedMs) {
+	Estimate est;
+	estimate(config, est);
+
+	float expected = est.transactionsPerHour * (float)elapsedMs / 3600000.0;
+	if (expected <= 0) {
+		return 0;
+	}
+	return (float)accel.getTransactionCount() / expected;
+}
@@ -0,0 +1,113 @@
+#ifndef __ADXL362POWERMODEL_H
+#define __ADXL362POWERMODEL_H
+
+// Configuration-based energy model for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+
+/**
+ * @brief Estimates the sensor current and MCU wake rate for a driver configuration
+ *
+ * The sensor current is based on the typical values in the ADXL362 datasheet (VS = 2.0 V):
+ * 1.8 uA at 100 Hz and 3.0 uA at 400 Hz in normal mode, 270 nA in wake-up mode, and 10 nA in
+ * standby. Other output data rates are interpolated linearly, and low noise and ultralow noise
+ * modes are scaled from the normal mode values. These are estimates for comparing
+ * configurations, not a substitute for measuring your hardware.
+ *
+ * The MCU wakes and SPI transactions are calculated from the FIFO watermark and the
+ * transaction pattern of the driver, and can be compared with ADXL362DMA::getTransactionCount().
+ * When the samples from a wake do not fit in the buffer, each wake takes
+ * ceil(samples per wake / samples per buffer) reads. With finalEmptyPoll, each wake also ends
+ * with a FIFO_ENTRIES read that finds no samples, plus another read for any samples that arrived
+ * while the last read was in progress.
+ */
+class ADXL362PowerModel {
+public:
+	/**
+	 * @brief Configuration to estimate
+	 *
+	 * Use fromDriver() to fill this in from the shadow registers of an ADXL362DMA object.
+	 */
+	struct Config {
+		float odr = 100.0;				//!< Output data rate in Hz (12.5 to 400)
+		uint8_t lowNoise = ADXL362DMA::LOWNOISE_NORMAL;	//!< LOWNOISE_NORMAL, LOWNOISE_LOW, or LOWNOISE_ULTRALOW
+		uint8_t measureMode = ADXL362DMA::MEASURE_MEASUREMENT; //!< MEASURE_STANDBY or MEASURE_MEASUREMENT
+		bool wakeup = false;			//!< Wake-up mode (POWERCTL_WAKEUP)
+		bool autosleep = false;			//!< Autosleep mode (POWERCTL_AUTOSLEEP)
+		float activeFraction = 1.0;		//!< With autosleep, fraction of time activity is detected (0.0 to 1.0)
+		bool storeTemp = false;			//!< FIFO stores XYZT instead of XYZ
+		uint8_t fifoMode = ADXL362DMA::FIFO_STREAM; //!< FIFO_DISABLED, FIFO_OLDEST_SAVED, FIFO_STREAM, or FIFO_TRIGGERED
+		uint16_t watermarkEntries = 0;	//!< FIFO_SAMPLES watermark in 16-bit entries, 0 if not using the watermark
+		uint32_t spiClockHz = 4000000;	//!< SPI clock speed in Hz
+		bool readEntriesFirst = true;	//!< true if each drain calls readFifoAsync(data), false for readFifoAsync(data, numEntries)
+		bool readStatusFirst = false;	//!< true if each wake reads STATUS before the FIFO; set this and readEntriesFirst = false for ADXL362SleepScheduler::drain()
+		float pollIntervalMs = 0;		//!< If not using the watermark, the interval between FIFO reads in milliseconds
+		size_t bufferSize = 0;			//!< Buffer size in bytes passed to readFifoAsync(), 0 if a wake always fits in one read
+		bool finalEmptyPoll = false;	//!< true if each drain calls readFifoAsync(data) until it returns no samples
+	};
+
+	/**
+	 * @brief Result of estimate()
+	 */
+	struct Estimate {
+		float sensorCurrentUa;			//!< Average ADXL362 supply current in microamps
+		float wakesPerHour;				//!< MCU wakes (FIFO drains) per hour
+		float samplesPerHour;			//!< Samples generated per hour
+		float transactionsPerHour;		//!< SPI transactions (CS assertions) per hour
+		float bytesPerHour;				//!< SPI bytes transferred per hour
+		float spiBusMsPerHour;			//!< Time the SPI bus is busy per hour in milliseconds
+		float sensorChargeMahPerDay;	//!< Sensor charge per day in milliamp-hours
+	};
+
+	/**
+	 * @brief Fill in a Config from the shadow registers of the driver
+	 *
+	 * @param accel The accelerometer object
+	 *
+	 * @param config Filled in. Fields not stored in registers (activeFraction, spiClockHz, readEntriesFirst,
+	 * readStatusFirst, pollIntervalMs, bufferSize, finalEmptyPoll) are left unchanged.
+	 *
+	 * The watermark is only used if INTMAP_FIFO_WATERMARK is mapped to INT1 or INT2.
+	 */
+	static void fromDriver(const ADXL362DMA &accel, Config &config);
+
+	/**
+	 * @brief Estimate the current, wakes, and SPI traffic for a configuration
+	 *
+	 * @param config The configuration to estimate
+	 *
+	 * @param estimate Filled in with the results
+	 */
+	static void estimate(const Config &config, Estimate &estimate);
+
+	/**
+	 * @brief Returns the estimated sensor current in microamps, not including SPI traffic
+	 *
+	 * @param config The configuration to estimate
+	 */
+	static float sensorCurrentUa(const Config &config);
+
+	/**
+	 * @brief Compares the estimated transaction count with the count measured by the driver
+	 *
+	 * @param config The configuration being used
+	 *
+	 * @param accel The driver. Call resetTransactionStats() at the start of the measurement period.
+	 *
+	 * @param elapsedMs Length of the measurement period in milliseconds
+	 *
+	 * @return The measured transactions divided by the estimated transactions (1.0 is a perfect match)
+	 */
+	static float validate(const Config &config, const ADXL362DMA &accel, uint32_t elapsedMs);
+
+	static constexpr float STANDBY_CURRENT_UA = 0.01;		//!< Standby mode current
+	static constexpr float WAKEUP_CURRENT_UA = 0.27;		//!< Wake-up mode current
+	static constexpr float NORMAL_100HZ_CURRENT_UA = 1.8;	//!< Measurement mode current at 100 Hz
+	static constexpr float NORMAL_400HZ_CURRENT_UA = 3.0;	//!< Measurement mode current at 400 Hz
+	static constexpr float LOW_NOISE_FACTOR = 1.8;			//!< LOWNOISE_LOW current relative to normal
+	static constexpr float ULTRALOW_NOISE_FACTOR = 7.2;	//!< LOWNOISE_ULTRALOW current relative to normal
+};
+
+#endif /* __ADXL362POWERMODEL_H */
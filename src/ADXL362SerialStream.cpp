@@ -0,0 +1,203 @@
+#include "Particle.h"
+
+#include "ADXL362SerialStream.h"
+
+// Binary serial streaming for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+static_assert(sizeof(ADXL362SerialStreamBase::PacketHeader) == 16, "PacketHeader must be 16 bytes");
+
+ADXL362SerialStreamBase::ADXL362SerialStreamBase(uint8_t *packetBuf, size_t packetBufSize) : packetBuf(packetBuf), packetBufSize(packetBufSize) {
+	maxSamplesPerPacket = packetBufSize / 8;
+	while(maxSamplesPerPacket > 0 && encodedPacketSize(maxSamplesPerPacket) > packetBufSize) {
+		maxSamplesPerPacket--;
+	}
+}
+
+ADXL362SerialStreamBase::~ADXL362SerialStreamBase() {
+}
+
+void ADXL362SerialStreamBase::begin(Print &out, const ADXL362DMA &accel, uint8_t type) {
+	this->out = &out;
+	this->type = type;
+	rateTenthsHz = (uint16_t)(accel.getOutputDataRate() * 10.0 + 0.5);
+	rangeG = accel.getRangeG();
+
+	sequence = 0;
+	sampleNum = 0;
+	packetsSent = droppedPackets = bytesSent = 0;
+}
+
+size_t ADXL362SerialStreamBase::write(const ADXL362DataBase &data) {
+	size_t result = 0;
+
+	for(size_t first = 0; first < data.numSamplesRead; first += maxSamplesPerPacket) {
+		size_t count = data.numSamplesRead - first;
+		if (count > maxSamplesPerPacket) {
+			count = maxSamplesPerPacket;
+		}
+		result += writePacket(data, first, count);
+	}
+	return result;
+}
+
+size_t ADXL362SerialStreamBase::writePacket(const ADXL362DataBase &data, size_t first, size_t count) {
+	if (!out || count == 0) {
+		return 0;
+	}
+
+	PacketHeader header;
+	memset(&header, 0, sizeof(header));
+	header.type = type;
+	header.flags = data.storeTemp ? FLAG_TEMP : 0;
+	header.sequence = sequence++;
+	header.firstSample = sampleNum;
+	header.numSamples = (uint16_t)count;
+	header.rateTenthsHz = rateTenthsHz;
+	header.rangeG = rangeG;
+
+	sampleNum += (uint32_t)count;
+
+	encodeBegin();
+	encodeBytes((const uint8_t *)&header, sizeof(header));
+
+	if (type == TYPE_RAW) {
+		encodeBytes(&data.buf[data.startOffset + first * data.sampleSizeInBytes], count * data.sampleSizeInBytes);
+	}
+	else {
+		for(size_t ii = first; ii < first + count; ii++) {
+			ADXL362Sample sample;
+			data.readSample(ii, sample);
+
+			int16_t values[4] = { sample.x, sample.y, sample.z, sample.t };
+			uint8_t bytes[8];
+			for(size_t axis = 0; axis < 4; axis++) {
+				bytes[axis * 2] = (uint8_t)((uint16_t)values[axis] & 0xff);
+				bytes[axis * 2 + 1] = (uint8_t)((uint16_t)values[axis] >> 8);
+			}
+			encodeBytes(bytes, data.storeTemp ? 8 : 6);
+		}
+	}
+
+	size_t len = encodeEnd();
+
+	size_t written = out->write(packetBuf, len);
+	bytesSent += (uint32_t)written;
+	if (written == len) {
+		packetsSent++;
+	}
+	else {
+		droppedPackets++;
+	}
+	return written;
+}
+
+void ADXL362SerialStreamBase::encodeBegin() {
+	crc = 0xffff;
+	codeIndex = 0;
+	code = 1;
+	encodedLen = 1;
+}
+
+void ADXL362SerialStreamBase::encodeBytes(const uint8_t *data, size_t len) {
+	crc = crc16(data, len, crc);
+
+	for(size_t ii = 0; ii < len; ii++) {
+		if (data[ii] == 0) {
+			packetBuf[codeIndex] = code;
+			codeIndex = encodedLen++;
+			code = 1;
+		}
+		else {
+			packetBuf[encodedLen++] = data[ii];
+			if (++code == 0xff) {
+				// Maximum block of 254 non-zero bytes
+				packetBuf[codeIndex] = code;
+				codeIndex = encodedLen++;
+				code = 1;
+			}
+		}
+	}
+}
+
+size_t ADXL362SerialStreamBase::encodeEnd() {
+	uint8_t crcBytes[2] = { (uint8_t)(crc & 0xff), (uint8_t)(crc >> 8) };
+	encodeBytes(crcBytes, sizeof(crcBytes));
+
+	packetBuf[codeIndex] = code;
+	packetBuf[encodedLen++] = 0;
+	return encodedLen;
+}
+
+// [static]
+bool ADXL362SerialStreamBase::cobsDecode(const uint8_t *in, size_t len, uint8_t *out, size_t &outLen) {
+	size_t ii = 0;
+	outLen = 0;
+
+	while(ii < len) {
+		uint8_t blockCode = in[ii++];
+		if (blockCode == 0) {
+			return false;
+		}
+		for(uint8_t jj = 1; jj < blockCode; jj++) {
+			if (ii >= len || in[ii] == 0) {
+				return false;
+			}
+			out[outLen++] = in[ii++];
+		}
+		if (blockCode != 0xff && ii < len) {
+			out[outLen++] = 0;
+		}
+	}
+	return true;
+}
+
+// [static]
+uint16_t ADXL362SerialStreamBase::crc16(const uint8_t *data, size_t len, uint16_t crc) {
+	for(size_t ii = 0; ii < len; ii++) {
+		crc ^= (uint16_t)data[ii] << 8;
+		for(int bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+// [static]
+bool ADXL362SerialStreamBase::parsePacket(const uint8_t *packet, size_t len, PacketHeader &header, const uint8_t *&payload) {
+	if (len < sizeof(PacketHeader) + 2) {
+		return false;
+	}
+	uint16_t expectedCrc = (uint16_t)(packet[len - 2] | (packet[len - 1] << 8));
+	if (crc16(packet, len - 2) != expectedCrc) {
+		return false;
+	}
+
+	memcpy(&header, packet, sizeof(PacketHeader));
+	size_t sampleSize = (header.flags & FLAG_TEMP) ? 8 : 6;
+	if (sizeof(PacketHeader) + header.numSamples * sampleSize + 2 != len) {
+		return false;
+	}
+	if (header.type != TYPE_RAW && header.type != TYPE_DECODED) {
+		return false;
+	}
+
+	payload = &packet[sizeof(PacketHeader)];
+	return true;
+}
+
+// [static]
+void ADXL362SerialStreamBase::readSample(const PacketHeader &header, const uint8_t *payload, size_t index, ADXL362Sample &sample) {
+	bool storeTemp = (header.flags & FLAG_TEMP) != 0;
+	const uint8_t *p = &payload[index * (storeTemp ? 8 : 6)];
+
+	if (header.type == TYPE_RAW) {
+		ADXL362DataBase::decodeSample(p, storeTemp, sample);
+	}
+	else {
+		sample.x = (int16_t)(p[0] | (p[1] << 8));
+		sample.y = (int16_t)(p[2] | (p[3] << 8));
+		sample.z = (int16_t)(p[4] | (p[5] << 8));
+		sample.t = storeTemp ? (int16_t)(p[6] | (p[7] << 8)) : 0;
+	}
+}
@@ -0,0 +1,232 @@
+#ifndef __ADXL362SERIALSTREAM_H
+#define __ADXL362SERIALSTREAM_H
+
+// Binary serial streaming for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+
+/**
+ * @brief Streams FIFO buffers as COBS-framed binary packets, typically over USB serial
+ *
+ * Formatting every sample as text with Serial.printlnf() takes most of the CPU at 400 Hz and
+ * sends about 18 bytes per sample. A binary packet sends 6 bytes per sample (8 with temperature)
+ * plus an 18 byte header and CRC per packet, and takes very little CPU.
+ *
+ * Each packet is a PacketHeader, the payload, and a CRC-16/CCITT (little endian) of the header and
+ * payload. The whole packet is COBS (Consistent Overhead Byte Stuffing) encoded, so it contains no
+ * 0 bytes, and followed by a 0 byte. A reader that starts in the middle of the stream, or loses
+ * bytes, resynchronizes at the next 0 byte. The sequence number detects lost packets and
+ * firstSample detects lost samples.
+ *
+ * The payload is either TYPE_RAW, the FIFO bytes from the buffer starting at the first whole
+ * sample (decode with ADXL362DataBase::decodeSample()), or TYPE_DECODED, signed 16-bit little
+ * endian X, Y, Z (and T) values. Both are the same size; TYPE_RAW takes less CPU on the device.
+ *
+ * The host/serialreader tool reads the stream and writes CSV or binary files.
+ *
+ * You will not allocate one of these directly; use ADXL362SerialStream, which allocates the buffer.
+ */
+class ADXL362SerialStreamBase {
+public:
+	/**
+	 * @brief Header at the start of each packet, before encoding
+	 *
+	 * The layout is fixed (little endian, 16 bytes) because it's decoded by the host.
+	 */
+	struct PacketHeader {
+		uint8_t type;			//!< TYPE_RAW or TYPE_DECODED
+		uint8_t flags;			//!< FLAG_TEMP if the samples include temperature
+		uint16_t sequence;		//!< Packet number since begin(), wraps at 65535
+		uint32_t firstSample;	//!< Sample number of the first sample in the packet, since begin()
+		uint16_t numSamples;	//!< Number of samples in the payload
+		uint16_t rateTenthsHz;	//!< Output data rate in 0.1 Hz units (4000 = 400 Hz)
+		uint8_t rangeG;			//!< Range in g (2, 4, or 8)
+		uint8_t reserved[3];	//!< Always 0
+	} __attribute__((packed));
+
+	/**
+	 * @brief Constructor - You will not allocate one of these directly
+	 *
+	 * @param packetBuf Buffer for one encoded packet
+	 *
+	 * @param packetBufSize Size of packetBuf in bytes
+	 */
+	ADXL362SerialStreamBase(uint8_t *packetBuf, size_t packetBufSize);
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362SerialStreamBase();
+
+	/**
+	 * @brief Set where to send packets, and the settings to put in the packet headers
+	 *
+	 * @param out Where to write the packets, typically Serial
+	 *
+	 * @param accel The driver, for the output data rate and range
+	 *
+	 * @param type TYPE_RAW (default) or TYPE_DECODED
+	 *
+	 * Resets the sequence and sample numbers.
+	 */
+	void begin(Print &out, const ADXL362DMA &accel, uint8_t type = TYPE_RAW);
+
+	/**
+	 * @brief Send the samples in a completed buffer, in as many packets as necessary
+	 *
+	 * @return The number of bytes written
+	 *
+	 * If the output does not accept a whole packet (for example, USB serial is not connected and
+	 * does not block), the packet is counted in getDroppedPackets(). The sample numbers still count
+	 * the samples in it, so the reader sees the gap.
+	 */
+	size_t write(const ADXL362DataBase &data);
+
+	/**
+	 * @brief Returns the number of packets sent since begin()
+	 */
+	uint32_t getPacketsSent() const { return packetsSent; };
+
+	/**
+	 * @brief Returns the number of packets the output did not accept since begin()
+	 */
+	uint32_t getDroppedPackets() const { return droppedPackets; };
+
+	/**
+	 * @brief Returns the number of bytes written since begin()
+	 */
+	uint32_t getBytesSent() const { return bytesSent; };
+
+	/**
+	 * @brief Returns the maximum number of samples in one packet
+	 */
+	size_t getMaxSamplesPerPacket() const { return maxSamplesPerPacket; };
+
+	/**
+	 * @brief Returns the encoded size of a packet with maxSamples samples of 8 bytes, including the delimiter
+	 */
+	static constexpr size_t encodedPacketSize(size_t maxSamples) {
+		return (sizeof(PacketHeader) + maxSamples * 8 + 2) + (sizeof(PacketHeader) + maxSamples * 8 + 2) / 254 + 2;
+	}
+
+	/**
+	 * @brief Decode a COBS-encoded packet, not including the 0 delimiter
+	 *
+	 * @param in Encoded bytes
+	 *
+	 * @param len Number of encoded bytes
+	 *
+	 * @param out Buffer for the decoded bytes, at least len bytes. Can be the same as in.
+	 *
+	 * @param outLen Filled in with the number of decoded bytes
+	 *
+	 * @return true if the encoding was valid
+	 */
+	static bool cobsDecode(const uint8_t *in, size_t len, uint8_t *out, size_t &outLen);
+
+	/**
+	 * @brief Calculate a CRC-16/CCITT (polynomial 0x1021, initial value 0xffff)
+	 *
+	 * @param crc The initial value, or the result of a previous call to continue the calculation
+	 */
+	static uint16_t crc16(const uint8_t *data, size_t len, uint16_t crc = 0xffff);
+
+	/**
+	 * @brief Check and parse a decoded packet
+	 *
+	 * @param packet Decoded packet (from cobsDecode())
+	 *
+	 * @param len Number of bytes in packet
+	 *
+	 * @param header Filled in with the header
+	 *
+	 * @param payload Filled in with a pointer to the payload in packet
+	 *
+	 * @return true if the length and CRC are valid
+	 */
+	static bool parsePacket(const uint8_t *packet, size_t len, PacketHeader &header, const uint8_t *&payload);
+
+	/**
+	 * @brief Read one sample from the payload of a packet
+	 *
+	 * @param header The packet header, from parsePacket()
+	 *
+	 * @param payload The payload, from parsePacket()
+	 *
+	 * @param index Sample index, 0 <= index < header.numSamples
+	 *
+	 * @param sample Filled in with the sample. t is 0 if the packet does not include temperature.
+	 */
+	static void readSample(const PacketHeader &header, const uint8_t *payload, size_t index, ADXL362Sample &sample);
+
+	static const uint8_t TYPE_RAW = 1;		//!< Payload is raw FIFO bytes
+	static const uint8_t TYPE_DECODED = 2;	//!< Payload is int16_t X, Y, Z (and T) values
+
+	static const uint8_t FLAG_TEMP = 0x01;	//!< Samples include temperature
+
+protected:
+	/**
+	 * @brief Encode and send one packet
+	 */
+	size_t writePacket(const ADXL362DataBase &data, size_t first, size_t count);
+
+	/**
+	 * @brief Start a packet in packetBuf
+	 */
+	void encodeBegin();
+
+	/**
+	 * @brief Add bytes to the packet, updating the CRC and COBS encoding
+	 */
+	void encodeBytes(const uint8_t *data, size_t len);
+
+	/**
+	 * @brief Add the CRC and delimiter
+	 *
+	 * @return The length of the encoded packet
+	 */
+	size_t encodeEnd();
+
+	uint8_t *packetBuf; //!< Buffer for one encoded packet
+	size_t packetBufSize; //!< Size of packetBuf in bytes
+	size_t maxSamplesPerPacket; //!< Samples that fit in packetBuf
+	Print *out = nullptr; //!< Where packets are written
+	uint8_t type = TYPE_RAW; //!< TYPE_RAW or TYPE_DECODED
+	uint16_t rateTenthsHz = 0; //!< Output data rate for the header
+	uint8_t rangeG = 2; //!< Range for the header
+
+	uint16_t sequence = 0; //!< Next packet number
+	uint32_t sampleNum = 0; //!< Next sample number
+	uint32_t packetsSent = 0; //!< Packets sent
+	uint32_t droppedPackets = 0; //!< Packets not accepted by the output
+	uint32_t bytesSent = 0; //!< Bytes written
+
+	size_t encodedLen = 0; //!< Bytes in packetBuf
+	size_t codeIndex = 0; //!< Offset of the current COBS code byte
+	uint8_t code = 1; //!< Current COBS code
+	uint16_t crc = 0xffff; //!< CRC of the bytes so far
+};
+
+/**
+ * @brief Binary serial stream
+ *
+ * @param MAX_SAMPLES_PER_PACKET The largest number of samples in a packet. A buffer with more
+ * samples is sent in multiple packets. The packet buffer is about 8 bytes per sample.
+ */
+template <size_t MAX_SAMPLES_PER_PACKET = 64>
+class ADXL362SerialStream : public ADXL362SerialStreamBase {
+public:
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362SerialStream() : ADXL362SerialStreamBase(staticPacketBuf, sizeof(staticPacketBuf)) {};
+
+	/**
+	 * @brief Buffer for one encoded packet
+	 */
+	uint8_t staticPacketBuf[encodedPacketSize(MAX_SAMPLES_PER_PACKET)];
+};
+
+#endif /* __ADXL362SERIALSTREAM_H */
@@ -0,0 +1,149 @@
+#include "Particle.h"
+
+#include "ADXL362ShockDetector.h"
+#include "ADXL362Dsp.h"
+
+// Free-fall and shock event detection for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+ADXL362ShockDetectorBase::ADXL362ShockDetectorBase(ADXL362Sample *ring, uint16_t ringSize) : ring(ring), ringSize(ringSize) {
+	reset();
+}
+
+ADXL362ShockDetectorBase::~ADXL362ShockDetectorBase() {
+}
+
+void ADXL362ShockDetectorBase::setFreeFallThreshold(uint16_t counts, uint16_t minSamples) {
+	freeFallThresholdSq = (uint32_t)counts * (uint32_t)counts;
+	freeFallMinSamples = (minSamples > 0) ? minSamples : 1;
+}
+
+void ADXL362ShockDetectorBase::setShockThreshold(uint16_t counts) {
+	shockThresholdSq = (uint32_t)counts * (uint32_t)counts;
+}
+
+void ADXL362ShockDetectorBase::process(const ADXL362DataBase &data) {
+	ADXL362Sample sample;
+
+	for(size_t ii = 0; ii < data.numSamplesRead; ii++) {
+		data.readSample(ii, sample);
+		processSample(sample);
+	}
+}
+
+void ADXL362ShockDetectorBase::processSample(const ADXL362Sample &sample) {
+	ring[sampleIndex % ringSize] = sample;
+
+	uint32_t magSq = ADXL362Dsp::magnitudeSq(sample.x, sample.y, sample.z);
+
+	if (!inEvent) {
+		if (shockThresholdSq && magSq > shockThresholdSq) {
+			if (postPending) {
+				// New event before the post-context of the previous one was complete
+				emit();
+			}
+			record.type = EventType::SHOCK;
+			record.startSample = sampleIndex;
+			record.peakMagnitudeSq = magSq;
+			inEvent = true;
+		}
+		else
+		if (freeFallThresholdSq && magSq < freeFallThresholdSq) {
+			if (freeFallCount == 0 || magSq < freeFallMinSq) {
+				freeFallMinSq = magSq;
+			}
+			freeFallCount++;
+			if (freeFallCount >= freeFallMinSamples) {
+				if (postPending) {
+					emit();
+				}
+				record.type = EventType::FREE_FALL;
+				record.startSample = sampleIndex + 1 - freeFallCount;
+				record.peakMagnitudeSq = freeFallMinSq;
+				inEvent = true;
+			}
+		}
+		else {
+			freeFallCount = 0;
+		}
+	}
+	else {
+		bool ended;
+		if (record.type == EventType::SHOCK) {
+			ended = (magSq <= shockThresholdSq);
+			if (!ended && magSq > record.peakMagnitudeSq) {
+				record.peakMagnitudeSq = magSq;
+			}
+		}
+		else {
+			ended = (magSq >= freeFallThresholdSq);
+			if (!ended && magSq < record.peakMagnitudeSq) {
+				record.peakMagnitudeSq = magSq;
+			}
+		}
+		if (ended) {
+			record.durationSamples = sampleIndex - record.startSample;
+			inEvent = false;
+			freeFallCount = 0;
+			postPending = true;
+			postRemaining = postSamples;
+		}
+	}
+
+	sampleIndex++;
+
+	if (postPending) {
+		if (postRemaining > 0) {
+			postRemaining--;
+		}
+		if (postRemaining == 0) {
+			emit();
+		}
+	}
+}
+
+void ADXL362ShockDetectorBase::emit() {
+	postPending = false;
+
+	uint32_t start = (record.startSample > preSamples) ? (record.startSample - preSamples) : 0;
+	if (sampleIndex > ringSize && start < sampleIndex - ringSize) {
+		// Event was longer than the ring buffer, keep the most recent samples
+		start = sampleIndex - ringSize;
+	}
+	uint32_t count = sampleIndex - start;
+
+	record.contextStart = start;
+	record.contextCount = (uint16_t) ((count > 0xffff) ? 0xffff : count);
+
+	if (callback) {
+		callback(record);
+	}
+}
+
+bool ADXL362ShockDetectorBase::readContext(uint16_t index, ADXL362Sample &sample) const {
+	if (index >= record.contextCount) {
+		return false;
+	}
+	uint32_t sampleNum = record.contextStart + index;
+	if (sampleNum >= sampleIndex || (sampleIndex > ringSize && sampleNum < sampleIndex - ringSize)) {
+		return false;
+	}
+	sample = ring[sampleNum % ringSize];
+	return true;
+}
+
+void ADXL362ShockDetectorBase::reset() {
+	sampleIndex = 0;
+	freeFallCount = 0;
+	freeFallMinSq = 0;
+	inEvent = false;
+	postPending = false;
+	postRemaining = 0;
+	record = EventRecord();
+	memset(ring, 0, ringSize * sizeof(ADXL362Sample));
+}
+
+// [static]
+uint16_t ADXL362ShockDetectorBase::isqrt(uint32_t value) {
+	return ADXL362Dsp::isqrt(value);
+}
@@ -0,0 +1,178 @@
+#ifndef __ADXL362SHOCKDETECTOR_H
+#define __ADXL362SHOCKDETECTOR_H
+
+// Free-fall and shock event detection for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+
+#include <functional>
+
+/**
+ * @brief Free-fall and shock detector with peak and duration capture
+ *
+ * Detection uses the squared magnitude of each sample (x*x + y*y + z*z) in integer math, without
+ * a square root. A free-fall event is the magnitude staying below the free-fall threshold for at
+ * least the minimum number of samples. A shock event is the magnitude exceeding the shock threshold.
+ *
+ * The most recent samples are kept in a ring buffer so each event record includes raw samples
+ * from before the event (pre-context) and after it (post-context). This works with the FIFO in
+ * FIFO_STREAM mode; with FIFO_TRIGGERED mode the ADXL362 keeps its own pre-trigger samples and
+ * the ring only needs to hold the event and post-context.
+ *
+ * You will not allocate one of these directly; use ADXL362ShockDetector, which allocates the ring buffer.
+ */
+class ADXL362ShockDetectorBase {
+public:
+	/**
+	 * @brief Type of event
+	 */
+	enum class EventType {
+		FREE_FALL,			//!< Magnitude below the free-fall threshold
+		SHOCK				//!< Magnitude above the shock threshold
+	};
+
+	/**
+	 * @brief Event record passed to the callback
+	 */
+	struct EventRecord {
+		EventType type;				//!< FREE_FALL or SHOCK
+		uint32_t startSample;		//!< Sample number where the event started, counted from reset()
+		uint32_t durationSamples;	//!< Number of samples in the event
+		uint32_t peakMagnitudeSq;	//!< Squared magnitude, the maximum for SHOCK or minimum for FREE_FALL
+		uint32_t contextStart;		//!< Sample number of the first context sample available from readContext()
+		uint16_t contextCount;		//!< Number of context samples available from readContext()
+	};
+
+	/**
+	 * @brief Constructor - You will not allocate one of these directly
+	 *
+	 * @param ring Ring buffer storage
+	 *
+	 * @param ringSize Number of samples in the ring buffer
+	 */
+	ADXL362ShockDetectorBase(ADXL362Sample *ring, uint16_t ringSize);
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362ShockDetectorBase();
+
+	/**
+	 * @brief Set the free-fall threshold and minimum duration
+	 *
+	 * @param counts Magnitude in counts. Free fall is typically below 300 - 400 mg. At RANGE_2G 1 count is 1 mg.
+	 *
+	 * @param minSamples The number of consecutive samples below the threshold for free fall. At 400 Hz, a 10 cm
+	 * drop is about 56 samples.
+	 *
+	 * The default is 0, which disables free-fall detection.
+	 */
+	void setFreeFallThreshold(uint16_t counts, uint16_t minSamples);
+
+	/**
+	 * @brief Set the shock threshold
+	 *
+	 * @param counts Magnitude in counts. At RANGE_8G 1 count is 4 mg. The default is 0, which disables shock detection.
+	 */
+	void setShockThreshold(uint16_t counts);
+
+	/**
+	 * @brief Set the number of samples before the event to include in the record (default: 16)
+	 */
+	void setPreSamples(uint16_t samples) { preSamples = samples; };
+
+	/**
+	 * @brief Set the number of samples after the event to include in the record (default: 16)
+	 */
+	void setPostSamples(uint16_t samples) { postSamples = samples; };
+
+	/**
+	 * @brief Set the function to call when an event is complete, including the post-context
+	 *
+	 * The callback is called from process(). The context samples can be read using readContext()
+	 * until process() or processSample() is called again.
+	 */
+	void setCallback(std::function<void(const EventRecord &record)> callback) { this->callback = callback; };
+
+	/**
+	 * @brief Process all of the samples in a completed FIFO buffer
+	 *
+	 * @param data A buffer in STATE_READ_COMPLETE state
+	 */
+	void process(const ADXL362DataBase &data);
+
+	/**
+	 * @brief Process a single sample
+	 *
+	 * @param sample The sample to process
+	 */
+	void processSample(const ADXL362Sample &sample);
+
+	/**
+	 * @brief Read a context sample for the event being reported
+	 *
+	 * @param index 0 to contextCount - 1
+	 *
+	 * @param sample Filled in with the sample
+	 *
+	 * @return true if the sample was available
+	 */
+	bool readContext(uint16_t index, ADXL362Sample &sample) const;
+
+	/**
+	 * @brief Reset the detector state and clear the ring buffer
+	 */
+	void reset();
+
+	/**
+	 * @brief Integer square root, for converting peakMagnitudeSq to counts when reporting
+	 */
+	static uint16_t isqrt(uint32_t value);
+
+protected:
+	/**
+	 * @brief Call the callback for the current event and clear it
+	 */
+	void emit();
+
+	ADXL362Sample *ring; //!< Ring buffer storage
+	uint16_t ringSize; //!< Number of samples in ring
+	uint32_t freeFallThresholdSq = 0; //!< Squared free-fall threshold, 0 = disabled
+	uint16_t freeFallMinSamples = 0; //!< Minimum free-fall duration
+	uint32_t shockThresholdSq = 0; //!< Squared shock threshold, 0 = disabled
+	uint16_t preSamples = 16; //!< Context before the event
+	uint16_t postSamples = 16; //!< Context after the event
+	std::function<void(const EventRecord &record)> callback = nullptr; //!< Callback function
+
+	uint32_t sampleIndex = 0; //!< Samples processed since reset()
+	uint32_t freeFallCount = 0; //!< Consecutive samples below the free-fall threshold
+	uint32_t freeFallMinSq = 0; //!< Minimum squared magnitude during the current free fall
+	bool inEvent = false; //!< An event is in progress
+	bool postPending = false; //!< An event ended and is collecting post-context
+	uint32_t postRemaining = 0; //!< Post-context samples still to collect
+	EventRecord record; //!< Event in progress
+};
+
+/**
+ * @brief Free-fall and shock detector with a ring buffer for context samples
+ *
+ * @param RING_SIZE Number of samples in the ring buffer. This should be at least pre-samples +
+ * post-samples + the longest event you want to capture in full. Each sample is 8 bytes.
+ */
+template <uint16_t RING_SIZE>
+class ADXL362ShockDetector : public ADXL362ShockDetectorBase {
+public:
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362ShockDetector() : ADXL362ShockDetectorBase(staticRing, RING_SIZE) {};
+
+	/**
+	 * @brief Ring buffer storage
+	 */
+	ADXL362Sample staticRing[RING_SIZE];
+};
+
+#endif /* __ADXL362SHOCKDETECTOR_H */
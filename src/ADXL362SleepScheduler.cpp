@@ -0,0 +1,122 @@
+#include "Particle.h"
+
+#include "ADXL362SleepScheduler.h"
+
+// Deep sleep FIFO accumulation scheduler for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+ADXL362SleepScheduler::ADXL362SleepScheduler(ADXL362DMA &accel) : accel(accel) {
+}
+
+ADXL362SleepScheduler::~ADXL362SleepScheduler() {
+}
+
+uint32_t ADXL362SleepScheduler::configure(size_t bufSize, int intPin) {
+	calculate(bufSize, accel.getStoreTemp());
+
+	accel.writeFifoControlAndSamples(watermarkEntries, accel.getStoreTemp(), ADXL362DMA::FIFO_STREAM);
+
+	if (intPin == 2) {
+		accel.writeIntmap2(accel.getShadowRegister(ADXL362DMA::REG_FIFO_INTMAP2) | ADXL362DMA::INTMAP_FIFO_WATERMARK);
+	}
+	else {
+		accel.writeIntmap1(accel.getShadowRegister(ADXL362DMA::REG_FIFO_INTMAP1) | ADXL362DMA::INTMAP_FIFO_WATERMARK);
+	}
+
+	return sleepIntervalMs;
+}
+
+uint32_t ADXL362SleepScheduler::calculate(size_t bufSize, bool storeTemp) {
+	sampleSizeInBytes = storeTemp ? 8 : 6;
+	size_t entriesPerSample = sampleSizeInBytes / 2;
+
+	float odr = accel.getOutputDataRate();
+
+	// FIFO capacity in samples, less the safety margin
+	size_t capacitySamples = (ADXL362DMA::FIFO_NUM_ENTRIES - 1) / entriesPerSample;
+
+	size_t marginSamples = (capacitySamples * safetyMarginPercent + 99) / 100;
+	marginSamples += (size_t) ceilf(odr * (float)wakeLatencyMs / 1000.0);
+
+	size_t samples = (marginSamples < capacitySamples) ? (capacitySamples - marginSamples) : 1;
+
+	// One buffer must be able to hold the watermark, including a partial sample carried over
+	size_t bufSamples = (bufSize > sampleSizeInBytes) ? ((bufSize - sampleSizeInBytes) / sampleSizeInBytes) : 1;
+	if (samples > bufSamples) {
+		samples = bufSamples;
+	}
+	if (samples < 1) {
+		samples = 1;
+	}
+
+	watermarkSamples = (uint16_t) samples;
+	watermarkEntries = (uint16_t) (samples * entriesPerSample);
+	fillTimeMs = (uint32_t) ((float)samples * 1000.0 / odr);
+	sleepIntervalMs = fillTimeMs + (uint32_t)(((uint64_t)fillTimeMs * timeoutMarginPercent + 99) / 100);
+
+	return sleepIntervalMs;
+}
+
+bool ADXL362SleepScheduler::drain(ADXL362DataBase *data) {
+	// Reading a fixed count of entries is only safe once the FIFO has them
+	if ((accel.readStatus() & ADXL362DMA::STATUS_FIFO_WATERMARK) == 0) {
+		return false;
+	}
+	accel.readFifoAsync(data, watermarkEntries);
+	return true;
+}
+
+void ADXL362SleepScheduler::wakeStart() {
+	if (!awake) {
+		if (haveSleepStart) {
+			asleepUs += (uint64_t)(millis() - lastSleepMs) * 1000;
+		}
+		awake = true;
+	}
+	lastWakeUs = micros();
+	wakeCount++;
+}
+
+void ADXL362SleepScheduler::sleepStart() {
+	if (awake && wakeCount > 0) {
+		awakeUs += (uint32_t)(micros() - lastWakeUs);
+	}
+	awake = false;
+	haveSleepStart = true;
+	lastSleepMs = millis();
+}
+
+uint32_t ADXL362SleepScheduler::getEstimatedAwakeUs() const {
+	// drain() reads STATUS (3 byte transaction), then the FIFO read command byte plus the watermark
+	// data, 8 bits per byte
+	uint64_t bits = (3 + 1 + (uint64_t)watermarkSamples * sampleSizeInBytes) * 8;
+
+	return wakeOverheadUs + (uint32_t)((bits * 1000000) / spiClockHz);
+}
+
+float ADXL362SleepScheduler::getEstimatedDutyCycle() const {
+	if (fillTimeMs == 0) {
+		return 1.0;
+	}
+	float awakeTime = (float)getEstimatedAwakeUs();
+	float period = (float)fillTimeMs * 1000.0;
+	if (awakeTime >= period) {
+		return 1.0;
+	}
+	return awakeTime / period;
+}
+
+float ADXL362SleepScheduler::getMeasuredDutyCycle() const {
+	uint64_t total = awakeUs + asleepUs;
+	if (asleepUs == 0 || total == 0) {
+		return 0.0;
+	}
+	return (float)awakeUs / (float)total;
+}
+
+void ADXL362SleepScheduler::resetStats() {
+	awakeUs = asleepUs = 0;
+	wakeCount = 0;
+	haveSleepStart = false;
+	awake = true;
+}
@@ -0,0 +1,204 @@
+#ifndef __ADXL362SLEEPSCHEDULER_H
+#define __ADXL362SLEEPSCHEDULER_H
+
+// Deep sleep FIFO accumulation scheduler for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+
+/**
+ * @brief Computes how long the MCU can sleep while the ADXL362 fills its FIFO
+ *
+ * The ADXL362 FIFO holds 512 16-bit entries, which is 170 XYZ samples or 128 XYZT samples. At low
+ * output data rates this is many seconds of data, so the MCU can sleep until the FIFO watermark
+ * interrupt fires and then drain the whole FIFO with a single readFifoAsync().
+ *
+ * The watermark is the FIFO capacity less a safety margin (a percentage of the FIFO, plus the number
+ * of samples that arrive during the MCU wake latency) and is limited so one buffer can hold it.
+ *
+ * Usage:
+ *
+ * - Configure the sample rate, range, and storeTemp using the ADXL362DMA object
+ * - Call configure() to set the FIFO watermark and map the watermark interrupt to INT1 or INT2
+ * - Sleep until the INT pin rises, with getSleepIntervalMs() as a timeout in case the interrupt is missed
+ * - Call wakeStart() after waking, then drain() to read the FIFO if it has reached the watermark
+ * - Call sleepStart() before going back to sleep
+ */
+class ADXL362SleepScheduler {
+public:
+	/**
+	 * @brief Construct a scheduler for an accelerometer
+	 *
+	 * @param accel The ADXL362DMA object. The sample rate and storeTemp are read from its shadow registers.
+	 */
+	ADXL362SleepScheduler(ADXL362DMA &accel);
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362SleepScheduler();
+
+	/**
+	 * @brief Set the safety margin as a percentage of the FIFO capacity (default: 10)
+	 *
+	 * @param percent 0 - 90
+	 */
+	void setSafetyMarginPercent(uint8_t percent) { safetyMarginPercent = percent; };
+
+	/**
+	 * @brief Set the worst-case time from the watermark interrupt until the FIFO read starts (default: 50 ms)
+	 *
+	 * @param ms Wake latency in milliseconds. Samples that arrive during this time are added to the safety margin.
+	 */
+	void setWakeLatencyMs(uint32_t ms) { wakeLatencyMs = ms; };
+
+	/**
+	 * @brief Set the SPI clock speed used to estimate the transfer time (default: 4 MHz)
+	 *
+	 * @param hz SPI clock in Hz. This should match the SPISettings passed to the ADXL362DMA constructor.
+	 */
+	void setSpiClockHz(uint32_t hz) { spiClockHz = hz; };
+
+	/**
+	 * @brief Set the time the MCU is awake for each drain, excluding the SPI transfer (default: 2000 us)
+	 *
+	 * @param us Time in microseconds. This is used for getEstimatedDutyCycle().
+	 */
+	void setWakeOverheadUs(uint32_t us) { wakeOverheadUs = us; };
+
+	/**
+	 * @brief Set how much longer than the FIFO fill time the sleep timeout is (default: 20)
+	 *
+	 * @param percent Percentage of getFillTimeMs() added to get getSleepIntervalMs(). The output data
+	 * rate is only accurate to about 10%, so a timeout of exactly the fill time often expires before
+	 * the watermark interrupt.
+	 */
+	void setTimeoutMarginPercent(uint8_t percent) { timeoutMarginPercent = percent; };
+
+	/**
+	 * @brief Calculate the watermark and sleep interval, and configure the FIFO and interrupt
+	 *
+	 * @param bufSize The size of the ADXL362DataBase buffer that will be passed to drain(), in bytes
+	 *
+	 * @param intPin 1 to map the FIFO watermark interrupt to INT1 or 2 for INT2
+	 *
+	 * @return The sleep timeout in milliseconds
+	 *
+	 * This sets the FIFO to FIFO_STREAM mode and adds INTMAP_FIFO_WATERMARK to the existing interrupt
+	 * mapping for the selected pin (from the shadow registers). Call this after setting the sample rate
+	 * and whether to store temperature.
+	 */
+	uint32_t configure(size_t bufSize, int intPin = 1);
+
+	/**
+	 * @brief Calculate the watermark and sleep interval without writing any registers
+	 *
+	 * @param bufSize The size of the ADXL362DataBase buffer that will be passed to drain(), in bytes
+	 *
+	 * @param storeTemp Whether the FIFO will store XYZT (true) or XYZ (false) samples
+	 *
+	 * @return The sleep timeout in milliseconds
+	 */
+	uint32_t calculate(size_t bufSize, bool storeTemp);
+
+	/**
+	 * @brief Read the FIFO up to the watermark with a single readFifoAsync(), if it has reached the watermark
+	 *
+	 * @param data Buffer to read into, at least the bufSize passed to configure()
+	 *
+	 * @return true if the read was started, false if the FIFO has not reached the watermark yet
+	 *
+	 * This reads the status register first, and only reads the FIFO when STATUS_FIFO_WATERMARK is set,
+	 * which guarantees at least getWatermarkEntries() are available. It's not set when the sleep
+	 * timeout expires before the interrupt, or on the first pass after a cold boot. In that case, go
+	 * back to sleep.
+	 */
+	bool drain(ADXL362DataBase *data);
+
+	/**
+	 * @brief Call when the MCU wakes from sleep to measure the duty cycle
+	 */
+	void wakeStart();
+
+	/**
+	 * @brief Call before the MCU goes to sleep to measure the duty cycle
+	 */
+	void sleepStart();
+
+	/**
+	 * @brief Returns the FIFO watermark in 16-bit entries (the FIFO_SAMPLES register value)
+	 */
+	uint16_t getWatermarkEntries() const { return watermarkEntries; };
+
+	/**
+	 * @brief Returns the number of XYZ or XYZT samples read for each drain
+	 */
+	uint16_t getWatermarkSamples() const { return watermarkSamples; };
+
+	/**
+	 * @brief Returns the sleep timeout in milliseconds, as calculated by configure()
+	 *
+	 * This is the fill time plus setTimeoutMarginPercent(). Use it as the sleep duration in addition
+	 * to waking on the INT pin, so a missed interrupt does not cause the FIFO to overflow
+	 * indefinitely. The INT pin normally wakes the MCU first.
+	 */
+	uint32_t getSleepIntervalMs() const { return sleepIntervalMs; };
+
+	/**
+	 * @brief Returns the nominal time for the FIFO to fill to the watermark in milliseconds
+	 */
+	uint32_t getFillTimeMs() const { return fillTimeMs; };
+
+	/**
+	 * @brief Returns the estimated MCU awake time for each drain in microseconds
+	 *
+	 * This is the wake overhead plus the SPI time for the STATUS read and the FIFO read done by drain().
+	 */
+	uint32_t getEstimatedAwakeUs() const;
+
+	/**
+	 * @brief Returns the estimated fraction of time the MCU is awake (0.0 to 1.0)
+	 */
+	float getEstimatedDutyCycle() const;
+
+	/**
+	 * @brief Returns the measured fraction of time the MCU is awake (0.0 to 1.0)
+	 *
+	 * This uses the time between wakeStart() and sleepStart() calls. Returns 0 until a complete
+	 * sleep and wake cycle has been measured.
+	 */
+	float getMeasuredDutyCycle() const;
+
+	/**
+	 * @brief Returns the number of wakes counted by wakeStart()
+	 */
+	uint32_t getWakeCount() const { return wakeCount; };
+
+	/**
+	 * @brief Clear the measured duty cycle statistics
+	 */
+	void resetStats();
+
+protected:
+	ADXL362DMA &accel; //!< Accelerometer object
+	uint8_t safetyMarginPercent = 10; //!< Safety margin as a percentage of the FIFO
+	uint32_t wakeLatencyMs = 50; //!< Wake latency in milliseconds
+	uint32_t spiClockHz = 4000000; //!< SPI clock speed
+	uint32_t wakeOverheadUs = 2000; //!< MCU awake time not including SPI transfer
+	uint16_t watermarkEntries = 0; //!< FIFO watermark in 16-bit entries
+	uint16_t watermarkSamples = 0; //!< FIFO watermark in samples
+	uint16_t sampleSizeInBytes = 6; //!< 6 (XYZ) or 8 (XYZT)
+	uint8_t timeoutMarginPercent = 20; //!< Sleep timeout beyond the fill time
+	uint32_t fillTimeMs = 0; //!< Nominal time to fill to the watermark
+	uint32_t sleepIntervalMs = 0; //!< Sleep timeout
+	uint32_t lastWakeUs = 0; //!< micros() at the last wakeStart()
+	uint32_t lastSleepMs = 0; //!< millis() at the last sleepStart(), micros() does not advance during sleep
+	uint64_t awakeUs = 0; //!< Total measured awake time
+	uint64_t asleepUs = 0; //!< Total measured sleep time
+	uint32_t wakeCount = 0; //!< Number of wakeStart() calls
+	bool awake = true; //!< true between wakeStart() and sleepStart()
+	bool haveSleepStart = false; //!< true once sleepStart() has been called
+};
+
+#endif /* __ADXL362SLEEPSCHEDULER_H */
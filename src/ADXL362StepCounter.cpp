@@ -0,0 +1,117 @@
+#include "Particle.h"
+
+#include "ADXL362StepCounter.h"
+
+// Step counter and cadence estimator for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+ADXL362StepCounter::ADXL362StepCounter() {
+}
+
+ADXL362StepCounter::~ADXL362StepCounter() {
+}
+
+void ADXL362StepCounter::begin(float sampleRate, float centerFreq) {
+	bandPass.setBandPass(sampleRate, centerFreq, 0.7);
+
+	sampleRateX16 = (uint32_t)(sampleRate * 16.0);
+
+	// 0.25 sec (240 steps per minute) to 2 sec (30 steps per minute)
+	minIntervalSamples = (uint32_t)(sampleRate / 4.0);
+	if (minIntervalSamples < 1) {
+		minIntervalSamples = 1;
+	}
+	maxIntervalSamples = (uint32_t)(sampleRate * 2.0);
+
+	prev1 = prev2 = 0;
+	peakAvg = minThreshold * 2;
+	samplesSinceStep = maxIntervalSamples;
+	intervalAvgX16 = 0;
+	pendingSteps = 0;
+	walking = false;
+	stepCount = 0;
+}
+
+void ADXL362StepCounter::process(const ADXL362DataBase &data) {
+	ADXL362Sample sample;
+
+	for(size_t ii = 0; ii < data.numSamplesRead; ii++) {
+		data.readSample(ii, sample);
+		processSample(sample.x, sample.y, sample.z);
+	}
+}
+
+void ADXL362StepCounter::processSample(int16_t x, int16_t y, int16_t z) {
+	int32_t mag = (int32_t)ADXL362Dsp::isqrt(ADXL362Dsp::magnitudeSq(x, y, z)) << INPUT_SHIFT;
+	int32_t value = bandPass.process(mag);
+
+	if (samplesSinceStep < 0xffffffff) {
+		samplesSinceStep++;
+	}
+
+	// prev1 is a local maximum
+	if (prev1 > prev2 && prev1 >= value) {
+		int32_t threshold = peakAvg / 2;
+		if (threshold < minThreshold) {
+			threshold = minThreshold;
+		}
+
+		if (prev1 > threshold && samplesSinceStep > minIntervalSamples) {
+			// Adapt to the amplitude of the user's steps
+			peakAvg += (prev1 - peakAvg) / 4;
+			stepDetected();
+		}
+	}
+
+	if (samplesSinceStep > maxIntervalSamples && (walking || pendingSteps)) {
+		// Stopped walking
+		walking = false;
+		pendingSteps = 0;
+		intervalAvgX16 = 0;
+		peakAvg = minThreshold * 2;
+	}
+
+	prev2 = prev1;
+	prev1 = value;
+}
+
+void ADXL362StepCounter::stepDetected() {
+	// The peak was at the previous sample
+	uint32_t interval = samplesSinceStep - 1;
+	bool regular = (interval <= maxIntervalSamples);
+
+	samplesSinceStep = 1;
+
+	if (!regular) {
+		// First step after a pause
+		pendingSteps = 1;
+		return;
+	}
+
+	if (intervalAvgX16 == 0) {
+		intervalAvgX16 = interval << 4;
+	}
+	else {
+		intervalAvgX16 = (intervalAvgX16 * 3 + (interval << 4)) / 4;
+	}
+
+	if (walking) {
+		stepCount++;
+	}
+	else {
+		pendingSteps++;
+		if (pendingSteps >= regularSteps) {
+			walking = true;
+			stepCount += pendingSteps;
+			pendingSteps = 0;
+		}
+	}
+}
+
+uint16_t ADXL362StepCounter::getCadence() const {
+	if (!walking || intervalAvgX16 == 0) {
+		return 0;
+	}
+	// steps/min = 60 * sampleRate / interval; both are scaled by 16
+	return (uint16_t)((60 * sampleRateX16) / intervalAvgX16);
+}
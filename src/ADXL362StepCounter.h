@@ -0,0 +1,120 @@
+#ifndef __ADXL362STEPCOUNTER_H
+#define __ADXL362STEPCOUNTER_H
+
+// Step counter and cadence estimator for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+#include "ADXL362Dsp.h"
+
+/**
+ * @brief Step counter and cadence estimator for FIFO data at low output data rates
+ *
+ * This is intended to run at 25 to 50 Hz with the FIFO watermark interrupt (see ADXL362SleepScheduler),
+ * processing a whole FIFO buffer each time the MCU wakes. Processing uses integer math only:
+ *
+ * - The magnitude of each sample, so the orientation of the device does not matter
+ * - A fixed-point band-pass filter around typical walking and running frequencies (default 2 Hz)
+ * - Peak detection with a threshold that adapts to the recent peak amplitude
+ * - Steps must be at least the minimum interval apart, and a step is only counted after several
+ *   regular steps in a row, which rejects isolated bumps
+ * - Cadence is a running average of the interval between steps
+ *
+ * The state is carried between calls to process(), so steps that span buffers are counted correctly.
+ */
+class ADXL362StepCounter {
+public:
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362StepCounter();
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362StepCounter();
+
+	/**
+	 * @brief Configure the filter and timing for a sample rate. Must be called before process().
+	 *
+	 * @param sampleRate The output data rate in Hz, typically 25 or 50. See ADXL362DMA::getOutputDataRate().
+	 *
+	 * @param centerFreq Center of the band-pass filter in Hz (default: 2.0)
+	 *
+	 * This uses floating point to calculate the coefficients but the per-sample processing does not.
+	 */
+	void begin(float sampleRate, float centerFreq = 2.0);
+
+	/**
+	 * @brief Set the minimum peak amplitude for a step in counts, after filtering (default: 60)
+	 *
+	 * At RANGE_2G this is 60 mg.
+	 */
+	void setMinThreshold(int32_t counts) { minThreshold = counts << INPUT_SHIFT; };
+
+	/**
+	 * @brief Set the number of regular steps required before counting begins (default: 4)
+	 *
+	 * The steps leading up to the count are included once counting begins.
+	 */
+	void setRegularSteps(uint8_t steps) { regularSteps = steps; };
+
+	/**
+	 * @brief Process all of the samples in a completed FIFO buffer
+	 *
+	 * @param data A buffer in STATE_READ_COMPLETE state
+	 */
+	void process(const ADXL362DataBase &data);
+
+	/**
+	 * @brief Process a single sample
+	 */
+	void processSample(int16_t x, int16_t y, int16_t z);
+
+	/**
+	 * @brief Returns the number of steps since begin() or resetStepCount()
+	 */
+	uint32_t getStepCount() const { return stepCount; };
+
+	/**
+	 * @brief Clear the step count
+	 */
+	void resetStepCount() { stepCount = 0; };
+
+	/**
+	 * @brief Returns the cadence in steps per minute, or 0 if not walking
+	 */
+	uint16_t getCadence() const;
+
+	/**
+	 * @brief Returns true if the user is currently walking (regular steps are being counted)
+	 */
+	bool isWalking() const { return walking; };
+
+	static const int INPUT_SHIFT = 4; //!< Magnitude is scaled up by 2^INPUT_SHIFT for filter precision
+
+protected:
+	/**
+	 * @brief Called when a peak passes all of the tests
+	 */
+	void stepDetected();
+
+	ADXL362Biquad bandPass; //!< Band-pass filter on the magnitude
+	uint32_t sampleRateX16 = 0; //!< Sample rate * 16 (fixed point)
+	uint32_t minIntervalSamples = 0; //!< Shortest time between steps (fastest cadence)
+	uint32_t maxIntervalSamples = 0; //!< Longest time between steps before walking stops
+	int32_t minThreshold = 60 << INPUT_SHIFT; //!< Minimum peak amplitude
+	uint8_t regularSteps = 4; //!< Steps in a row before counting
+
+	int32_t prev1 = 0; //!< Previous filtered value
+	int32_t prev2 = 0; //!< Filtered value before prev1
+	int32_t peakAvg = 0; //!< Running average of peak amplitude
+	uint32_t samplesSinceStep = 0; //!< Samples since the last step
+	uint32_t intervalAvgX16 = 0; //!< Running average of step interval in samples * 16
+	uint8_t pendingSteps = 0; //!< Regular steps seen but not yet counted
+	bool walking = false; //!< Counting steps
+	uint32_t stepCount = 0; //!< Total steps counted
+};
+
+#endif /* __ADXL362STEPCOUNTER_H */
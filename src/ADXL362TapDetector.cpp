@@ -0,0 +1,145 @@
+#include "Particle.h"
+
+#include "ADXL362TapDetector.h"
+
+// Software tap and double-tap detection for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+ADXL362TapDetector::ADXL362TapDetector() {
+	reset();
+}
+
+ADXL362TapDetector::~ADXL362TapDetector() {
+}
+
+void ADXL362TapDetector::process(const ADXL362DataBase &data) {
+	for(size_t ii = 0; ii < data.numSamplesRead; ii++) {
+		processSample(data.readX(ii), data.readY(ii), data.readZ(ii));
+	}
+}
+
+void ADXL362TapDetector::processSample(int16_t x, int16_t y, int16_t z) {
+	int32_t values[3] = { x, y, z };
+
+	if (!baselineValid) {
+		for(size_t ii = 0; ii < 3; ii++) {
+			baseline[ii] = values[ii] * (1 << baselineShift);
+		}
+		baselineValid = true;
+	}
+
+	uint8_t axes = 0;
+	int32_t peak = 0;
+	for(size_t ii = 0; ii < 3; ii++) {
+		int32_t delta = values[ii] - (baseline[ii] >> baselineShift);
+
+		uint8_t flags = axisFlags(delta, AXIS_X_POS << (ii * 2), AXIS_X_NEG << (ii * 2));
+		if (flags) {
+			axes |= flags;
+			if (delta < 0) {
+				delta = -delta;
+			}
+			if (delta > peak) {
+				peak = delta;
+			}
+		}
+
+		// Only track the baseline while not in a tap so the tap itself does not move it. A deviation
+		// that has lasted longer than the duration is not a tap (such as a change in orientation), so
+		// track it on every axis until the deviation ends.
+		if (aboveCount > duration || (!flags && aboveCount == 0)) {
+			baseline[ii] += values[ii] - (baseline[ii] >> baselineShift);
+		}
+	}
+
+	if (axes) {
+		if (aboveCount == 0) {
+			// Start of a tap
+			tapValid = (quietCount >= quiet);
+			current.axes = 0;
+			current.peak = 0;
+			current.sampleIndex = sampleIndex;
+		}
+		if (aboveCount < 0xffff) {
+			aboveCount++;
+		}
+		current.axes |= axes;
+		if (peak > current.peak) {
+			current.peak = (int16_t) ((peak > 0x7fff) ? 0x7fff : peak);
+		}
+		quietCount = 0;
+	}
+	else {
+		if (aboveCount > 0) {
+			tapEnded();
+			aboveCount = 0;
+		}
+		quietCount++;
+	}
+
+	sampleIndex++;
+
+	if (pending && (sampleIndex - first.sampleIndex) > ((uint32_t)latency + (uint32_t)window) && aboveCount == 0) {
+		// Window expired without a second tap
+		pending = false;
+		emit(EventType::TAP, first);
+	}
+}
+
+void ADXL362TapDetector::tapEnded() {
+	if (!tapValid || aboveCount > duration) {
+		// Too long or not preceded by quiet, not a tap. This also cancels a pending double tap.
+		if (pending) {
+			pending = false;
+			emit(EventType::TAP, first);
+		}
+		return;
+	}
+
+	if (window == 0) {
+		emit(EventType::TAP, current);
+		return;
+	}
+
+	if (pending) {
+		uint32_t delta = current.sampleIndex - first.sampleIndex;
+		pending = false;
+		if (delta >= latency && delta <= (uint32_t)latency + (uint32_t)window) {
+			emit(EventType::DOUBLE_TAP, first);
+			return;
+		}
+		// Second tap too soon or too late; report the first and make this one the new first tap
+		emit(EventType::TAP, first);
+	}
+
+	first = current;
+	pending = true;
+}
+
+uint8_t ADXL362TapDetector::axisFlags(int32_t delta, uint8_t posFlag, uint8_t negFlag) const {
+	if (delta > threshold && (axisMask & posFlag)) {
+		return posFlag;
+	}
+	if (delta < -threshold && (axisMask & negFlag)) {
+		return negFlag;
+	}
+	return 0;
+}
+
+void ADXL362TapDetector::emit(EventType type, const Event &tap) {
+	if (callback) {
+		Event event = tap;
+		event.type = type;
+		callback(event);
+	}
+}
+
+void ADXL362TapDetector::reset() {
+	baselineValid = false;
+	sampleIndex = 0;
+	quietCount = 0;
+	aboveCount = 0;
+	tapValid = false;
+	pending = false;
+	current = first = Event();
+}
@@ -0,0 +1,174 @@
+#ifndef __ADXL362TAPDETECTOR_H
+#define __ADXL362TAPDETECTOR_H
+
+// Software tap and double-tap detection for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+
+#include <functional>
+
+/**
+ * @brief Streaming tap and double-tap detector for FIFO data
+ *
+ * The ADXL362 does not have hardware tap detection like the ADXL345. This class detects taps in
+ * software from the FIFO samples using integer math only. The state is a fixed size, and samples
+ * are processed one at a time, so taps that span readFifoAsync() buffers are detected correctly.
+ *
+ * Gravity is removed using a slowly adapting per-axis baseline. A tap is a deviation from the
+ * baseline that exceeds the threshold on an enabled axis for no more than the duration. A longer
+ * deviation, such as a change in orientation, is not a tap, and the baseline follows it. A double
+ * tap is a second tap that starts after the latency and before the end of the window. When
+ * double tap detection is enabled, single taps are reported after the window ends.
+ *
+ * All times are in samples, so they depend on the output data rate. At 400 Hz, 1 sample is 2.5 ms.
+ */
+class ADXL362TapDetector {
+public:
+	/**
+	 * @brief Type of event passed to the callback
+	 */
+	enum class EventType {
+		TAP,				//!< Single tap
+		DOUBLE_TAP			//!< Double tap
+	};
+
+	/**
+	 * @brief Event passed to the callback
+	 */
+	struct Event {
+		EventType type;		//!< TAP or DOUBLE_TAP
+		uint8_t axes;		//!< AXIS_X_POS, AXIS_X_NEG, etc. for the axes that exceeded the threshold in the (first) tap
+		int16_t peak;		//!< Largest deviation from the baseline during the (first) tap, in counts
+		uint32_t sampleIndex; //!< Sample number where the (first) tap started, counted from reset()
+	};
+
+	/**
+	 * @brief Constructor. You must set the threshold before use.
+	 */
+	ADXL362TapDetector();
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362TapDetector();
+
+	/**
+	 * @brief Set the tap threshold
+	 *
+	 * @param counts Deviation from the baseline in counts. At RANGE_2G 1 count is 1 mg, at RANGE_4G 2 mg, and at RANGE_8G 4 mg.
+	 */
+	void setThreshold(int16_t counts) { threshold = counts; };
+
+	/**
+	 * @brief Set the enabled axes and directions
+	 *
+	 * @param axes A mask of AXIS_X_POS, AXIS_X_NEG, AXIS_Y_POS, AXIS_Y_NEG, AXIS_Z_POS, AXIS_Z_NEG. Default: AXIS_ALL.
+	 */
+	void setAxes(uint8_t axes) { axisMask = axes; };
+
+	/**
+	 * @brief Set the maximum number of samples above the threshold for a tap (default: 8)
+	 */
+	void setDuration(uint16_t samples) { duration = samples; };
+
+	/**
+	 * @brief Set the number of samples below the threshold required before a tap (default: 8)
+	 *
+	 * This rejects continuous vibration and the rebound of a previous tap.
+	 */
+	void setQuiet(uint16_t samples) { quiet = samples; };
+
+	/**
+	 * @brief Set the number of samples after the start of the first tap before a second tap can start (default: 20)
+	 */
+	void setLatency(uint16_t samples) { latency = samples; };
+
+	/**
+	 * @brief Set the number of samples after the latency in which a second tap makes a double tap (default: 100)
+	 *
+	 * Set to 0 to disable double tap detection, which reports single taps as soon as they end.
+	 */
+	void setWindow(uint16_t samples) { window = samples; };
+
+	/**
+	 * @brief Set the baseline filter shift (default: 6)
+	 *
+	 * The baseline moves 1/2^shift of the way to each new sample. Larger values adapt more slowly.
+	 */
+	void setBaselineShift(uint8_t shift) { baselineShift = shift; };
+
+	/**
+	 * @brief Set the function to call when a tap or double tap is detected
+	 *
+	 * The callback is called from process(), in the same thread.
+	 */
+	void setCallback(std::function<void(const Event &event)> callback) { this->callback = callback; };
+
+	/**
+	 * @brief Process all of the samples in a completed FIFO buffer
+	 *
+	 * @param data A buffer in STATE_READ_COMPLETE state
+	 */
+	void process(const ADXL362DataBase &data);
+
+	/**
+	 * @brief Process a single sample
+	 *
+	 * @param x X acceleration in counts
+	 * @param y Y acceleration in counts
+	 * @param z Z acceleration in counts
+	 */
+	void processSample(int16_t x, int16_t y, int16_t z);
+
+	/**
+	 * @brief Reset the detector state, including the baseline
+	 */
+	void reset();
+
+	static const uint8_t AXIS_X_POS = 0x01;	//!< X axis, positive direction
+	static const uint8_t AXIS_X_NEG = 0x02;	//!< X axis, negative direction
+	static const uint8_t AXIS_Y_POS = 0x04;	//!< Y axis, positive direction
+	static const uint8_t AXIS_Y_NEG = 0x08;	//!< Y axis, negative direction
+	static const uint8_t AXIS_Z_POS = 0x10;	//!< Z axis, positive direction
+	static const uint8_t AXIS_Z_NEG = 0x20;	//!< Z axis, negative direction
+	static const uint8_t AXIS_ALL = 0x3f;	//!< All axes, both directions
+
+protected:
+	/**
+	 * @brief Returns the AXIS_ flags for a deviation from the baseline on one axis
+	 */
+	uint8_t axisFlags(int32_t delta, uint8_t posFlag, uint8_t negFlag) const;
+
+	/**
+	 * @brief Called when a tap ends
+	 */
+	void tapEnded();
+
+	/**
+	 * @brief Call the callback, if set
+	 */
+	void emit(EventType type, const Event &tap);
+
+	int16_t threshold = 0x7fff; //!< Threshold in counts
+	uint8_t axisMask = AXIS_ALL; //!< Enabled axes
+	uint8_t baselineShift = 6; //!< Baseline filter coefficient
+	uint16_t duration = 8; //!< Maximum tap duration in samples
+	uint16_t quiet = 8; //!< Required quiet samples before a tap
+	uint16_t latency = 20; //!< Double tap latency in samples
+	uint16_t window = 100; //!< Double tap window in samples
+	std::function<void(const Event &event)> callback = nullptr; //!< Callback function
+
+	int32_t baseline[3]; //!< Per-axis baseline, scaled by 2^baselineShift
+	bool baselineValid = false; //!< false until the first sample
+	uint32_t sampleIndex = 0; //!< Samples processed since reset()
+	uint32_t quietCount = 0; //!< Consecutive samples below the threshold
+	uint16_t aboveCount = 0; //!< Consecutive samples above the threshold
+	bool tapValid = false; //!< Current tap was preceded by enough quiet samples
+	Event current; //!< Tap in progress
+	bool pending = false; //!< First tap of a possible double tap is waiting for the window
+	Event first; //!< First tap of a possible double tap
+};
+
+#endif /* __ADXL362TAPDETECTOR_H */
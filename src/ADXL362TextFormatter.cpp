@@ -0,0 +1,187 @@
+#include "Particle.h"
+
+#include "ADXL362TextFormatter.h"
+
+// Fast text formatting of samples for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+// Two ASCII digits for each value 0 - 99
+static const char digitPairs[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+// Returns the number of decimal digits in value
+static inline size_t countDigits(uint32_t value) {
+	if (value < 10) return 1;
+	if (value < 100) return 2;
+	if (value < 1000) return 3;
+	if (value < 10000) return 4;
+	if (value < 100000) return 5;
+	if (value < 1000000) return 6;
+	if (value < 10000000) return 7;
+	if (value < 100000000) return 8;
+	if (value < 1000000000) return 9;
+	return 10;
+}
+
+// Writes the digits of value ending before end, two at a time, and returns the first digit
+static inline char *formatDigitsBackward(char *end, uint32_t value) {
+	char *t = end;
+	while(value >= 100) {
+		uint32_t quotient = value / 100;
+		uint32_t remainder = value - quotient * 100;
+		t -= 2;
+		t[0] = digitPairs[remainder * 2];
+		t[1] = digitPairs[remainder * 2 + 1];
+		value = quotient;
+	}
+	if (value >= 10) {
+		t -= 2;
+		t[0] = digitPairs[value * 2];
+		t[1] = digitPairs[value * 2 + 1];
+	}
+	else {
+		*--t = (char)('0' + value);
+	}
+	return t;
+}
+
+// Writes value, with a leading - if negative, right-aligned in width characters
+static inline char *formatDigits(char *p, uint32_t value, bool negative, uint8_t width) {
+	if (width >= 5 && width <= 8 && value < 10000) {
+		// Sample values always fit in a width of 5, so pad the field with one 8 byte store and
+		// write the digits from the end, without counting them first
+		memcpy(p, "        ", 8);
+		char *t = formatDigitsBackward(p + width, value);
+		if (negative) {
+			t[-1] = '-';
+		}
+		return p + width;
+	}
+
+	size_t len = countDigits(value) + (negative ? 1 : 0);
+	while(width > len) {
+		*p++ = ' ';
+		width--;
+	}
+	if (negative) {
+		*p = '-';
+	}
+	formatDigitsBackward(p + len, value);
+	return p + len;
+}
+
+ADXL362TextFormatterBase::ADXL362TextFormatterBase(char *textBuf, size_t textBufSize) : textBuf(textBuf), textBufSize(textBufSize) {
+}
+
+ADXL362TextFormatterBase::~ADXL362TextFormatterBase() {
+}
+
+void ADXL362TextFormatterBase::setColumns(uint8_t columns, float rateHz) {
+	this->columns = columns;
+	rateTenthsHz = (uint32_t)(rateHz * 10.0 + 0.5);
+}
+
+void ADXL362TextFormatterBase::setLineEnding(const char *lineEnding) {
+	lineEndingLen = 0;
+	while(lineEndingLen < 2 && lineEnding[lineEndingLen]) {
+		this->lineEnding[lineEndingLen] = lineEnding[lineEndingLen];
+		lineEndingLen++;
+	}
+	this->lineEnding[lineEndingLen] = 0;
+}
+
+size_t ADXL362TextFormatterBase::write(Print &out, const ADXL362DataBase &data) {
+	size_t result = 0;
+
+	size_t first = 0;
+	while(first < data.numSamplesRead) {
+		first += format(data, first);
+
+		result += out.write((const uint8_t *)textBuf, textLen);
+		clear();
+	}
+	return result;
+}
+
+size_t ADXL362TextFormatterBase::format(const ADXL362DataBase &data, size_t first) {
+	size_t count = 0;
+	char *p = &textBuf[textLen];
+	const char *limit = &textBuf[textBufSize - MAX_LINE_LENGTH];
+
+	for(size_t ii = first; ii < data.numSamplesRead && p <= limit; ii++) {
+		ADXL362Sample sample;
+		ADXL362DataBase::decodeSample(&data.buf[data.startOffset + data.sampleSizeInBytes * ii], data.storeTemp, sample);
+		p = formatLine(p, sample, data.storeTemp);
+		count++;
+	}
+	textLen = p - textBuf;
+	return count;
+}
+
+bool ADXL362TextFormatterBase::formatSample(const ADXL362Sample &sample, bool includeTemp) {
+	if (textBufSize - textLen < MAX_LINE_LENGTH) {
+		return false;
+	}
+	textLen = formatLine(&textBuf[textLen], sample, includeTemp) - textBuf;
+	return true;
+}
+
+char *ADXL362TextFormatterBase::formatLine(char *p, const ADXL362Sample &sample, bool includeTemp) {
+	if (columns & COLUMN_SAMPLE) {
+		p = formatUint(p, sampleNum);
+		*p++ = separator;
+	}
+	if (columns & COLUMN_TIME) {
+		// Time in units of 0.0001 seconds, rounded
+		uint64_t time = 0;
+		if (rateTenthsHz) {
+			time = ((uint64_t)sampleNum * 200000 + rateTenthsHz) / (2 * (uint64_t)rateTenthsHz);
+		}
+		uint32_t frac = (uint32_t)(time % 10000);
+		p = formatUint(p, (uint32_t)(time / 10000));
+		*p++ = '.';
+		memcpy(p, &digitPairs[(frac / 100) * 2], 2);
+		memcpy(p + 2, &digitPairs[(frac % 100) * 2], 2);
+		p += 4;
+		*p++ = separator;
+	}
+
+	p = formatInt(p, sample.x, width);
+	*p++ = separator;
+	p = formatInt(p, sample.y, width);
+	*p++ = separator;
+	p = formatInt(p, sample.z, width);
+	if (includeTemp) {
+		*p++ = separator;
+		p = formatInt(p, sample.t, width);
+	}
+	// At most 2 characters; faster than memcpy for such a short copy
+	p[0] = lineEnding[0];
+	p[1] = lineEnding[1];
+	p += lineEndingLen;
+
+	sampleNum++;
+	return p;
+}
+
+// [static]
+char *ADXL362TextFormatterBase::formatInt(char *p, int32_t value, uint8_t width) {
+	if (value < 0) {
+		return formatDigits(p, 0u - (uint32_t)value, true, width);
+	}
+	return formatDigits(p, (uint32_t)value, false, width);
+}
+
+// [static]
+char *ADXL362TextFormatterBase::formatUint(char *p, uint32_t value, uint8_t width) {
+	return formatDigits(p, value, false, width);
+}
@@ -0,0 +1,197 @@
+#ifndef __ADXL362TEXTFORMATTER_H
+#define __ADXL362TEXTFORMATTER_H
+
+// Fast text formatting of samples for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+
+/**
+ * @brief Formats a whole buffer of samples as text, for output in one write
+ *
+ * Calling Serial.printlnf() for each sample parses the format string and does a separate write
+ * for every line. This formats the samples into a preallocated buffer using integer-to-ASCII
+ * conversion with a table of digit pairs (no printf, no locale, no floating point), and writes
+ * the text with one Print::write() call per buffer full. It's more than 10 times faster than
+ * printlnf() per sample.
+ *
+ * Each line is optional columns (the sample number and the time in seconds, from the sample
+ * number and output data rate, with 4 decimal places), then X, Y, Z, and optionally T, separated
+ * by the separator, then the line ending. With a width, values are right-aligned and padded with
+ * spaces, like %5d. The default is the same format as example 2: "%5d %5d %5d\r\n".
+ *
+ * The host/serialreader tool uses this for its CSV output.
+ *
+ * You will not allocate one of these directly; use ADXL362TextFormatter, which allocates the buffer.
+ */
+class ADXL362TextFormatterBase {
+public:
+	/**
+	 * @brief Constructor - You will not allocate one of these directly
+	 *
+	 * @param textBuf Buffer for the text
+	 *
+	 * @param textBufSize Size of textBuf in bytes. Must be at least MAX_LINE_LENGTH.
+	 */
+	ADXL362TextFormatterBase(char *textBuf, size_t textBufSize);
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362TextFormatterBase();
+
+	/**
+	 * @brief Set the columns before the sample values
+	 *
+	 * @param columns COLUMN_SAMPLE and COLUMN_TIME, or 0 for neither (default)
+	 *
+	 * @param rateHz Output data rate for the time column, typically accel.getOutputDataRate()
+	 */
+	void setColumns(uint8_t columns, float rateHz = 0);
+
+	/**
+	 * @brief Set the separator between columns (default ' ')
+	 */
+	void setSeparator(char separator) { this->separator = separator; };
+
+	/**
+	 * @brief Set the minimum width of the sample values, padded with spaces on the left (default 5, 0 for no padding)
+	 */
+	void setWidth(uint8_t width) { this->width = (width <= 6) ? width : 6; };
+
+	/**
+	 * @brief Set the line ending (default "\r\n", like printlnf()). At most 2 characters.
+	 */
+	void setLineEnding(const char *lineEnding);
+
+	/**
+	 * @brief Set the sample number of the next sample for the sample and time columns (default 0)
+	 */
+	void setSampleNumber(uint32_t sampleNum) { this->sampleNum = sampleNum; };
+
+	/**
+	 * @brief Returns the sample number of the next sample
+	 */
+	uint32_t getSampleNumber() const { return sampleNum; };
+
+	/**
+	 * @brief Format the samples in a completed buffer and write the text to out
+	 *
+	 * @param out Where to write the text, typically Serial
+	 *
+	 * @param data Completed buffer. Temperature is included if the buffer has temperature.
+	 *
+	 * @return The number of bytes written
+	 *
+	 * The text is written with one call to out.write() for each time the text buffer fills.
+	 */
+	size_t write(Print &out, const ADXL362DataBase &data);
+
+	/**
+	 * @brief Add lines to the text buffer for samples in a buffer, until the text buffer is full
+	 *
+	 * @param data Completed buffer
+	 *
+	 * @param first Index of the first sample to format
+	 *
+	 * @return The number of samples formatted. If less than data.numSamplesRead - first, the text
+	 * buffer is full; use getText() and clear() and call again.
+	 */
+	size_t format(const ADXL362DataBase &data, size_t first = 0);
+
+	/**
+	 * @brief Add one line to the text buffer
+	 *
+	 * @param sample The sample
+	 *
+	 * @param includeTemp true to include the temperature value
+	 *
+	 * @return false if the text buffer is full. The sample number is only incremented on success.
+	 */
+	bool formatSample(const ADXL362Sample &sample, bool includeTemp = false);
+
+	/**
+	 * @brief Returns the formatted text. It is not null terminated; use getLength().
+	 */
+	const char *getText() const { return textBuf; };
+
+	/**
+	 * @brief Returns the number of bytes of text
+	 */
+	size_t getLength() const { return textLen; };
+
+	/**
+	 * @brief Remove all of the text from the buffer
+	 */
+	void clear() { textLen = 0; };
+
+	/**
+	 * @brief Format a signed integer, right-aligned in width characters
+	 *
+	 * @param p Where to write the text. Must have room for 11 characters, or width if larger, even if
+	 * the text is shorter, because the field may be padded with a single 8 character store.
+	 *
+	 * @return Pointer to the character after the text
+	 */
+	static char *formatInt(char *p, int32_t value, uint8_t width = 0);
+
+	/**
+	 * @brief Format an unsigned integer, right-aligned in width characters
+	 *
+	 * @param p Where to write the text. Must have room for 10 characters, or width if larger, even if
+	 * the text is shorter, because the field may be padded with a single 8 character store.
+	 *
+	 * @return Pointer to the character after the text
+	 */
+	static char *formatUint(char *p, uint32_t value, uint8_t width = 0);
+
+	static const uint8_t COLUMN_SAMPLE = 0x01;	//!< Sample number column
+	static const uint8_t COLUMN_TIME = 0x02;		//!< Time in seconds column
+
+	static const size_t MAX_LINE_LENGTH = 64;	//!< Longest possible line
+
+protected:
+	/**
+	 * @brief Write one line at p, which must have room for MAX_LINE_LENGTH characters, and increment the sample number
+	 *
+	 * @return Pointer to the character after the line
+	 */
+	char *formatLine(char *p, const ADXL362Sample &sample, bool includeTemp);
+
+	char *textBuf; //!< Buffer for the text
+	size_t textBufSize; //!< Size of textBuf in bytes
+	size_t textLen = 0; //!< Bytes of text in textBuf
+
+	uint8_t columns = 0; //!< COLUMN_SAMPLE and COLUMN_TIME
+	uint32_t rateTenthsHz = 0; //!< Output data rate for COLUMN_TIME in 0.1 Hz units
+	char separator = ' '; //!< Column separator
+	uint8_t width = 5; //!< Minimum width of sample values
+	char lineEnding[3] = "\r\n"; //!< Line ending
+	uint8_t lineEndingLen = 2; //!< Length of lineEnding
+	uint32_t sampleNum = 0; //!< Sample number of the next sample
+};
+
+/**
+ * @brief Batch text formatter
+ *
+ * @param TEXT_BUF_SIZE Size of the text buffer in bytes. Each line is about 20 bytes without the
+ * sample and time columns. Larger buffers mean fewer, larger writes.
+ */
+template <size_t TEXT_BUF_SIZE = 1024>
+class ADXL362TextFormatter : public ADXL362TextFormatterBase {
+public:
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362TextFormatter() : ADXL362TextFormatterBase(staticTextBuf, sizeof(staticTextBuf)) {
+		static_assert(TEXT_BUF_SIZE >= MAX_LINE_LENGTH, "TEXT_BUF_SIZE must be at least MAX_LINE_LENGTH");
+	};
+
+	/**
+	 * @brief Buffer for the text
+	 */
+	char staticTextBuf[TEXT_BUF_SIZE];
+};
+
+#endif /* __ADXL362TEXTFORMATTER_H */
@@ -0,0 +1,403 @@
+#ifndef __ADXL362TRANSPORT_H
+#define __ADXL362TRANSPORT_H
+
+// SPI transport policies for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+/**
+ * @brief Transport policy for the Particle SPI interface, using DMA for FIFO reads
+ *
+ * A transport policy is the template parameter of ADXL362DMABasic. It's how the driver talks to the
+ * chip, and is resolved at compile time, so there are no virtual calls. ADXL362DMA uses this one.
+ * A transport has these methods:
+ *
+ * - begin() is called before the first transaction
+ * - beginTransaction() and endTransaction() are called around each transaction (chip select)
+ * - transfer(uint8_t) transfers one byte and returns the byte received
+ * - transfer(tx, rx, len, callback) transfers a buffer. With a callback, it can return before the
+ *   transfer completes (DMA) and call the callback when it does; the callback calls endTransaction().
+ *   tx can be NULL when only reading.
+ *
+ * The driver code is in ADXL362DMA.cpp, and only the transports in this file are instantiated
+ * there. To use another transport, add a line for it at the end of ADXL362DMA.cpp.
+ */
+class ADXL362SPITransport {
+public:
+	/**
+	 * @brief Constructor
+	 *
+	 * @param spi The SPI interface, could be `SPI` or `SPI1`
+	 *
+	 * @param cs The chip select pin to use
+	 *
+	 * @param settings (optional) SPISettings to set the data rate, etc.
+	 */
+	ADXL362SPITransport(SPIClass &spi, int cs = A2, SPISettings settings = SPISettings(4*MHZ, MSBFIRST, SPI_MODE0)) : spi(spi), cs(cs), settings(settings) {};
+
+	/**
+	 * @brief Initialize SPI and the CS pin
+	 */
+	void begin() { spi.begin(cs); };
+
+	/**
+	 * @brief Calls spi.beginTransaction() and clears the CS pin
+	 */
+	void beginTransaction() {
+		spi.beginTransaction(settings);
+		digitalWrite(cs, LOW);
+	};
+
+	/**
+	 * @brief Sets the CS pin high and calls spi.endTransaction()
+	 */
+	void endTransaction() {
+		digitalWrite(cs, HIGH);
+		spi.endTransaction();
+	};
+
+	/**
+	 * @brief Transfer one byte
+	 */
+	uint8_t transfer(uint8_t data) { return spi.transfer(data); };
+
+	/**
+	 * @brief Transfer a buffer, by DMA if callback is not NULL
+	 */
+	void transfer(const void *tx, void *rx, size_t len, wiring_spi_dma_transfercomplete_callback_t callback) {
+		spi.transfer((void *)tx, rx, len, callback);
+	};
+
+	/**
+	 * @brief Returns the SPI settings (mode, bit order, speed)
+	 */
+	const SPISettings &getSettings() const { return settings; };
+
+protected:
+	SPIClass &spi; //!< SPI interface, typically SPI or SPI1
+	int cs;		//!<  CS chip select pin. Default: A2
+	SPISettings settings; //!<  SPI settings (mode, bit order, speed)
+};
+
+/**
+ * @brief Transport policy that passes transactions to another transport and records them
+ *
+ * The log is a sequence of transactions, each a uint16_t (little endian) number of bytes followed by
+ * that many pairs of bytes sent and received. Bytes sent from a NULL tx buffer are recorded as 0.
+ * ADXL362ReplayTransport plays a log back, so a session recorded on a device can be run through the
+ * driver again on a host computer, without the chip or Particle SPI.
+ *
+ * When the log is full, recording stops at the end of the last complete transaction, and isFull()
+ * returns true.
+ *
+ * @param Inner The transport to record, ADXL362SPITransport by default
+ */
+template <class Inner = ADXL362SPITransport>
+class ADXL362RecordingTransport {
+public:
+	/**
+	 * @brief Constructor
+	 *
+	 * @param inner The transport to record
+	 *
+	 * @param logBuf Buffer for the log. Must stay allocated while recording.
+	 *
+	 * @param logBufSize Size of logBuf in bytes
+	 */
+	ADXL362RecordingTransport(const Inner &inner, uint8_t *logBuf, size_t logBufSize) : inner(inner), logBuf(logBuf), logBufSize(logBufSize) {};
+
+	/**
+	 * @brief Initialize the inner transport
+	 */
+	void begin() { inner.begin(); };
+
+	/**
+	 * @brief Begin a transaction and start a log record
+	 */
+	void beginTransaction() {
+		inner.beginTransaction();
+
+		recordStart = logLen;
+		recording = !full && (logBufSize - logLen >= 2);
+		if (recording) {
+			logLen += 2;
+		}
+		else {
+			full = true;
+		}
+	};
+
+	/**
+	 * @brief Finish the log record and end the transaction
+	 */
+	void endTransaction() {
+		fillPending();
+		if (recording) {
+			size_t numBytes = (logLen - recordStart - 2) / 2;
+			logBuf[recordStart] = (uint8_t)(numBytes & 0xff);
+			logBuf[recordStart + 1] = (uint8_t)(numBytes >> 8);
+			recording = false;
+		}
+		inner.endTransaction();
+	};
+
+	/**
+	 * @brief Transfer and record one byte
+	 */
+	uint8_t transfer(uint8_t data) {
+		uint8_t result = inner.transfer(data);
+		if (reserve(1)) {
+			logBuf[logLen - 2] = data;
+			logBuf[logLen - 1] = result;
+		}
+		return result;
+	};
+
+	/**
+	 * @brief Transfer and record a buffer
+	 *
+	 * The received bytes are recorded when the transfer completes: after transfer() returns without a
+	 * callback, or at endTransaction() with one.
+	 */
+	void transfer(const void *tx, void *rx, size_t len, wiring_spi_dma_transfercomplete_callback_t callback) {
+		if (reserve(len)) {
+			const uint8_t *txBytes = (const uint8_t *)tx;
+			uint8_t *p = &logBuf[logLen - len * 2];
+			for(size_t ii = 0; ii < len; ii++) {
+				p[ii * 2] = txBytes ? txBytes[ii] : 0;
+				p[ii * 2 + 1] = 0;
+			}
+			pendingRx = (const uint8_t *)rx;
+			pendingLen = len;
+			pendingOffset = logLen - len * 2;
+		}
+		inner.transfer(tx, rx, len, callback);
+		if (!callback) {
+			fillPending();
+		}
+	};
+
+	/**
+	 * @brief Returns the log
+	 */
+	const uint8_t *getLog() const { return logBuf; };
+
+	/**
+	 * @brief Returns the number of bytes in the log
+	 */
+	size_t getLogLength() const { return logLen; };
+
+	/**
+	 * @brief Returns true if the log filled up and recording stopped
+	 */
+	bool isFull() const { return full; };
+
+	/**
+	 * @brief Empty the log and start recording again
+	 */
+	void clear() {
+		logLen = 0;
+		full = false;
+	};
+
+	/**
+	 * @brief Returns the transport being recorded
+	 */
+	Inner &getInner() { return inner; };
+
+protected:
+	/**
+	 * @brief Make room in the log for len pairs of bytes in the current transaction
+	 *
+	 * @return false if not recording. If the log is full, the current transaction is removed.
+	 */
+	bool reserve(size_t len) {
+		if (!recording) {
+			return false;
+		}
+		if (logBufSize - logLen < len * 2 || (logLen - recordStart - 2) / 2 + len > 0xffff) {
+			logLen = recordStart;
+			recording = false;
+			full = true;
+			pendingRx = nullptr;
+			return false;
+		}
+		logLen += len * 2;
+		return true;
+	};
+
+	/**
+	 * @brief Record the received bytes of the last buffer transfer
+	 */
+	void fillPending() {
+		if (pendingRx && recording) {
+			uint8_t *p = &logBuf[pendingOffset];
+			for(size_t ii = 0; ii < pendingLen; ii++) {
+				p[ii * 2 + 1] = pendingRx[ii];
+			}
+		}
+		pendingRx = nullptr;
+	};
+
+	Inner inner; //!< Transport being recorded
+	uint8_t *logBuf; //!< Buffer for the log
+	size_t logBufSize; //!< Size of logBuf in bytes
+	size_t logLen = 0; //!< Bytes in the log
+	size_t recordStart = 0; //!< Offset of the current transaction in logBuf
+	bool recording = false; //!< In a transaction that is being recorded
+	bool full = false; //!< The log filled up
+	const uint8_t *pendingRx = nullptr; //!< Receive buffer of a transfer that has not been recorded yet
+	size_t pendingLen = 0; //!< Length of the pendingRx transfer
+	size_t pendingOffset = 0; //!< Offset in logBuf of the pendingRx transfer
+};
+
+/**
+ * @brief Transport policy that plays back a log from ADXL362RecordingTransport
+ *
+ * Each transaction returns the bytes received in the corresponding recorded transaction. The bytes
+ * sent are compared with the recorded ones (except from a NULL tx buffer); a difference, or a
+ * transaction of a different length, is counted by getMismatchCount(). That means the driver did
+ * something different from when the log was recorded. Buffer transfers complete, and call the
+ * callback, before transfer() returns. After the end of the log, 0 bytes are received.
+ *
+ * A log can also be built by hand to test the driver against specific chip responses.
+ */
+class ADXL362ReplayTransport {
+public:
+	/**
+	 * @brief Constructor
+	 *
+	 * @param log The log. It is not copied, and must stay allocated.
+	 *
+	 * @param logLen Length of the log in bytes
+	 */
+	ADXL362ReplayTransport(const uint8_t *log, size_t logLen) : log(log), logLen(logLen) {};
+
+	/**
+	 * @brief Does nothing
+	 */
+	void begin() {};
+
+	/**
+	 * @brief Start playing back the next transaction in the log
+	 */
+	void beginTransaction() {
+		remaining = 0;
+		mismatch = false;
+
+		if (offset + 2 <= logLen) {
+			remaining = log[offset] | (log[offset + 1] << 8);
+			offset += 2;
+			if (remaining > (logLen - offset) / 2) {
+				// Truncated log
+				remaining = (logLen - offset) / 2;
+				mismatch = true;
+			}
+		}
+		else {
+			// Past the end of the log
+			offset = logLen;
+			mismatch = true;
+		}
+		transactionCount++;
+	};
+
+	/**
+	 * @brief Skip any part of the transaction that was not transferred
+	 */
+	void endTransaction() {
+		if (remaining) {
+			// The driver transferred fewer bytes than were recorded
+			offset += remaining * 2;
+			remaining = 0;
+			mismatch = true;
+		}
+		if (mismatch) {
+			mismatchCount++;
+			mismatch = false;
+		}
+	};
+
+	/**
+	 * @brief Transfer one byte
+	 */
+	uint8_t transfer(uint8_t data) {
+		uint8_t result;
+		transferBytes(&data, &result, 1);
+		return result;
+	};
+
+	/**
+	 * @brief Transfer a buffer, calling callback (if not NULL) before returning
+	 */
+	void transfer(const void *tx, void *rx, size_t len, wiring_spi_dma_transfercomplete_callback_t callback) {
+		transferBytes((const uint8_t *)tx, (uint8_t *)rx, len);
+		if (callback) {
+			callback();
+		}
+	};
+
+	/**
+	 * @brief Start again at the beginning of the log
+	 */
+	void rewind() {
+		offset = 0;
+		remaining = 0;
+		mismatch = false;
+		transactionCount = 0;
+		mismatchCount = 0;
+	};
+
+	/**
+	 * @brief Returns true if all of the transactions in the log have been played back
+	 */
+	bool isDone() const { return offset >= logLen; };
+
+	/**
+	 * @brief Returns the number of transactions played back
+	 */
+	uint32_t getTransactionCount() const { return transactionCount; };
+
+	/**
+	 * @brief Returns the number of transactions that differed from the log
+	 */
+	uint32_t getMismatchCount() const { return mismatchCount; };
+
+protected:
+	/**
+	 * @brief Play back len bytes of the current transaction
+	 */
+	void transferBytes(const uint8_t *tx, uint8_t *rx, size_t len) {
+		size_t count = (len < remaining) ? len : remaining;
+
+		const uint8_t *p = &log[offset];
+		for(size_t ii = 0; ii < count; ii++) {
+			if (tx && tx[ii] != p[ii * 2]) {
+				mismatch = true;
+			}
+			if (rx) {
+				rx[ii] = p[ii * 2 + 1];
+			}
+		}
+		offset += count * 2;
+		remaining -= count;
+
+		if (count < len) {
+			// The driver transferred more bytes than were recorded
+			if (rx) {
+				memset(&rx[count], 0, len - count);
+			}
+			mismatch = true;
+		}
+	};
+
+	const uint8_t *log; //!< The log
+	size_t logLen; //!< Length of the log in bytes
+	size_t offset = 0; //!< Offset of the next byte pair in log
+	size_t remaining = 0; //!< Byte pairs left in the current transaction
+	bool mismatch = false; //!< The current transaction differs from the log
+	uint32_t transactionCount = 0; //!< Transactions played back
+	uint32_t mismatchCount = 0; //!< Transactions that differed from the log
+};
+
+#endif /* __ADXL362TRANSPORT_H */
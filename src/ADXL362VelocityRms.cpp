@@ -0,0 +1,99 @@
+#include "Particle.h"
+
+#include "ADXL362VelocityRms.h"
+
+#include <math.h>
+
+// Vibration velocity RMS for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+ADXL362VelocityRms::ADXL362VelocityRms() {
+	memset(&lastResult, 0, sizeof(lastResult));
+}
+
+ADXL362VelocityRms::~ADXL362VelocityRms() {
+}
+
+void ADXL362VelocityRms::begin(float sampleRate, uint8_t rangeG, uint16_t windowSamples, float highPassHz) {
+	this->windowSamples = (windowSamples > 0) ? windowSamples : 1;
+
+	for(size_t ii = 0; ii < 3; ii++) {
+		highPass[ii].setHighPass(sampleRate, highPassHz);
+	}
+
+	// 1 mg = 9.80665 mm/s^2 = 9806.65 um/s^2. The trapezoidal rule adds (a[n] + a[n-1]) / 2 * dt.
+	double umPerSecPerCount = (double)ADXL362Dsp::mgPerCount(rangeG) * 9806.65 / (double)sampleRate;
+	gain = (int64_t) llround(umPerSecPerCount / 2.0 * (double)(1 << VELOCITY_SHIFT) * 65536.0 / (double)(1 << INPUT_SHIFT));
+
+	// Leak time constant of about 1 second, well below the high-pass cutoff
+	leakShift = 1;
+	while(leakShift < 16 && (float)(1 << leakShift) < sampleRate) {
+		leakShift++;
+	}
+
+	primed = false;
+	memset(prevAccel, 0, sizeof(prevAccel));
+	memset(velocity, 0, sizeof(velocity));
+	memset(sumSq, 0, sizeof(sumSq));
+	count = 0;
+	windowIndex = 0;
+	memset(&lastResult, 0, sizeof(lastResult));
+}
+
+void ADXL362VelocityRms::process(const ADXL362DataBase &data) {
+	ADXL362Sample sample;
+
+	for(size_t ii = 0; ii < data.numSamplesRead; ii++) {
+		data.readSample(ii, sample);
+		processSample(sample);
+	}
+}
+
+void ADXL362VelocityRms::processSample(const ADXL362Sample &sample) {
+	int32_t values[3] = { sample.x, sample.y, sample.z };
+
+	if (!primed) {
+		for(size_t ii = 0; ii < 3; ii++) {
+			highPass[ii].prime(values[ii] << INPUT_SHIFT);
+		}
+		primed = true;
+	}
+
+	for(size_t ii = 0; ii < 3; ii++) {
+		int32_t accel = highPass[ii].process(values[ii] << INPUT_SHIFT);
+
+		int32_t increment = (int32_t)(((int64_t)(accel + prevAccel[ii]) * gain) >> 16);
+		prevAccel[ii] = accel;
+
+		velocity[ii] += increment - (velocity[ii] >> leakShift);
+
+		sumSq[ii] += (int64_t)velocity[ii] * velocity[ii];
+	}
+
+	if (++count >= windowSamples) {
+		endWindow();
+	}
+}
+
+void ADXL362VelocityRms::endWindow() {
+	Result result;
+
+	result.maxUmPerSec = 0;
+	for(size_t ii = 0; ii < 3; ii++) {
+		uint64_t meanSq = (uint64_t)(sumSq[ii] / count);
+
+		result.rmsUmPerSec[ii] = ADXL362Dsp::isqrt64(meanSq) >> VELOCITY_SHIFT;
+		if (result.rmsUmPerSec[ii] > result.maxUmPerSec) {
+			result.maxUmPerSec = result.rmsUmPerSec[ii];
+		}
+		sumSq[ii] = 0;
+	}
+
+	result.windowIndex = windowIndex++;
+	count = 0;
+	lastResult = result;
+
+	if (callback) {
+		callback(result);
+	}
+}
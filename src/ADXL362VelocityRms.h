@@ -0,0 +1,133 @@
+#ifndef __ADXL362VELOCITYRMS_H
+#define __ADXL362VELOCITYRMS_H
+
+// Vibration velocity RMS for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+#include "ADXL362Dsp.h"
+
+#include <functional>
+
+/**
+ * @brief Streaming velocity RMS for ISO 10816 style vibration severity
+ *
+ * Machine vibration severity is specified as velocity RMS in mm/s, but the ADXL362 measures
+ * acceleration. For each axis this:
+ *
+ * - High-pass filters the acceleration (default 10 Hz) to remove gravity and low-frequency motion
+ * - Integrates using the trapezoidal rule, scaled by the range (mg per count) and sample rate
+ * - Uses a leaky integrator so numerical errors and residual offset cannot make the velocity drift
+ * - Calculates the RMS over each window
+ *
+ * Everything per sample is integer math. Velocity is kept in 1/256 um/s. The leaky integrator
+ * bounds the velocity, and the sums are cleared every window, so it is stable indefinitely at 400 Hz.
+ * Windows up to a few thousand samples are supported.
+ *
+ * Note that at 400 Hz the usable bandwidth is about 10 to 160 Hz, narrower than the 10 to 1000 Hz
+ * specified by ISO 10816, so the result is most accurate for machines running below about 3000 RPM.
+ * The trapezoidal rule also reads low near the Nyquist frequency (about 20% low at 100 Hz).
+ */
+class ADXL362VelocityRms {
+public:
+	/**
+	 * @brief Result passed to the callback at the end of each window
+	 */
+	struct Result {
+		uint32_t rmsUmPerSec[3];	//!< Velocity RMS for X, Y, Z in micrometers per second
+		uint32_t maxUmPerSec;		//!< Largest of the three axes
+		uint32_t windowIndex;		//!< Window number since begin()
+	};
+
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362VelocityRms();
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362VelocityRms();
+
+	/**
+	 * @brief Configure the filters and scale. Must be called before process().
+	 *
+	 * @param sampleRate The output data rate in Hz, typically 400
+	 *
+	 * @param rangeG The range (2, 4, or 8), see ADXL362DMA::getRangeG()
+	 *
+	 * @param windowSamples The number of samples in each RMS window (default: 400)
+	 *
+	 * @param highPassHz High-pass cutoff frequency in Hz (default: 10)
+	 */
+	void begin(float sampleRate, uint8_t rangeG, uint16_t windowSamples = 400, float highPassHz = 10.0);
+
+	/**
+	 * @brief Configure using the sample rate and range from the driver
+	 *
+	 * @param accel The accelerometer object, after setting the range and output data rate
+	 *
+	 * @param windowSamples The number of samples in each RMS window (default: 400)
+	 */
+	void begin(const ADXL362DMA &accel, uint16_t windowSamples = 400) { begin(accel.getOutputDataRate(), accel.getRangeG(), windowSamples); };
+
+	/**
+	 * @brief Set the function to call at the end of each window
+	 */
+	void setCallback(std::function<void(const Result &result)> callback) { this->callback = callback; };
+
+	/**
+	 * @brief Process all of the samples in a completed FIFO buffer
+	 *
+	 * @param data A buffer in STATE_READ_COMPLETE state
+	 */
+	void process(const ADXL362DataBase &data);
+
+	/**
+	 * @brief Process a single sample
+	 */
+	void processSample(const ADXL362Sample &sample);
+
+	/**
+	 * @brief Returns the largest axis velocity RMS from the last complete window in mm/s
+	 */
+	float getVelocityRmsMmPerSec() const { return (float)lastResult.maxUmPerSec / 1000.0; };
+
+	/**
+	 * @brief Returns the velocity RMS for one axis from the last complete window in mm/s
+	 *
+	 * @param axis 0 = X, 1 = Y, 2 = Z
+	 */
+	float getVelocityRmsMmPerSec(size_t axis) const { return (axis < 3) ? (float)lastResult.rmsUmPerSec[axis] / 1000.0 : 0; };
+
+	/**
+	 * @brief Returns the result from the last complete window
+	 */
+	const Result &getResult() const { return lastResult; };
+
+	static const int INPUT_SHIFT = 4; //!< Acceleration is scaled by 2^INPUT_SHIFT for the filter
+	static const int VELOCITY_SHIFT = 8; //!< Velocity is in um/s * 2^VELOCITY_SHIFT
+
+protected:
+	/**
+	 * @brief Calculate the RMS at the end of a window
+	 */
+	void endWindow();
+
+	ADXL362Biquad highPass[3]; //!< Per-axis high-pass filter
+	int64_t gain = 0; //!< Converts the sum of two filtered samples to a velocity increment, Q16
+	uint8_t leakShift = 9; //!< Leaky integrator coefficient is 1 - 2^-leakShift
+	uint16_t windowSamples = 400; //!< Samples per window
+	std::function<void(const Result &result)> callback = nullptr; //!< Callback function
+
+	bool primed = false; //!< Filters have been primed with the first sample
+	int32_t prevAccel[3]; //!< Previous filtered acceleration, for the trapezoidal rule
+	int32_t velocity[3]; //!< Velocity in um/s * 2^VELOCITY_SHIFT
+	int64_t sumSq[3]; //!< Sum of squared velocity in the current window
+	uint16_t count = 0; //!< Samples in the current window
+	uint32_t windowIndex = 0; //!< Windows completed
+	Result lastResult; //!< Last complete window
+};
+
+#endif /* __ADXL362VELOCITYRMS_H */
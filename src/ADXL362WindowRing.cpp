@@ -0,0 +1,130 @@
+#include "Particle.h"
+
+#include "ADXL362WindowRing.h"
+
+// Sliding windows across FIFO buffers for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+ADXL362WindowRingBase::const_iterator::const_iterator(const ADXL362WindowRingBase *ring, size_t bufferIndex, size_t sampleIndex, size_t remaining) :
+	ring(ring), bufferIndex(bufferIndex), sampleIndex(sampleIndex), remaining(remaining) {
+	load();
+}
+
+ADXL362WindowRingBase::const_iterator &ADXL362WindowRingBase::const_iterator::operator++() {
+	if (remaining > 0) {
+		remaining--;
+		sampleIndex++;
+		if (sampleIndex >= ring->getBuffer(bufferIndex)->numSamplesRead) {
+			bufferIndex++;
+			sampleIndex = 0;
+		}
+		load();
+	}
+	return *this;
+}
+
+void ADXL362WindowRingBase::const_iterator::load() {
+	if (remaining > 0) {
+		ring->getBuffer(bufferIndex)->readSample(sampleIndex, sample);
+	}
+}
+
+ADXL362WindowRingBase::ADXL362WindowRingBase(ADXL362DataBase **buffers, size_t maxBuffers) : buffers(buffers), maxBuffers(maxBuffers) {
+}
+
+ADXL362WindowRingBase::~ADXL362WindowRingBase() {
+}
+
+void ADXL362WindowRingBase::begin(size_t windowSize, size_t hopSize) {
+	this->windowSize = windowSize;
+	this->hopSize = (hopSize > 0) ? hopSize : 1;
+
+	head = count = 0;
+	startSample = 0;
+	available = 0;
+	pendingSkip = 0;
+	windowStart = 0;
+}
+
+bool ADXL362WindowRingBase::push(ADXL362DataBase *data) {
+	if (count >= maxBuffers) {
+		return false;
+	}
+
+	size_t n = data->numSamplesRead;
+
+	if (pendingSkip > 0) {
+		// The last hop went past the end of the ring, so the ring is empty
+		if (pendingSkip >= n) {
+			pendingSkip -= n;
+			data->state = ADXL362DMA::STATE_FREE;
+			return true;
+		}
+		startSample = pendingSkip;
+		n -= pendingSkip;
+		pendingSkip = 0;
+	}
+	else
+	if (n == 0) {
+		data->state = ADXL362DMA::STATE_FREE;
+		return true;
+	}
+
+	buffers[(head + count) % maxBuffers] = data;
+	count++;
+	available += n;
+	return true;
+}
+
+void ADXL362WindowRingBase::advance() {
+	size_t skip = hopSize;
+	windowStart += hopSize;
+
+	while(skip > 0 && count > 0) {
+		size_t remainingInHead = getBuffer(0)->numSamplesRead - startSample;
+		if (skip >= remainingInHead) {
+			skip -= remainingInHead;
+			available -= remainingInHead;
+			releaseHead();
+		}
+		else {
+			startSample += skip;
+			available -= skip;
+			skip = 0;
+		}
+	}
+	pendingSkip += skip;
+}
+
+ADXL362WindowRingBase::const_iterator ADXL362WindowRingBase::begin() const {
+	size_t remaining = (available < windowSize) ? available : windowSize;
+	return const_iterator(this, 0, startSample, remaining);
+}
+
+ADXL362WindowRingBase::const_iterator ADXL362WindowRingBase::end() const {
+	return const_iterator(this, 0, 0, 0);
+}
+
+bool ADXL362WindowRingBase::readSample(size_t index, ADXL362Sample &sample) const {
+	if (index >= windowSize || index >= available) {
+		return false;
+	}
+
+	index += startSample;
+	for(size_t ii = 0; ii < count; ii++) {
+		ADXL362DataBase *data = getBuffer(ii);
+		if (index < data->numSamplesRead) {
+			data->readSample(index, sample);
+			return true;
+		}
+		index -= data->numSamplesRead;
+	}
+	return false;
+}
+
+void ADXL362WindowRingBase::releaseHead() {
+	getBuffer(0)->state = ADXL362DMA::STATE_FREE;
+	head = (head + 1) % maxBuffers;
+	count--;
+	startSample = 0;
+}
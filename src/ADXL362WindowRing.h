@@ -0,0 +1,228 @@
+#ifndef __ADXL362WINDOWRING_H
+#define __ADXL362WINDOWRING_H
+
+// Sliding windows across FIFO buffers for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+
+#include <iterator>
+
+/**
+ * @brief Presents fixed-size, possibly overlapping windows of samples spanning several FIFO buffers
+ *
+ * Windowed analysis (FFT, RMS, step detection) often needs more samples than one FIFO buffer
+ * holds, or windows that overlap. Instead of copying samples into a separate array, completed
+ * buffers are pushed into the ring, and the window is read directly from them, handling each
+ * buffer's startOffset and sample size.
+ *
+ * ```
+ * windowRing.begin(256, 128); // 256 sample window, advance 128 samples (50% overlap)
+ *
+ * // When a FIFO buffer is in STATE_READ_COMPLETE
+ * windowRing.push(&dataBuffer);
+ * while(windowRing.isWindowReady()) {
+ *     for(const ADXL362Sample &sample : windowRing) {
+ *         // Process sample
+ *     }
+ *     windowRing.advance();
+ * }
+ * ```
+ *
+ * advance() moves the window forward by the hop size and sets buffers that are entirely before the
+ * new window back to STATE_FREE. The ring must hold enough buffers to cover windowSize plus one
+ * buffer, since the window rarely starts at the beginning of a buffer.
+ *
+ * You will not allocate one of these directly; use ADXL362WindowRing, which allocates the storage.
+ */
+class ADXL362WindowRingBase {
+public:
+	/**
+	 * @brief Iterates the samples in the current window, in order
+	 *
+	 * Dereferencing decodes the sample from the FIFO buffer, so there is no copy of the window.
+	 */
+	class const_iterator {
+	public:
+		typedef std::input_iterator_tag iterator_category; //!< Single pass
+		typedef ADXL362Sample value_type; //!< Decoded sample
+		typedef ptrdiff_t difference_type; //!< Difference
+		typedef const ADXL362Sample *pointer; //!< Pointer
+		typedef const ADXL362Sample &reference; //!< Reference
+
+		/**
+		 * @brief Returns the current sample
+		 */
+		const ADXL362Sample &operator*() const { return sample; };
+
+		/**
+		 * @brief Access the current sample
+		 */
+		const ADXL362Sample *operator->() const { return &sample; };
+
+		/**
+		 * @brief Move to the next sample, which may be in the next buffer
+		 */
+		const_iterator &operator++();
+
+		/**
+		 * @brief Compare iterators by the number of samples remaining in the window
+		 */
+		bool operator==(const const_iterator &other) const { return remaining == other.remaining; };
+
+		/**
+		 * @brief Compare iterators by the number of samples remaining in the window
+		 */
+		bool operator!=(const const_iterator &other) const { return remaining != other.remaining; };
+
+	protected:
+		/**
+		 * @brief Construct an iterator, used by begin() and end()
+		 */
+		const_iterator(const ADXL362WindowRingBase *ring, size_t bufferIndex, size_t sampleIndex, size_t remaining);
+
+		/**
+		 * @brief Decode the sample at the current position
+		 */
+		void load();
+
+		const ADXL362WindowRingBase *ring; //!< Ring being iterated
+		size_t bufferIndex; //!< Buffer, counted from the oldest buffer in the ring
+		size_t sampleIndex; //!< Sample within the buffer
+		size_t remaining; //!< Samples left in the window, including the current one
+		ADXL362Sample sample; //!< Current sample
+
+		friend class ADXL362WindowRingBase;
+	};
+
+	/**
+	 * @brief Constructor - You will not allocate one of these directly
+	 *
+	 * @param buffers Storage for the buffer pointers
+	 *
+	 * @param maxBuffers Number of entries in buffers
+	 */
+	ADXL362WindowRingBase(ADXL362DataBase **buffers, size_t maxBuffers);
+
+	/**
+	 * @brief Destructor
+	 */
+	virtual ~ADXL362WindowRingBase();
+
+	/**
+	 * @brief Set the window and hop size and empty the ring. Buffers in the ring are not freed.
+	 *
+	 * @param windowSize Number of samples in each window
+	 *
+	 * @param hopSize Number of samples to advance the window. Less than windowSize for overlapping
+	 * windows, equal for back-to-back windows, or more to skip samples between windows.
+	 */
+	void begin(size_t windowSize, size_t hopSize);
+
+	/**
+	 * @brief Add a completed buffer to the ring. Buffers must be pushed in the order they were read.
+	 *
+	 * @param data A buffer in STATE_READ_COMPLETE state
+	 *
+	 * @return false if the ring is full. Call advance() to release buffers first.
+	 */
+	bool push(ADXL362DataBase *data);
+
+	/**
+	 * @brief Returns true if the ring contains at least windowSize samples from the window start
+	 */
+	bool isWindowReady() const { return available >= windowSize; };
+
+	/**
+	 * @brief Move the window forward by the hop size, freeing buffers that are no longer needed
+	 */
+	void advance();
+
+	/**
+	 * @brief Iterator to the first sample in the window
+	 */
+	const_iterator begin() const;
+
+	/**
+	 * @brief Iterator past the last sample in the window
+	 */
+	const_iterator end() const;
+
+	/**
+	 * @brief Read a sample from the window by index
+	 *
+	 * This is convenient but finds the buffer each time; iterating is faster for reading the whole window.
+	 *
+	 * @param index 0 to windowSize - 1
+	 *
+	 * @param sample Filled in with the sample
+	 *
+	 * @return true if the sample is available
+	 */
+	bool readSample(size_t index, ADXL362Sample &sample) const;
+
+	/**
+	 * @brief Returns the number of samples in a window
+	 */
+	size_t getWindowSize() const { return windowSize; };
+
+	/**
+	 * @brief Returns the number of samples available from the start of the window
+	 */
+	size_t getAvailable() const { return available; };
+
+	/**
+	 * @brief Returns the number of buffers in the ring
+	 */
+	size_t getNumBuffers() const { return count; };
+
+	/**
+	 * @brief Returns the sample number of the first sample in the window, counted from begin()
+	 */
+	uint32_t getWindowStart() const { return windowStart; };
+
+protected:
+	/**
+	 * @brief Returns a buffer, counted from the oldest buffer in the ring
+	 */
+	ADXL362DataBase *getBuffer(size_t index) const { return buffers[(head + index) % maxBuffers]; };
+
+	/**
+	 * @brief Free the oldest buffer and remove it from the ring
+	 */
+	void releaseHead();
+
+	ADXL362DataBase **buffers; //!< Buffer pointers
+	size_t maxBuffers; //!< Number of entries in buffers
+	size_t head = 0; //!< Index of the oldest buffer in buffers
+	size_t count = 0; //!< Number of buffers in the ring
+	size_t startSample = 0; //!< Index of the first window sample in the oldest buffer
+	size_t available = 0; //!< Samples from the window start to the end of the newest buffer
+	size_t pendingSkip = 0; //!< Samples to skip in buffers not yet pushed (hop larger than available)
+	size_t windowSize = 0; //!< Samples per window
+	size_t hopSize = 0; //!< Samples to advance
+	uint32_t windowStart = 0; //!< Sample number of the window start
+};
+
+/**
+ * @brief Sliding window ring
+ *
+ * @param MAX_BUFFERS The number of buffers the ring can hold. This must cover the window size plus
+ * one buffer. Each entry is a pointer (4 bytes).
+ */
+template <size_t MAX_BUFFERS>
+class ADXL362WindowRing : public ADXL362WindowRingBase {
+public:
+	/**
+	 * @brief Constructor
+	 */
+	ADXL362WindowRing() : ADXL362WindowRingBase(staticBuffers, MAX_BUFFERS) {};
+
+	/**
+	 * @brief Buffer pointer storage
+	 */
+	ADXL362DataBase *staticBuffers[MAX_BUFFERS];
+};
+
+#endif /* __ADXL362WINDOWRING_H */
@@ -0,0 +1,96 @@
+#include "Particle.h"
+
+#include "ADXL362Worker.h"
+
+// Worker thread for processing FIFO buffers for the ADXL362DMA library
+// https://github.com/rickkas7/ADXL362DMA
+
+#if PLATFORM_THREADING
+
+ADXL362Worker::ADXL362Worker(ADXL362DMA &accel) : accel(accel) {
+}
+
+ADXL362Worker::~ADXL362Worker() {
+	accel.setCompletionCallback(nullptr);
+}
+
+bool ADXL362Worker::start(Handler handler, size_t queueDepth, os_thread_prio_t priority, size_t stackSize) {
+	if (queue) {
+		// Already started
+		return false;
+	}
+	this->handler = handler;
+	queueDepthLimit = (queueDepth > 0) ? queueDepth : 1;
+
+	if (os_queue_create(&queue, sizeof(QueueItem), queueDepthLimit, nullptr)) {
+		queue = nullptr;
+		Log.error("could not create worker queue");
+		return false;
+	}
+
+	if (os_thread_create(&thread, "adxl362", priority, threadFunctionStatic, this, stackSize)) {
+		os_queue_destroy(queue, nullptr);
+		queue = nullptr;
+		thread = nullptr;
+		Log.error("could not create worker thread");
+		return false;
+	}
+
+	accel.setCompletionCallback(completionCallback, this);
+	return true;
+}
+
+// [static]
+void ADXL362Worker::completionCallback(ADXL362DataBase *data, void *context) {
+	ADXL362Worker *worker = (ADXL362Worker *)context;
+
+	QueueItem item;
+	item.data = data;
+	item.completedMicros = micros();
+
+	if (os_queue_put(worker->queue, &item, 0, nullptr)) {
+		// Queue full
+		worker->droppedCount++;
+		data->state = ADXL362DMA::STATE_FREE;
+		return;
+	}
+	worker->enqueuedCount++;
+
+	size_t depth = worker->enqueuedCount - worker->dequeuedCount;
+	if (depth > worker->maxQueueDepth) {
+		worker->maxQueueDepth = depth;
+	}
+}
+
+// [static]
+void ADXL362Worker::threadFunctionStatic(void *param) {
+	((ADXL362Worker *)param)->threadFunction();
+}
+
+void ADXL362Worker::threadFunction() {
+	while(true) {
+		QueueItem item;
+		if (os_queue_take(queue, &item, CONCURRENT_WAIT_FOREVER, nullptr)) {
+			continue;
+		}
+		dequeuedCount++;
+
+		uint32_t start = micros();
+		lagMicros = start - item.completedMicros;
+		if (lagMicros > maxLagMicros) {
+			maxLagMicros = lagMicros;
+		}
+
+		bool freeBuffer = true;
+		if (handler) {
+			freeBuffer = handler(item.data);
+		}
+		if (freeBuffer) {
+			item.data->state = ADXL362DMA::STATE_FREE;
+		}
+
+		processMicros = micros() - start;
+	}
+}
+
+#endif /* PLATFORM_THREADING */
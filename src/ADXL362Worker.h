@@ -0,0 +1,152 @@
+#ifndef __ADXL362WORKER_H
+#define __ADXL362WORKER_H
+
+// Worker thread for processing FIFO buffers for the ADXL362DMA library
+// Github: https://github.com/rickkas7/ADXL362DMA
+// License: MIT
+
+#include "ADXL362DMA.h"
+
+#include <functional>
+
+#if PLATFORM_THREADING
+
+/**
+ * @brief Processes completed FIFO buffers on a dedicated thread
+ *
+ * Without this, buffers are decoded and processed from loop(), along with networking, so a slow
+ * network operation delays processing and heavy processing delays networking. With a worker:
+ *
+ * - The SPI DMA completion only finishes the transaction, realigns the buffer (which carries at most
+ *   one partial sample over to the next read), and puts a pointer to it in a bounded queue.
+ * - The worker thread takes buffers from the queue in order and calls your handler, which decodes
+ *   and processes the samples.
+ * - loop() only needs to start reads and send results.
+ *
+ * If the queue is full when a buffer completes, the buffer is dropped (set back to STATE_FREE)
+ * and counted in getDroppedCount(). Size the queue for the longest processing delay you expect.
+ *
+ * Only one worker can be attached to an ADXL362DMA object. Requires SYSTEM_THREAD(ENABLED).
+ */
+class ADXL362Worker {
+public:
+	/**
+	 * @brief Handler called on the worker thread for each completed buffer
+	 *
+	 * Return true to have the worker set the buffer back to STATE_FREE, or false if the handler has
+	 * taken ownership of the buffer (for example, by publishing it to an ADXL362FanOut).
+	 */
+	typedef std::function<bool(ADXL362DataBase *data)> Handler;
+
+	/**
+	 * @brief Constructor
+	 *
+	 * @param accel The accelerometer whose completed reads should be processed
+	 */
+	ADXL362Worker(ADXL362DMA &accel);
+
+	/**
+	 * @brief Destructor. A worker normally lives for the life of the program and is not deleted.
+	 */
+	virtual ~ADXL362Worker();
+
+	/**
+	 * @brief Create the queue and thread and attach to the accelerometer. Call from setup().
+	 *
+	 * @param handler Called on the worker thread for each completed buffer
+	 *
+	 * @param queueDepth Maximum number of buffers waiting to be processed (default: 8)
+	 *
+	 * @param priority Thread priority (default: OS_THREAD_PRIORITY_DEFAULT)
+	 *
+	 * @param stackSize Thread stack size in bytes (default: 3072)
+	 *
+	 * @return true if the queue and thread were created
+	 */
+	bool start(Handler handler, size_t queueDepth = 8, os_thread_prio_t priority = OS_THREAD_PRIORITY_DEFAULT, size_t stackSize = 3072);
+
+	/**
+	 * @brief Number of buffers in the queue, not including the one being processed
+	 */
+	size_t getQueueDepth() const { return (size_t)(enqueuedCount - dequeuedCount); };
+
+	/**
+	 * @brief Largest queue depth seen since start() or resetStats()
+	 */
+	size_t getMaxQueueDepth() const { return maxQueueDepth; };
+
+	/**
+	 * @brief Microseconds between the most recent buffer completing and the worker starting to process it
+	 *
+	 * This is how far processing is running behind the data, in addition to the time the samples
+	 * spent in the FIFO.
+	 */
+	uint32_t getLagMicros() const { return lagMicros; };
+
+	/**
+	 * @brief Largest getLagMicros() since start() or resetStats()
+	 */
+	uint32_t getMaxLagMicros() const { return maxLagMicros; };
+
+	/**
+	 * @brief Microseconds the handler took for the most recent buffer
+	 */
+	uint32_t getProcessMicros() const { return processMicros; };
+
+	/**
+	 * @brief Number of buffers processed
+	 */
+	uint32_t getProcessedCount() const { return dequeuedCount; };
+
+	/**
+	 * @brief Number of buffers dropped because the queue was full
+	 */
+	uint32_t getDroppedCount() const { return droppedCount; };
+
+	/**
+	 * @brief Clear the maximum depth and lag
+	 */
+	void resetStats() { maxQueueDepth = 0; maxLagMicros = 0; };
+
+protected:
+	/**
+	 * @brief Queue entry
+	 */
+	struct QueueItem {
+		ADXL362DataBase *data;		//!< Completed buffer
+		uint32_t completedMicros;	//!< micros() when the read completed
+	};
+
+	/**
+	 * @brief Completion callback from the driver, puts the buffer in the queue
+	 */
+	static void completionCallback(ADXL362DataBase *data, void *context);
+
+	/**
+	 * @brief Thread function
+	 */
+	static void threadFunctionStatic(void *param);
+
+	/**
+	 * @brief Takes buffers from the queue and calls the handler, never returns
+	 */
+	void threadFunction();
+
+	ADXL362DMA &accel; //!< Accelerometer
+	Handler handler = nullptr; //!< Handler function
+	os_queue_t queue = nullptr; //!< Completed buffers
+	os_thread_t thread = nullptr; //!< Worker thread
+	size_t queueDepthLimit = 0; //!< Queue size
+
+	volatile uint32_t enqueuedCount = 0; //!< Buffers put in the queue (completion callback only)
+	volatile uint32_t dequeuedCount = 0; //!< Buffers taken from the queue (worker thread only)
+	volatile uint32_t droppedCount = 0; //!< Buffers dropped because the queue was full
+	volatile size_t maxQueueDepth = 0; //!< Largest queue depth
+	volatile uint32_t lagMicros = 0; //!< Most recent completion to processing delay
+	volatile uint32_t maxLagMicros = 0; //!< Largest completion to processing delay
+	volatile uint32_t processMicros = 0; //!< Most recent handler time
+};
+
+#endif /* PLATFORM_THREADING */
+
+#endif /* __ADXL362WORKER_H */
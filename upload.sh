@@ -1,7 +1,7 @@
 #!/bin/bash
 
 TEMPDIR="../ADXL362DMA-Temp"
-DIRS=("docs")
+DIRS=("docs" "host")
 
 mkdir $TEMPDIR || set status 0
 